@@ -24,12 +24,27 @@
 #include "vp/vp_data.hpp"
 #include "vp/component.hpp"
 #include "vp/time/time_engine.hpp"
+#include <new>
 
 namespace vp {
 
   class clock_event;
   class component;
 
+  // Upper level of the timing wheel. Each slot contains the events
+  // whose cycle, shifted by the level shift, is equal to the slot index.
+  // The slot is cascaded to the lower levels when the engine cycle reaches
+  // the beginning of the slot.
+  typedef struct
+  {
+    clock_event **slots;
+    int shift;
+    int64_t mask;
+    int nb_events;
+    // Bit i is set when slot i is not empty
+    uint64_t bitmap;
+  } clock_wheel_level_t;
+
   class clock_engine : public time_engine_client
   {
 
@@ -47,6 +62,13 @@ namespace vp {
     
     inline clock_event *reenqueue(clock_event *event, int64_t cycles);
 
+    // Can be called from an event handler to advance the engine by the
+    // specified number of cycles in place, instead of enqueueing an event,
+    // so that what would have been executed by this event is executed
+    // directly. This is only possible if nothing else is due before, in this
+    // engine or in other engines. Returns true if the engine has advanced.
+    inline bool try_advance(int64_t cycles);
+
     inline clock_event *enqueue(clock_event *event, int64_t cycles)
     {
       vp_assert(!event->enqueued, 0, "Enqueueing already enqueued event\n");
@@ -68,13 +90,13 @@ namespace vp {
 
     clock_event *event_new(component_clock *comp, clock_event_meth_t *meth)
     {
-      clock_event *event = new clock_event(comp, meth);
+      clock_event *event = new (event_alloc()) clock_event(comp, meth);
       return event;
     }
 
     clock_event *event_new(component_clock *comp, void *_this, clock_event_meth_t *meth)
     {
-      clock_event *event = new clock_event(comp, _this, meth);
+      clock_event *event = new (event_alloc()) clock_event(comp, _this, meth);
       return event;
     }
 
@@ -85,7 +107,8 @@ namespace vp {
 
     void event_del(component_clock *comp, clock_event *event)
     {
-      delete event;
+      event->~clock_event();
+      event_free(event);
     }
 
     int64_t exec();
@@ -106,19 +129,100 @@ namespace vp {
 
     int64_t get_frequency() { return freq; }
 
-    bool has_events() { return this->nb_enqueued_to_cycle || this->delayed_queue; }
+    bool has_events() { return this->nb_enqueued_to_cycle || this->nb_enqueued_to_wheel; }
 
   protected:
 
-    void flush_delayed_queue();
+    // Events are taken from slabs of events aligned on cache lines, and
+    // freed events are kept in a list, linked through their first word, to
+    // be reused.
+    inline void *event_alloc()
+    {
+      if (unlikely(free_events == NULL))
+        event_slab_alloc();
+
+      void *event = free_events;
+      free_events = *(void **)event;
+      return event;
+    }
+
+    inline void event_free(void *event)
+    {
+      *(void **)event = free_events;
+      free_events = event;
+    }
+
+    void event_slab_alloc();
+
+    // Returns -1 and fills vp_error if the configuration is invalid
+    int wheel_init(std::vector<int> level_bits);
+
+    void wheel_enqueue(clock_event *event, int64_t cycle);
+
+    void wheel_cascade_slot(int level, int64_t cycle);
+
+    void wheel_cascade_overflow();
+
+    void wheel_cascade();
+
+    void wheel_find_next();
+
+    void cancel_from_wheel(clock_event *event);
+
+    // Gives the cycle of the first event of the upper levels of the wheel,
+    // which is only searched again after this event left them.
+    inline int64_t wheel_get_next_cycle()
+    {
+      if (unlikely(this->wheel_next_dirty))
+      {
+        this->wheel_next_dirty = false;
+        this->wheel_find_next();
+      }
+      return this->wheel_next_cycle;
+    }
+
+    // Called when an event left the upper levels of the wheel, either to the
+    // circular buffer or because it was canceled.
+    inline void wheel_check_next(clock_event *event)
+    {
+      if (event == this->wheel_next_event)
+      {
+        if (this->nb_enqueued_to_wheel == 0)
+        {
+          this->wheel_next_cycle = INT64_MAX;
+          this->wheel_next_event = NULL;
+        }
+        else
+        {
+          this->wheel_next_dirty = true;
+        }
+      }
+    }
+
+    inline void list_push(clock_event **list, clock_event *event)
+    {
+      event->next = *list;
+      if (event->next)
+        event->next->pprev = &event->next;
+      event->pprev = list;
+      *list = event;
+    }
+
+    inline void list_remove(clock_event *event)
+    {
+      *event->pprev = event->next;
+      if (event->next)
+        event->next->pprev = event->pprev;
+    }
 
     inline void enqueue_to_cycle(clock_event *event, int64_t cycles)
     {
       // The position of one round of the circular buffer is always aligned
       // on the buffer size.
       int cycle = (current_cycle + cycles) & CLOCK_EVENT_QUEUE_MASK;
-      event->next = event_queue[cycle];
-      event_queue[cycle] = event;
+      list_push(&event_queue[cycle], event);
+      event_queue_bitmap |= 1ULL << cycle;
+      event->level = 0;
       nb_enqueued_to_cycle++;
       event->cycle = cycles + get_cycles();
     }
@@ -126,8 +230,31 @@ namespace vp {
     clock_event *enqueue_other(clock_event *event, int64_t cycles);
 
     clock_event *event_queue[CLOCK_EVENT_QUEUE_SIZE];
-    clock_event *delayed_queue = NULL;
     int current_cycle = 0;
+
+    // List of free events
+    void *free_events = NULL;
+
+    // Bit i is set when the slot i of the circular buffer is not empty
+    uint64_t event_queue_bitmap = 0;
+
+    // Upper levels of the timing wheel, for events which do not fit the
+    // circular buffer.
+    clock_wheel_level_t wheel_levels[CLOCK_WHEEL_MAX_LEVELS];
+    int nb_wheel_levels = 0;
+
+    // Events which do not even fit the last level of the wheel. This is only
+    // walked when the last level wraps.
+    clock_event *overflow_queue = NULL;
+
+    // Number of events in the upper levels and in the overflow queue.
+    int nb_enqueued_to_wheel = 0;
+
+    // First event of the upper levels and of the overflow queue, and its
+    // cycle. When it leaves them, it is searched again on the next request.
+    clock_event *wheel_next_event = NULL;
+    int64_t wheel_next_cycle = INT64_MAX;
+    bool wheel_next_dirty = false;
     int64_t period = 0;
     int64_t freq;
 
@@ -138,7 +265,8 @@ namespace vp {
     int64_t cycles = 0;
 
     // Tells how many events are enqueued to the circular buffer.
-    // If it is zero, there could still be some events in the delayed queue.
+    // If it is zero, there could still be some events in the upper levels of
+    // the wheel.
     int nb_enqueued_to_cycle = 0;
 
     // This time is relevant only when no event is enqueued into the circular
@@ -149,7 +277,18 @@ namespace vp {
     // external event.
     int64_t stop_time = 0;
 
-    bool must_flush_delayed_queue;
+    // Set when the circular buffer wraps, or when the engine gives back
+    // control to the time engine, so that the upper levels of the wheel are
+    // cascaded before the next events are executed.
+    bool must_cascade;
+
+    // Set when the engine gave back control to the time engine because the
+    // circular buffer was empty, or before it is started. The cycle count must
+    // then jump to the next event.
+    bool must_resync = true;
+
+    // First cycle of the events enqueued while must_resync is set
+    int64_t resync_cycle = INT64_MAX;
 
     vp::trace cycles_trace;
   };    
@@ -157,6 +296,44 @@ namespace vp {
 };
 
 
+inline bool vp::clock_engine::try_advance(int64_t cycles)
+{
+  vp_assert(this->is_running(), NULL, "Advancing clock engine while it is not running\n");
+
+  // The events which are due before the target cycle must all be in the
+  // circular buffer. This is the case if the buffer does not wrap, as events
+  // of upper levels are at least one round away, otherwise the upper levels
+  // must be empty. There must also be no remaining event in the current
+  // cycle.
+  int target = this->current_cycle + cycles;
+
+  if (cycles >= CLOCK_EVENT_QUEUE_SIZE || this->period == 0 ||
+    (target >= CLOCK_EVENT_QUEUE_SIZE && this->nb_enqueued_to_wheel) ||
+    this->event_queue[this->current_cycle] != NULL)
+  {
+    return false;
+  }
+
+  // Check the slots from the next cycle to the target one, the bitmap is
+  // duplicated to handle the wrap.
+  uint64_t bitmap = this->event_queue_bitmap | (this->event_queue_bitmap << CLOCK_EVENT_QUEUE_SIZE);
+  if (bitmap & (((1ULL << cycles) - 1) << (this->current_cycle + 1)))
+    return false;
+
+  int64_t time = this->get_time() + cycles * this->period;
+  if (!this->engine->can_advance(time))
+    return false;
+
+  this->event_queue_bitmap &= ~(1ULL << this->current_cycle);
+  this->cycles += cycles;
+  this->current_cycle = target & CLOCK_EVENT_QUEUE_MASK;
+  this->engine->update(time);
+
+  this->cycles_trace.event_real(this->cycles);
+
+  return true;
+}
+
 inline vp::clock_event *vp::clock_engine::reenqueue(vp::clock_event *event, int64_t enqueue_cycles)
 {
   int64_t cycles = this->cycles + enqueue_cycles;
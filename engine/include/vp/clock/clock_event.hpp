@@ -31,11 +31,39 @@ namespace vp {
 
   #define CLOCK_EVENT_PAYLOAD_SIZE 64
   #define CLOCK_EVENT_NB_ARGS 8
-  #define CLOCK_EVENT_QUEUE_SIZE 32
+  #define CLOCK_EVENT_QUEUE_BITS 5
+  #define CLOCK_EVENT_QUEUE_SIZE (1 << CLOCK_EVENT_QUEUE_BITS)
   #define CLOCK_EVENT_QUEUE_MASK (CLOCK_EVENT_QUEUE_SIZE - 1)
 
+  // The circular buffer is the first level of a timing wheel. The upper
+  // levels can be configured from the clock domain with wheel_level_bits,
+  // this gives the default.
+  #define CLOCK_WHEEL_MAX_LEVELS 8
+  #define CLOCK_WHEEL_DEFAULT_NB_LEVELS 3
+  #define CLOCK_WHEEL_DEFAULT_LEVEL_BITS 6
+
+  // Each level has an occupancy bitmap held in a single 64 bits word, which
+  // limits the number of slots per level.
+  #define CLOCK_WHEEL_MAX_LEVEL_BITS 6
+
+  // Level recorded in an event enqueued to the overflow queue, the other
+  // values are 0 for the circular buffer and the wheel level index plus one.
+  #define CLOCK_EVENT_LEVEL_OVERFLOW -1
+
+  // Events are allocated by the clock engine in slabs of this number of
+  // events.
+  #define CLOCK_EVENT_SLAB_SIZE 256
+
   typedef void (clock_event_meth_t)(void *, clock_event *event);
 
+  // Storage for the payload and the arguments of an event. As most events
+  // do not use them, it is only allocated the first time it is accessed.
+  typedef struct
+  {
+    uint8_t payload[CLOCK_EVENT_PAYLOAD_SIZE];
+    void *args[CLOCK_EVENT_NB_ARGS];
+  } clock_event_data_t;
+
   class clock_event
   {
 
@@ -46,27 +74,45 @@ namespace vp {
     clock_event(component_clock *comp, clock_event_meth_t *meth);
 
     clock_event(component_clock *comp, void *_this, clock_event_meth_t *meth) 
-      : comp(comp), _this(_this), meth(meth), enqueued(false) {}
+      : meth(meth), _this(_this), enqueued(false), comp(comp), data(NULL) {}
+
+    ~clock_event() { delete data; }
 
     inline int get_payload_size() { return CLOCK_EVENT_PAYLOAD_SIZE; }
-    inline uint8_t *get_payload() { return payload; }
+    inline uint8_t *get_payload() { return get_data()->payload; }
 
     inline int get_nb_args() { return CLOCK_EVENT_NB_ARGS; }
-    inline void **get_args() { return args; }
+    inline void **get_args() { return get_data()->args; }
 
     inline bool is_enqueued() { return enqueued; }
 
     int64_t get_cycle() { return cycle; }
 
   private:
-    uint8_t payload[CLOCK_EVENT_PAYLOAD_SIZE];
-    void *args[CLOCK_EVENT_NB_ARGS];
-    component_clock *comp;
-    void *_this;
+    inline clock_event_data_t *get_data()
+    {
+      if (data == NULL)
+        data = new clock_event_data_t();
+      return data;
+    }
+
+    // The fields used by the clock engine to enqueue and execute events come
+    // first so that they are in the same cache line, as events are allocated
+    // aligned on cache lines.
     clock_event_meth_t *meth;
+    void *_this;
     clock_event *next;
-    bool enqueued;
     int64_t cycle;
+    // Pointer to the pointer to this event, which is either the slot head or
+    // the next field of the previous event, so that the event can be removed
+    // from its slot without walking it.
+    clock_event **pprev;
+    bool enqueued;
+    // Level of the wheel where the event is enqueued
+    int level;
+
+    component_clock *comp;
+    clock_event_data_t *data;
   };    
 
 };
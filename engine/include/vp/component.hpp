@@ -318,6 +318,10 @@ namespace vp {
 
     string get_path() { return path; }
 
+    // Tells if the platform is simulated in functional mode, where only the
+    // results of the execution matter and components don't model timing.
+    inline bool get_functional() { return functional; }
+
 
     void conf(string path, vp::component *parent);
 
@@ -399,6 +403,8 @@ namespace vp {
     bool reset_done_from_itf;
 
     time_engine *time_engine_ptr = NULL;
+
+    bool functional = false;
   };
 
 };  
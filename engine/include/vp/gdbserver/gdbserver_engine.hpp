@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __VP_GDBSERVER_GDBSERVER_ENGINE_HPP__
+#define __VP_GDBSERVER_GDBSERVER_ENGINE_HPP__
+
+#include <stdint.h>
+#include <string>
+
+namespace vp {
+
+  // Interface of a core which can be debugged through the GDB server. The
+  // server calls it from its own thread with the time engine locked, so the
+  // core does not need any synchronization.
+  // Registers are numbered like GDB does, i.e. with the PC after the
+  // general purpose registers. All methods returning an int return 0 on
+  // success.
+  class gdbserver_core
+  {
+  public:
+    virtual int gdbserver_get_id() = 0;
+    virtual std::string gdbserver_get_name() = 0;
+    virtual int gdbserver_get_nb_regs() = 0;
+    virtual int gdbserver_get_reg_size() = 0;
+    virtual int gdbserver_reg_get(int reg, uint8_t *value) = 0;
+    virtual int gdbserver_reg_set(int reg, uint8_t *value) = 0;
+    virtual int gdbserver_mem_access(uint64_t addr, int size, uint8_t *data, bool is_write) = 0;
+    virtual int gdbserver_stop() = 0;
+    virtual int gdbserver_cont() = 0;
+    virtual int gdbserver_stepi() = 0;
+    virtual bool gdbserver_is_halted() = 0;
+    virtual int gdbserver_breakpoint_insert(uint64_t addr) = 0;
+    virtual int gdbserver_breakpoint_remove(uint64_t addr) = 0;
+  };
+
+  // Service published by the GDB server under the name "gdbserver"
+  class gdbserver_engine
+  {
+  public:
+    virtual int register_core(gdbserver_core *core) = 0;
+
+    // Called by a core from the engine thread when it halted by itself,
+    // i.e. on a breakpoint or after a step
+    virtual void signal(gdbserver_core *core) = 0;
+  };
+
+};
+
+#endif
@@ -22,11 +22,17 @@
 #define __VP_ITF_IO_HPP__
 
 #include "vp/vp.hpp"
+#include <vector>
 
 namespace vp {
 
   class io_slave;
   class io_req;
+  class io_dmi;
+  class io_dmi_watch;
+
+  // Size of the pages watched for writes in memories granted through DMI
+  #define IO_DMI_WATCH_PAGE_BITS 9
 
   typedef enum
   {
@@ -50,13 +56,151 @@ namespace vp {
   typedef void (io_resp_meth_t)(void *, io_req *);
   typedef void (io_grant_meth_t)(void *, io_req *);
 
+  typedef bool (io_dmi_meth_t)(void *, io_dmi *, uint64_t addr);
+  typedef void (io_dmi_invalidate_meth_t)(void *);
+  typedef void (io_dmi_write_meth_t)(void *, uint64_t addr, uint64_t size);
+
+
+  /*
+   * Direct memory interface (DMI)
+   *
+   * A slave can grant to a master a direct access to a range of its memory,
+   * so that the master can read and write it through a host pointer instead
+   * of sending IO requests. Each access to the range has a fixed latency.
+   * The access must not be used anymore once the slave has invalidated it.
+   *
+   * The slave can also attach a watch to the range, so that masters caching
+   * information about the content of the memory (e.g. decoded instructions)
+   * are notified when it is written, either through a direct access or
+   * through an IO request.
+   */
+  class io_dmi
+  {
+  public:
+
+    // Tell if the access to the specified range is granted.
+    inline bool contains(uint64_t addr, uint64_t size)
+    {
+      return addr >= this->base && addr - this->base + size <= this->size;
+    }
+
+    // Return the host pointer corresponding to the specified address.
+    inline uint8_t *get_ptr(uint64_t addr) { return this->data + (addr - this->base); }
+
+    // Revoke the access so that the next accesses go through IO requests.
+    inline void invalidate() { this->size = 0; }
+
+    // Set the callback called when a watched part of the range is written.
+    inline void set_write_meth(io_dmi_write_meth_t *meth, void *context)
+    {
+      this->write_meth = meth;
+      this->write_context = context;
+    }
+
+    // Ask to be notified of the next writes to the page containing the
+    // specified address. Does nothing if the slave did not attach a watch.
+    inline void watch(uint64_t addr);
+
+    // Must be called by the master after writing through the direct access,
+    // to notify the masters watching the range.
+    inline void write_notify(uint64_t addr, uint64_t size);
+
+    // Address of the first byte of the range
+    uint64_t base = 0;
+
+    // Size of the range, 0 if no access is granted
+    uint64_t size = 0;
+
+    // Host pointer to the first byte of the range
+    uint8_t *data = NULL;
+
+    // Latency in cycles of each access to the range
+    int64_t latency = 0;
+
+    // Watch attached by the slave, NULL if writes can not be watched
+    io_dmi_watch *watch_desc = NULL;
+
+    // Write callback, called with the address in the master address space
+    io_dmi_write_meth_t *write_meth = NULL;
+    void *write_context = NULL;
+  };
+
+
+  /*
+   * Write watch on a memory granted through DMI
+   *
+   * It is owned by the slave and attached to all the ranges it grants. Pages
+   * are watched by the masters which ask for it, and a write to a watched
+   * page notifies all of them, after which the page is not watched anymore
+   * until a master asks again.
+   */
+  class io_dmi_watch
+  {
+  public:
+
+    io_dmi_watch(uint8_t *data, uint64_t size) : data(data), size(size) {}
+
+    ~io_dmi_watch() { delete[] this->pages; }
+
+    // Tell if the specified range contains a watched page
+    inline bool is_watched(uint8_t *ptr, uint64_t size)
+    {
+      if (this->pages == NULL) return false;
+      uint64_t first = (ptr - this->data) >> IO_DMI_WATCH_PAGE_BITS;
+      uint64_t last = (ptr - this->data + size - 1) >> IO_DMI_WATCH_PAGE_BITS;
+      for (uint64_t page=first; page<=last; page++)
+      {
+        if (this->pages[page]) return true;
+      }
+      return false;
+    }
+
+    // Watch the page containing the host pointer on behalf of the specified
+    // master range.
+    void watch(io_dmi *dmi, uint8_t *ptr);
+
+    // Notify all masters watching a page of the range that it is written.
+    void notify(uint8_t *ptr, uint64_t size);
+
+    // Must be called when the slave revokes the ranges it granted. The
+    // masters may then get new ranges and watch their pages again, so the
+    // watchers are removed. As the masters may still cache content of their
+    // previous ranges, they are notified that these ranges are fully written.
+    void invalidate();
+
+    // Can be called by the slave after a write done through an IO request
+    inline void write(uint8_t *ptr, uint64_t size)
+    {
+      if (this->is_watched(ptr, size)) this->notify(ptr, size);
+    }
+
+    // Number of writes which were notified
+    int64_t nb_notify = 0;
+
+  private:
+
+    typedef struct
+    {
+      io_dmi *dmi;
+      uint64_t base;
+      uint8_t *data;
+      uint64_t size;
+    } watcher_t;
+
+    uint8_t *data;
+    uint64_t size;
+    uint8_t *pages = NULL;
+    std::vector<watcher_t> watchers;
+  };
+
+
   class io_req
   {
     friend class io_master;
     friend class io_slave;
 
   public:
-    io_req() {}
+    io_req() { prepare(); }
 
     io_req(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
     : addr(addr), data(data), size(size), is_write(is_write)
@@ -160,8 +304,28 @@ namespace vp {
     inline io_req *req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write);
 
     // Can be called to deallocate an IO request.
+    // The request is kept in a pool of free requests to be reused by the
+    // next allocations.
     inline void req_del(io_req *req);
 
+    // Can be called to allocate requests in advance into the pool.
+    void req_pool_alloc(int nb_reqs);
+
+    // Can be called by master component to get a direct access to the range
+    // of memory containing the specified address. Returns false if the slave
+    // does not grant any access, in which case dmi is left unchanged.
+    inline bool dmi_req(uint64_t addr, io_dmi *dmi);
+
+    // Same as dmi_req but the slave port is specified by the caller.
+    inline bool dmi_req(uint64_t addr, io_dmi *dmi, io_slave *port);
+
+    // Return the number of requests allocated through this port.
+    inline int64_t get_nb_req_new() { return this->nb_req_new; }
+
+    // Return the number of requests allocated through this port which were
+    // taken from the pool and did not need a new allocation.
+    inline int64_t get_nb_req_pool_hit() { return this->nb_req_pool_hit; }
+
     // Return if this master port is bound.
     bool is_bound();
 
@@ -193,6 +357,11 @@ namespace vp {
     // an IO request response. Before being set, a default empty callback is active.
     inline void set_resp_meth(io_resp_meth_t *meth);
 
+    // Set the callback on master side called when the slave is invalidating
+    // the direct accesses it granted. Before being set, a default empty
+    // callback is active.
+    inline void set_dmi_invalidate_meth(io_dmi_invalidate_meth_t *meth);
+
 
 
     /*
@@ -233,6 +402,12 @@ namespace vp {
     // Default response callback, just do nothing.
     static inline void resp_default(void *, io_req *);
 
+    // DMI invalidation callback set by the user.
+    void (*dmi_invalidate_meth)(void *context);
+
+    // Default DMI invalidation callback, just do nothing.
+    static inline void dmi_invalidate_default(void *);
+
 
     /*
      * Slave callbacks
@@ -248,6 +423,11 @@ namespace vp {
     // setup instead
     io_req_status_e (*req_meth_freq_cross)(void *, io_req *);
 
+    // DMI callback set by the user on slave port and retrieved during binding,
+    // with the associated slave context, as no stub is needed for DMI.
+    bool (*dmi_meth)(void *, io_dmi *, uint64_t);
+    void *dmi_context = NULL;
+
 
     /*
      * Stubs
@@ -286,6 +466,15 @@ namespace vp {
     int slave_req_mux_id = -1;
 
 
+    // Pool of free requests, linked through their next field.
+    io_req *free_reqs = NULL;
+
+    // Number of requests allocated through req_new, and number of them which
+    // were found in the pool.
+    int64_t nb_req_new = 0;
+    int64_t nb_req_pool_hit = 0;
+
+
     // Several IO master ports are often connected to the same slave port
     // while the slave will need to reply to the master.
     // For that, a slave port is associated to each master port and can
@@ -322,6 +511,11 @@ namespace vp {
     // owned back by the master which can then proceed with the request.
     inline void resp(io_req *req) { this->master_resp_meth(this->get_remote_context(), req); }
 
+    // Can be called to invalidate all direct accesses granted through this
+    // port. All the master ports bound to it are notified, as well as the
+    // masters watching writes through the watch of the port, if any.
+    inline void dmi_invalidate();
+
 
 
     /*
@@ -337,6 +531,15 @@ namespace vp {
     // when calling the callback, and can be used to multiplex a slave port
     inline void set_req_meth_muxed(io_req_meth_muxed_t *meth, int id);
 
+    // Set the callback on slave side called when the master is asking for
+    // a direct access to the memory. Before being set, a default callback
+    // refusing any access is active.
+    inline void set_dmi_meth(io_dmi_meth_t *meth);
+
+    // Set the watch attached by the slave to the ranges it grants, which is
+    // invalidated together with them.
+    inline void set_dmi_watch(io_dmi_watch *watch);
+
 
 
     /*
@@ -372,6 +575,13 @@ namespace vp {
     // This one gets called instead of the normal once in case it is not NULL
     io_req_status_e (*req_meth_mux)(void *context, io_req *, int mux);
 
+    // DMI callback set by the user.
+    // This gets called anytime the master is asking for a direct access.
+    bool (*dmi_meth)(void *context, io_dmi *dmi, uint64_t addr);
+
+    // Default DMI callback, refuse any access.
+    static inline bool dmi_default(void *, io_dmi *, uint64_t);
+
 
 
     /*
@@ -418,6 +628,12 @@ namespace vp {
     // Multiplexed ID set by the slave when port is multiplxed
     int req_mux_id;
 
+    // Master ports bound to this port, notified when DMI is invalidated
+    std::vector<io_master *> dmi_masters;
+
+    // Watch attached to the granted ranges, NULL if writes are not watched
+    io_dmi_watch *dmi_watch = NULL;
+
 
     // Master context when the binding is crossing frequency domains.
     // We keep here a copy of the master context when the binding is crossing frequency
@@ -433,6 +649,8 @@ namespace vp {
     // Set default callbacks in case the user does not set them
     this->resp_meth = &io_master::resp_default;
     this->grant_meth = &io_master::grant_default;
+    this->dmi_invalidate_meth = &io_master::dmi_invalidate_default;
+    this->dmi_meth = &io_slave::dmi_default;
   }
 
 
@@ -467,19 +685,64 @@ namespace vp {
 
 
 
+  inline bool io_master::dmi_req(uint64_t addr, io_dmi *dmi)
+  {
+    // The slave fills a copy so that the access already granted to the
+    // caller, and its watch, are kept if the new one is refused
+    io_dmi granted = *dmi;
+    granted.watch_desc = NULL;
+    if (!this->dmi_meth(this->dmi_context, &granted, addr))
+      return false;
+    *dmi = granted;
+    return true;
+  }
+
+
+
+  inline bool io_master::dmi_req(uint64_t addr, io_dmi *dmi, io_slave *port)
+  {
+    io_dmi granted = *dmi;
+    granted.watch_desc = NULL;
+    if (!port->dmi_meth(port->get_context(), &granted, addr))
+      return false;
+    *dmi = granted;
+    return true;
+  }
+
+
+
   inline io_req *io_master::req_new(uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
   {
-    // For now we allocate new requests but this would be better to manage a pool of requests
-    io_req *req = new io_req(addr, data, size, is_write);
+    io_req *req = this->free_reqs;
+
+    this->nb_req_new++;
+
+    if (likely(req != NULL))
+    {
+      this->free_reqs = req->next;
+      this->nb_req_pool_hit++;
+      return new (req) io_req(addr, data, size, is_write);
+    }
 
-    return req;
+    return new io_req(addr, data, size, is_write);
   }
 
 
 
   inline void io_master::req_del(io_req *req)
   {
-    delete req;
+    req->next = this->free_reqs;
+    this->free_reqs = req;
+  }
+
+
+
+  inline void io_master::req_pool_alloc(int nb_reqs)
+  {
+    for (int i=0; i<nb_reqs; i++)
+    {
+      this->req_del(new io_req());
+    }
   }
 
 
@@ -498,12 +761,25 @@ namespace vp {
 
 
 
+  inline void io_master::set_dmi_invalidate_meth(io_dmi_invalidate_meth_t *meth)
+  {
+    dmi_invalidate_meth = meth;
+  }
+
+
+
   inline void io_master::resp_default(void *, io_req *)
   {
   }
 
 
 
+  inline void io_master::dmi_invalidate_default(void *)
+  {
+  }
+
+
+
   inline void io_master::grant_default(void *, io_req *)
   {
   }
@@ -524,6 +800,8 @@ namespace vp {
       // port for fast access
       this->req_meth = port->req_meth;
       this->set_remote_context(port->get_context());
+      this->dmi_meth = port->dmi_meth;
+      this->dmi_context = port->get_context();
     }
     else
     {
@@ -581,6 +859,15 @@ namespace vp {
     vp_assert(this->remote_port->get_owner()->get_clock() != NULL, this->get_comp()->get_trace(),
       "No remote port owner clock found when finalizing master binding\n");
 
+    // The pool of requests of each master port can be sized from the
+    // configuration of the component owning it, to avoid allocations during
+    // the simulation.
+    js::config *pool_size = this->get_owner()->get_js_config()->get("io_req_pool_size");
+    if (pool_size)
+    {
+      this->req_pool_alloc(pool_size->get_int());
+    }
+
     // We have to instantiate a stub in case the binding is crossing different
     // frequency domains in order to resynchronize the target engine.
     if (this->get_owner()->get_clock() != this->remote_port->get_owner()->get_clock())
@@ -598,6 +885,7 @@ namespace vp {
 
   inline io_slave::io_slave() : req_meth(NULL), req_meth_mux(NULL) {
     req_meth = (io_req_meth_t *)&io_slave::req_default;
+    dmi_meth = &io_slave::dmi_default;
   }
 
 
@@ -607,6 +895,7 @@ namespace vp {
     // to the correct master port
     slave_port::bind_to(_port, config);
     io_master *port = (io_master *)_port;
+    this->dmi_masters.push_back(port);
     port->slave_port = new io_slave();
     port->slave_port->remote_port = port;
     port->slave_port->set_owner(this->get_owner());
@@ -633,6 +922,117 @@ namespace vp {
 
 
 
+  inline void io_slave::set_dmi_meth(io_dmi_meth_t *meth)
+  {
+    this->dmi_meth = meth;
+  }
+
+
+
+  inline void io_slave::set_dmi_watch(io_dmi_watch *watch)
+  {
+    this->dmi_watch = watch;
+  }
+
+
+
+  inline void io_slave::dmi_invalidate()
+  {
+    for (io_master *master: this->dmi_masters)
+    {
+      master->dmi_invalidate_meth(master->get_context());
+    }
+
+    if (this->dmi_watch)
+      this->dmi_watch->invalidate();
+  }
+
+
+
+  inline void io_dmi::watch(uint64_t addr)
+  {
+    if (this->watch_desc)
+      this->watch_desc->watch(this, this->get_ptr(addr));
+  }
+
+
+
+  inline void io_dmi::write_notify(uint64_t addr, uint64_t size)
+  {
+    if (this->watch_desc)
+      this->watch_desc->write(this->get_ptr(addr), size);
+  }
+
+
+
+  inline void io_dmi_watch::watch(io_dmi *dmi, uint8_t *ptr)
+  {
+    if (this->pages == NULL)
+    {
+      uint64_t nb_pages = ((this->size - 1) >> IO_DMI_WATCH_PAGE_BITS) + 1;
+      this->pages = new uint8_t[nb_pages]();
+    }
+
+    this->pages[(ptr - this->data) >> IO_DMI_WATCH_PAGE_BITS] = 1;
+
+    // The range is saved as the master may get another range into the
+    // same descriptor while still caching information about this one
+    for (watcher_t &watcher: this->watchers)
+    {
+      if (watcher.dmi == dmi && watcher.data == dmi->data && watcher.base == dmi->base)
+        return;
+    }
+
+    this->watchers.push_back({ dmi, dmi->base, dmi->data, dmi->size });
+  }
+
+
+
+  inline void io_dmi_watch::notify(uint8_t *ptr, uint64_t size)
+  {
+    uint64_t first = (ptr - this->data) >> IO_DMI_WATCH_PAGE_BITS;
+    uint64_t last = (ptr - this->data + size - 1) >> IO_DMI_WATCH_PAGE_BITS;
+    for (uint64_t page=first; page<=last; page++)
+    {
+      this->pages[page] = 0;
+    }
+
+    this->nb_notify++;
+
+    // The write may start before a watched range or end after it, only the
+    // part inside the range is notified
+    for (watcher_t &watcher: this->watchers)
+    {
+      if (ptr < watcher.data + watcher.size && ptr + size > watcher.data && watcher.dmi->write_meth)
+      {
+        uint8_t *start = ptr > watcher.data ? ptr : watcher.data;
+        uint8_t *end = ptr + size < watcher.data + watcher.size ? ptr + size : watcher.data + watcher.size;
+        watcher.dmi->write_meth(watcher.dmi->write_context, watcher.base + (start - watcher.data), end - start);
+      }
+    }
+  }
+
+
+
+  inline void io_dmi_watch::invalidate()
+  {
+    // The watchers are removed first as the masters may watch pages again
+    // from the notification
+    std::vector<watcher_t> watchers;
+    watchers.swap(this->watchers);
+
+    delete[] this->pages;
+    this->pages = NULL;
+
+    for (watcher_t &watcher: watchers)
+    {
+      if (watcher.dmi->write_meth)
+        watcher.dmi->write_meth(watcher.dmi->write_context, watcher.base, watcher.size);
+    }
+  }
+
+
+
   inline io_req_status_e io_slave::req_default(io_slave *, io_req *)
   {
     return IO_REQ_OK;
@@ -640,6 +1040,13 @@ namespace vp {
 
 
 
+  inline bool io_slave::dmi_default(void *, io_dmi *, uint64_t)
+  {
+    return false;
+  }
+
+
+
   inline void io_slave::grant_freq_cross_stub(io_slave *_this, io_req *req)
   {
     // The normal callback was tweaked in order to get there when the master is sending a
@@ -34,6 +34,15 @@ namespace vp {
 
   class time_engine_client;
 
+  // Backends available to order the clients of the time engine.
+  // The sorted list is cheap for a few clients but enqueueing is linear,
+  // while the heap is logarithmic and better suited when there are many clock
+  // domains.
+  typedef enum {
+    TIME_ENGINE_SCHEDULER_LIST,
+    TIME_ENGINE_SCHEDULER_HEAP
+  } time_engine_scheduler_e;
+
   class time_engine : public component {
   public:
     time_engine(const char *config);
@@ -75,10 +84,36 @@ namespace vp {
 
     inline void update(int64_t time);
 
+    // Tell if the running client can directly move the time forward to the
+    // specified time, which is the case if no other client has to be executed
+    // before and the engine is not requested to stop.
+    inline bool can_advance(int64_t time);
+
     void wait_ready();
+
+    time_engine_scheduler_e get_scheduler() { return scheduler; }
     
   private:
+    inline time_engine_client *get_first_client();
+    inline time_engine_client *pop_first_client();
+    inline void push_first_client(time_engine_client *client);
+    inline void reenqueue_client(time_engine_client *client, time_engine_client *first);
+
+    inline void heap_sift_up(int index);
+    inline void heap_sift_down(int index);
+    inline void heap_push(time_engine_client *client);
+    inline void heap_remove(time_engine_client *client);
+
+    time_engine_scheduler_e scheduler = TIME_ENGINE_SCHEDULER_LIST;
+
+    // Sorted list of clients, used by the list scheduler
     time_engine_client *first_client = NULL;
+
+    // Binary heap of clients, used by the heap scheduler. Each client knows
+    // its index so that it can be removed or moved without searching.
+    time_engine_client **heap = NULL;
+    int heap_size = 0;
+    int heap_capacity = 0;
     bool locked = false;
     bool locked_run_req;
     bool run_req;
@@ -139,6 +174,9 @@ namespace vp {
     vp::time_engine *engine;
     bool running = false;
     bool is_enqueued = false;
+
+    // Position of the client in the heap when the heap scheduler is used
+    int heap_index = -1;
   };
 
 
@@ -236,6 +274,165 @@ namespace vp {
   }
 
 
+  inline bool vp::time_engine::can_advance(int64_t time)
+  {
+#ifdef __VP_USE_SYSTEMC
+    // The time is driven by SystemC
+    return false;
+#else
+    time_engine_client *first = this->get_first_client();
+    return run_req && (first == NULL || first->next_event_time >= time);
+#endif
+  }
+
+
+  inline void vp::time_engine::heap_sift_up(int index)
+  {
+    time_engine_client *client = heap[index];
+    while (index > 0)
+    {
+      int parent = (index - 1) >> 1;
+      if (heap[parent]->next_event_time <= client->next_event_time)
+        break;
+      heap[index] = heap[parent];
+      heap[index]->heap_index = index;
+      index = parent;
+    }
+    heap[index] = client;
+    client->heap_index = index;
+  }
+
+
+  inline void vp::time_engine::heap_sift_down(int index)
+  {
+    time_engine_client *client = heap[index];
+    while (1)
+    {
+      int child = 2*index + 1;
+      if (child >= heap_size)
+        break;
+      if (child + 1 < heap_size && heap[child + 1]->next_event_time < heap[child]->next_event_time)
+        child++;
+      if (client->next_event_time <= heap[child]->next_event_time)
+        break;
+      heap[index] = heap[child];
+      heap[index]->heap_index = index;
+      index = child;
+    }
+    heap[index] = client;
+    client->heap_index = index;
+  }
+
+
+  inline void vp::time_engine::heap_push(time_engine_client *client)
+  {
+    if (unlikely(heap_size == heap_capacity))
+    {
+      heap_capacity = heap_capacity ? heap_capacity * 2 : 16;
+      heap = (time_engine_client **)realloc(heap, heap_capacity * sizeof(time_engine_client *));
+    }
+    heap[heap_size] = client;
+    heap_sift_up(heap_size++);
+  }
+
+
+  inline void vp::time_engine::heap_remove(time_engine_client *client)
+  {
+    int index = client->heap_index;
+    time_engine_client *last = heap[--heap_size];
+    client->heap_index = -1;
+
+    if (index != heap_size)
+    {
+      // Move the last client to the hole and restore the heap property in
+      // whatever direction is needed
+      heap[index] = last;
+      last->heap_index = index;
+      if (index > 0 && last->next_event_time < heap[(index - 1) >> 1]->next_event_time)
+        heap_sift_up(index);
+      else
+        heap_sift_down(index);
+    }
+  }
+
+
+  inline vp::time_engine_client *vp::time_engine::get_first_client()
+  {
+    if (scheduler == TIME_ENGINE_SCHEDULER_HEAP)
+      return heap_size ? heap[0] : NULL;
+    else
+      return first_client;
+  }
+
+
+  // Remove the client with the nearest event, which is then the one to be
+  // executed.
+  inline vp::time_engine_client *vp::time_engine::pop_first_client()
+  {
+    time_engine_client *client;
+
+    if (scheduler == TIME_ENGINE_SCHEDULER_HEAP)
+    {
+      if (heap_size == 0)
+        return NULL;
+      client = heap[0];
+      heap_remove(client);
+    }
+    else
+    {
+      client = first_client;
+      if (client == NULL)
+        return NULL;
+      first_client = client->next;
+    }
+
+    client->is_enqueued = false;
+    return client;
+  }
+
+
+  // Put back a client whose next event is known to be before any other one.
+  inline void vp::time_engine::push_first_client(time_engine_client *client)
+  {
+    client->is_enqueued = true;
+
+    if (scheduler == TIME_ENGINE_SCHEDULER_HEAP)
+    {
+      heap_push(client);
+    }
+    else
+    {
+      client->next = first_client;
+      first_client = client;
+    }
+  }
+
+
+  // Put back a client after it was executed, knowing that the client at the
+  // head is before it, which allows skipping it when the list is walked.
+  inline void vp::time_engine::reenqueue_client(time_engine_client *client, time_engine_client *first)
+  {
+    client->is_enqueued = true;
+
+    if (scheduler == TIME_ENGINE_SCHEDULER_HEAP)
+    {
+      heap_push(client);
+    }
+    else
+    {
+      int64_t time = client->next_event_time;
+      time_engine_client *current = first->next, *prev = first;
+      while (current && current->next_event_time < time)
+      {
+        prev = current;
+        current = current->next;
+      }
+      client->next = current;
+      prev->next = client;
+    }
+  }
+
+
 };
 
 #endif
@@ -24,6 +24,8 @@
 #include "vp/vp_data.hpp"
 #include "vp/trace/event_dumper.hpp"
 #include <stdarg.h>
+#include <functional>
+#include <vector>
 
 namespace vp {
 
@@ -58,8 +60,12 @@ namespace vp {
     void dump_warning_header();
     void dump_fatal_header();
 
-    void set_active(bool active) { is_active = active; }
-    void set_event_active(bool active) { is_event_active = active; }
+    inline void set_active(bool active);
+    inline void set_event_active(bool active);
+
+    // Register a callback which is called each time the trace or event is
+    // enabled or disabled, so that components can cache the trace state.
+    void reg_callback(std::function<void()> callback) { this->callbacks.push_back(callback); }
 
   #ifndef VP_TRACE_ACTIVE
     inline bool get_active() { return false; }
@@ -89,8 +95,27 @@ namespace vp {
     trace *next;
     trace *prev;
     int64_t pending_timestamp;
+    std::vector<std::function<void()>> callbacks;
   };    
 
+  inline void trace::set_active(bool active)
+  {
+    if (active == this->is_active)
+      return;
+    this->is_active = active;
+    for (auto& callback: this->callbacks)
+      callback();
+  }
+
+  inline void trace::set_event_active(bool active)
+  {
+    if (active == this->is_event_active)
+      return;
+    this->is_event_active = active;
+    for (auto& callback: this->callbacks)
+      callback();
+  }
+
 
 #define vp_assert_always(cond, trace_ptr, msg...)  \
   if (!(cond)) {                                   \
@@ -1080,6 +1080,12 @@ class Runner(Platform):
 
         parser.add_argument("--gtkw", dest="gtkw", action="store_true", help="Dump events to pipe and open gtkwave in interactive mode")
 
+        parser.add_argument("--gdb-server", dest="gdb_server", action="store_true", help="Start the built-in GDB server, the cores wait for GDB before executing")
+
+        parser.add_argument("--gdb-server-port", dest="gdb_server_port", type=int, default=None, help="Specify the TCP port of the GDB server (default: 1234)")
+
+        parser.add_argument("--gdb-server-socket", dest="gdb_server_socket", default=None, help="Make the GDB server listen on the specified Unix socket instead of a TCP port")
+
         [args, otherArgs] = parser.parse_known_args()
 
         if 'devices' in args.command:
@@ -1114,6 +1120,15 @@ class Runner(Platform):
         if args.gtkw:
             self.get_json().set('gvsoc/vcd/gtkw', True)
 
+        if args.gdb_server or args.gdb_server_port is not None or args.gdb_server_socket is not None:
+            self.get_json().set('gvsoc/gdb_server/active', True)
+
+            if args.gdb_server_port is not None:
+                self.get_json().set('gvsoc/gdb_server/port', args.gdb_server_port)
+
+            if args.gdb_server_socket is not None:
+                self.get_json().set('gvsoc/gdb_server/socket', args.gdb_server_socket)
+
 
     def devices(self):
         devices = []
@@ -1158,9 +1173,9 @@ class Runner(Platform):
         self.gen_rom_stimuli = False
 
         if self.args.debug_syms:
+            # The ISS reads the symbols and the line table directly from the ELF binaries
             for binary in self.get_json().get('**/runner/binaries').get_dict():
-                debug_binary = binary + '.debugInfo'
-                self.get_json().set('**/debug_binaries', debug_binary)
+                self.get_json().set('**/debug_binaries', binary)
 
         comps_conf = self.get_json().get('**/fs/files')
 
@@ -1194,11 +1209,6 @@ class Runner(Platform):
 
     def prepare(self):
 
-        if self.args.debug_syms:
-            for binary in self.get_json().get('**/runner/binaries').get_dict():
-                if os.system('pulp-pc-info --file %s --all-file %s' % (binary, binary + '.debugInfo')) != 0:
-                    raise Exception('Error while generating debug symbols information, make sure the toolchain and the binaries are accessible ')
-
         comps = []
         comps_conf = self.get_json().get('**/flash/fs/files')
         if comps_conf is not None:
@@ -1339,6 +1349,16 @@ class Runner(Platform):
             config=gvsoc_config
         )
 
+        # The GDB server must be created before the platform so that the cores
+        # find its service
+        gdb_server_config = gvsoc_config.get('gdb_server')
+        if gdb_server_config is not None and gdb_server_config.get_bool('active'):
+            time_engine.new(
+                name='gdb_server',
+                component='utils.gdb_server',
+                config=gdb_server_config
+            )
+
         top_comp = time_engine.new(
             name='sys',
             component=top,
@@ -121,6 +121,12 @@ bool vp::time_engine::dequeue(time_engine_client *client)
 
   client->is_enqueued = false;
 
+  if (this->scheduler == TIME_ENGINE_SCHEDULER_HEAP)
+  {
+    this->heap_remove(client);
+    return true;
+  }
+
   time_engine_client *current = this->first_client, *prev = NULL;
   while (current && current != client)
   {
@@ -150,6 +156,26 @@ void vp::time_engine::enqueue(time_engine_client *client, int64_t time)
   if (client->is_running())
     return;
 
+  if (this->scheduler == TIME_ENGINE_SCHEDULER_HEAP)
+  {
+    if (client->is_enqueued)
+    {
+      if (client->next_event_time <= full_time)
+        return;
+
+      // The client can only move closer to the head, no need to remove it
+      client->next_event_time = full_time;
+      this->heap_sift_up(client->heap_index);
+    }
+    else
+    {
+      client->is_enqueued = true;
+      client->next_event_time = full_time;
+      this->heap_push(client);
+    }
+    return;
+  }
+
   if (client->is_enqueued) 
   {
     if (client->next_event_time <= full_time)
@@ -251,139 +277,365 @@ vp::clock_event *vp::clock_engine::enqueue_other(vp::clock_event *event, int64_t
 
   // First check if we have to enqueue it to the global time engine in case we
   // were not running.
-  if (this->period != 0)
+  if (this->period != 0 && !this->is_running())
     enqueue_to_engine(cycle*period);
 
-  // Check if we can enqueue to the fast circular queue in case were not
-  // running.
-  bool can_enqueue_to_cycle = false;
-  if (!this->is_running())
+  this->wheel_enqueue(event, this->get_cycles() + cycle);
+
+  return event;
+}
+
+void vp::clock_engine::event_slab_alloc()
+{
+  int size = (sizeof(clock_event) + 63) & ~63;
+  void *slab;
+
+  if (posix_memalign(&slab, 64, size * CLOCK_EVENT_SLAB_SIZE))
+    throw std::bad_alloc();
+
+  for (int i=CLOCK_EVENT_SLAB_SIZE-1; i>=0; i--)
   {
-    this->current_cycle = this->get_cycles() & CLOCK_EVENT_QUEUE_MASK;
-    can_enqueue_to_cycle = this->current_cycle + cycle < CLOCK_EVENT_QUEUE_SIZE;
+    this->event_free((uint8_t *)slab + i * size);
   }
+}
+
+int vp::clock_engine::wheel_init(std::vector<int> level_bits)
+{
+  int shift = CLOCK_EVENT_QUEUE_BITS;
 
-  if (can_enqueue_to_cycle)
+  if (level_bits.size() > CLOCK_WHEEL_MAX_LEVELS)
   {
-    this->enqueue_to_cycle(event, cycle);
+    snprintf(vp_error, VP_ERROR_SIZE, "Too many timing wheel levels (levels: %d, max: %d)",
+      (int)level_bits.size(), CLOCK_WHEEL_MAX_LEVELS);
+    return -1;
   }
-  else
+
+  for (unsigned int i=0; i<level_bits.size(); i++)
   {
-    vp::clock_event *current = delayed_queue, *prev = NULL;
-    int64_t full_cycle = cycle + get_cycles();
-    while (current && current->cycle < full_cycle)
+    if (level_bits[i] <= 0 || level_bits[i] > CLOCK_WHEEL_MAX_LEVEL_BITS)
     {
-      prev = current;
-      current = current->next;
+      snprintf(vp_error, VP_ERROR_SIZE, "Invalid number of bits for timing wheel level (level: %d, bits: %d, max: %d)",
+        i, level_bits[i], CLOCK_WHEEL_MAX_LEVEL_BITS);
+      return -1;
     }
-    if (prev) prev->next = event;
-    else delayed_queue = event;
-    event->next = current;
-    event->cycle = full_cycle;
   }
-  return event;
+
+  // The wheel is only reconfigured before any event is enqueued, the
+  // previous levels are empty
+  for (int i=0; i<this->nb_wheel_levels; i++)
+  {
+    delete[] this->wheel_levels[i].slots;
+  }
+
+  this->nb_wheel_levels = level_bits.size();
+
+  for (int i=0; i<this->nb_wheel_levels; i++)
+  {
+    clock_wheel_level_t *level = &this->wheel_levels[i];
+    int size = 1 << level_bits[i];
+
+    level->shift = shift;
+    level->mask = size - 1;
+    level->nb_events = 0;
+    level->bitmap = 0;
+    level->slots = new clock_event *[size];
+    for (int j=0; j<size; j++)
+    {
+      level->slots[j] = NULL;
+    }
+
+    shift += level_bits[i];
+  }
+
+  return 0;
 }
 
-vp::clock_event *vp::clock_engine::get_next_event()
+void vp::clock_engine::wheel_enqueue(vp::clock_event *event, int64_t cycle)
 {
-  // There is no quick way of getting the next event.
-  // We have to first check if there is an event in the circular buffer
-  // and if not in the delayed queue
+  int64_t cycles = this->get_cycles();
 
-  if (this->nb_enqueued_to_cycle)
+  event->cycle = cycle;
+
+  // Events enqueued while the engine is idle, after its cycle count has
+  // been synchronized, can be before the next event of the wheel, the engine
+  // must then resume at the first of them.
+  if (this->must_resync && cycle < this->resync_cycle)
+    this->resync_cycle = cycle;
+
+  // The circular buffer is indexed with the absolute cycle, which is fine as
+  // long as the event is less than one round away.
+  if (cycle - cycles < CLOCK_EVENT_QUEUE_SIZE)
+  {
+    int index = cycle & CLOCK_EVENT_QUEUE_MASK;
+    this->list_push(&event_queue[index], event);
+    this->event_queue_bitmap |= 1ULL << index;
+    event->level = 0;
+    this->nb_enqueued_to_cycle++;
+    return;
+  }
+
+  this->nb_enqueued_to_wheel++;
+
+  if (cycle < this->wheel_next_cycle)
+  {
+    this->wheel_next_cycle = cycle;
+    this->wheel_next_event = event;
+  }
+
+  // Otherwise take the first level where the event is less than one round
+  // away. As the event is not in the previous level, it is always at least
+  // in the next slot of this level, which will be cascaded when the engine
+  // cycle reaches it.
+  for (int i=0; i<this->nb_wheel_levels; i++)
   {
-    for (int i=0; i<CLOCK_EVENT_QUEUE_SIZE; i++)
+    clock_wheel_level_t *level = &this->wheel_levels[i];
+    if ((cycle >> level->shift) - (cycles >> level->shift) <= level->mask)
     {
-      int cycle = (current_cycle + i) & CLOCK_EVENT_QUEUE_MASK;
-      vp::clock_event *event = event_queue[cycle];
-      if (event)
-      {
-        return event;
-      }
+      int index = (cycle >> level->shift) & level->mask;
+      this->list_push(&level->slots[index], event);
+      level->bitmap |= 1ULL << index;
+      level->nb_events++;
+      event->level = i + 1;
+      return;
     }
-    vp_assert(false, 0, "Didn't find any event in circular buffer while it is not empty\n");
   }
 
-  return this->delayed_queue;
+  this->list_push(&this->overflow_queue, event);
+  event->level = CLOCK_EVENT_LEVEL_OVERFLOW;
 }
 
-void vp::clock_engine::cancel(vp::clock_event *event)
+void vp::clock_engine::wheel_cascade_slot(int level_id, int64_t cycle)
 {
-  if (!event->is_enqueued())
+  clock_wheel_level_t *level = &this->wheel_levels[level_id];
+
+  if (level->nb_events == 0)
     return;
 
-  // There is no way to know if the event is enqueued into the circular buffer
-  // or in the delayed queue so first go through the delayed queue and if it is
-  // not found, look in the circular buffer
+  int index = (cycle >> level->shift) & level->mask;
+  clock_event *event = level->slots[index];
 
-  // First the delayed queue
-  vp::clock_event *current = delayed_queue, *prev = NULL;
-  while (current)
+  level->slots[index] = NULL;
+  level->bitmap &= ~(1ULL << index);
+
+  while (event)
   {
-    if (current == event)
-    {
-      if (prev)
-        prev->next = event->next;
-      else
-        delayed_queue = event->next;
+    clock_event *next = event->next;
+    this->nb_enqueued_to_wheel--;
+    level->nb_events--;
+    this->wheel_enqueue(event, event->cycle);
+    if (event->level == 0)
+      this->wheel_check_next(event);
+    event = next;
+  }
+}
 
-      goto end;
-    }
+void vp::clock_engine::wheel_cascade_overflow()
+{
+  clock_event *event = this->overflow_queue;
 
-    prev = current;
-    current = current->next;
+  this->overflow_queue = NULL;
+
+  while (event)
+  {
+    clock_event *next = event->next;
+    this->nb_enqueued_to_wheel--;
+    this->wheel_enqueue(event, event->cycle);
+    if (event->level == 0)
+      this->wheel_check_next(event);
+    event = next;
   }
+}
+
+void vp::clock_engine::wheel_cascade()
+{
+  this->must_cascade = false;
 
-  // Then in the circular buffer
-  for (int i=0; i<CLOCK_EVENT_QUEUE_SIZE; i++)
+  if (this->must_resync)
   {
-    vp::clock_event *current = event_queue[i], *prev = NULL;
-    while (current)
+    // The engine gave back control as it had nothing to execute in the next
+    // cycles. Jump to the next event, either from the wheel or enqueued
+    // while the engine was idle, which is when we get called, and bring down
+    // all slots of the upper levels containing this cycle, from the top, as
+    // slots may have been skipped.
+    this->must_resync = false;
+
+    int64_t cycle = this->resync_cycle;
+    if (this->nb_enqueued_to_wheel && this->wheel_get_next_cycle() < cycle)
+      cycle = this->wheel_next_cycle;
+
+    this->resync_cycle = INT64_MAX;
+
+    if (cycle > this->cycles)
+      this->cycles = cycle;
+
+    this->current_cycle = this->cycles & CLOCK_EVENT_QUEUE_MASK;
+
+    if (this->nb_enqueued_to_wheel == 0)
+      return;
+
+    // Most of the time, the engine is only waiting for a single event, move
+    // it directly to the circular buffer.
+    if (this->nb_enqueued_to_wheel == 1 && this->wheel_get_next_cycle() == this->cycles)
     {
-      if (current == event)
-      {
-        if (prev)
-          prev->next = event->next;
-        else
-          event_queue[i] = event->next;
+      clock_event *event = this->wheel_next_event;
+      this->cancel_from_wheel(event);
+      this->enqueue_to_cycle(event, 0);
+      return;
+    }
 
-        this->nb_enqueued_to_cycle--;
+    if (this->overflow_queue)
+      this->wheel_cascade_overflow();
 
-        goto end;
-      }
+    for (int i=this->nb_wheel_levels-1; i>=0; i--)
+    {
+      if (this->wheel_levels[i].nb_events)
+        this->wheel_cascade_slot(i, this->cycles);
+    }
+  }
+  else if (this->nb_enqueued_to_wheel)
+  {
+    // The circular buffer wrapped, cascade the slots of the levels which are
+    // starting a new slot, from the top.
+    int64_t cycles = this->cycles;
+    int last_level = 0;
+    while (last_level < this->nb_wheel_levels - 1 &&
+      (cycles & ((1LL << this->wheel_levels[last_level + 1].shift) - 1)) == 0)
+    {
+      last_level++;
+    }
 
-      prev = current;
-      current = current->next;
+    if (this->overflow_queue && last_level == this->nb_wheel_levels - 1)
+    {
+      clock_wheel_level_t *level = &this->wheel_levels[last_level];
+      if (((cycles >> level->shift) & level->mask) == 0)
+        this->wheel_cascade_overflow();
+    }
+
+    for (int i=last_level; i>=0; i--)
+    {
+      this->wheel_cascade_slot(i, cycles);
     }
   }
+}
 
-  vp_assert(0, NULL, "Didn't find event in any queue while canceling event\n");
+// Returns the distance from index to the first non-empty slot, wrapping
+// around the level, or -1 if all slots are empty.
+static inline int clock_bitmap_first(uint64_t bitmap, int index, int size)
+{
+  if (bitmap == 0)
+    return -1;
 
-end:
-  event->enqueued = false;
+  uint64_t upper = bitmap >> index;
+  if (upper)
+    return __builtin_ctzll(upper);
 
-  if (!this->has_events())
-    this->dequeue_from_engine();
+  return size - index + __builtin_ctzll(bitmap);
+}
+
+vp::clock_event *vp::clock_engine::get_next_event()
+{
+  // We have to first check if there is an event in the circular buffer
+  // and then in each level of the wheel as the first slot of an upper level
+  // can be before the last one of the lower level.
+  // The first non-empty slot of each level is given by its bitmap.
+
+  vp::clock_event *result = NULL;
+
+  if (this->nb_enqueued_to_cycle)
+  {
+    int offset = clock_bitmap_first(this->event_queue_bitmap,
+      this->cycles & CLOCK_EVENT_QUEUE_MASK, CLOCK_EVENT_QUEUE_SIZE);
+
+    vp_assert(offset >= 0, 0, "Didn't find any event in circular buffer while it is not empty\n");
+
+    result = event_queue[(this->cycles + offset) & CLOCK_EVENT_QUEUE_MASK];
+  }
+
+  if (this->nb_enqueued_to_wheel)
+  {
+    int64_t cycle = this->wheel_get_next_cycle();
+    if (result == NULL || cycle < result->cycle)
+      result = this->wheel_next_event;
+  }
+
+  return result;
 }
 
-void vp::clock_engine::flush_delayed_queue()
+void vp::clock_engine::wheel_find_next()
 {
-  clock_event *event = delayed_queue;
-  this->must_flush_delayed_queue = false;
+  vp::clock_event *result = NULL;
+
+  for (int i=0; i<this->nb_wheel_levels; i++)
+  {
+    clock_wheel_level_t *level = &this->wheel_levels[i];
+    int64_t index = (this->cycles >> level->shift) & level->mask;
+
+    int offset = clock_bitmap_first(level->bitmap, index, level->mask + 1);
+    if (offset < 0)
+      continue;
+
+    // Events of a slot are not sorted
+    vp::clock_event *event = level->slots[(index + offset) & level->mask];
+    while (event)
+    {
+      if (result == NULL || event->cycle < result->cycle)
+        result = event;
+      event = event->next;
+    }
+  }
+
+  vp::clock_event *event = this->overflow_queue;
   while (event)
   {
-    if (nb_enqueued_to_cycle == 0) cycles = event->cycle;
+    if (result == NULL || event->cycle < result->cycle)
+      result = event;
+    event = event->next;
+  }
 
-    uint64_t cycle_diff = event->cycle - get_cycles();
-    if (cycle_diff >= CLOCK_EVENT_QUEUE_SIZE) break;
+  this->wheel_next_event = result;
+  this->wheel_next_cycle = result ? result->cycle : INT64_MAX;
+}
 
-    clock_event *next = event->next;
+void vp::clock_engine::cancel_from_wheel(vp::clock_event *event)
+{
+  this->list_remove(event);
 
-    enqueue_to_cycle(event, cycle_diff);
+  if (event->level != CLOCK_EVENT_LEVEL_OVERFLOW)
+  {
+    clock_wheel_level_t *level = &this->wheel_levels[event->level - 1];
+    int index = (event->cycle >> level->shift) & level->mask;
+    if (level->slots[index] == NULL)
+      level->bitmap &= ~(1ULL << index);
+    level->nb_events--;
+  }
+  this->nb_enqueued_to_wheel--;
+  this->wheel_check_next(event);
+}
 
-    event = next;
-    delayed_queue = event;
+void vp::clock_engine::cancel(vp::clock_event *event)
+{
+  if (!event->is_enqueued())
+    return;
+
+  // The event knows where it is linked, and the slot of its level is given
+  // by its cycle, which is only needed to keep the bitmap up-to-date.
+  if (event->level == 0)
+  {
+    this->list_remove(event);
+    int index = event->cycle & CLOCK_EVENT_QUEUE_MASK;
+    if (event_queue[index] == NULL)
+      this->event_queue_bitmap &= ~(1ULL << index);
+    this->nb_enqueued_to_cycle--;
   }
+  else
+  {
+    this->cancel_from_wheel(event);
+  }
+
+  event->enqueued = false;
+
+  if (!this->has_events())
+    this->dequeue_from_engine();
 }
 
 int64_t vp::clock_engine::exec()
@@ -391,18 +643,18 @@ int64_t vp::clock_engine::exec()
   vp_assert(this->has_events(), NULL, "Executing clock engine while it has no event\n");
   vp_assert(this->get_next_event(), NULL, "Executing clock engine while it has no next event\n");
 
-  this->cycles_trace.event_real(this->cycles);
-
-  // The clock engine has a circular buffer of events to be executed.
-  // Events longer than the buffer as put temporarly in a queue.
-  // Everytime we start again at the beginning of the buffer, we need
-  // to check if events must be enqueued from the queue to the buffer
-  // in case they fit the window.
-  if (unlikely(this->must_flush_delayed_queue))
+  // The clock engine has a circular buffer of events to be executed, which
+  // is the first level of a timing wheel.
+  // Everytime we start again at the beginning of the buffer, or when we come
+  // back after the buffer got empty, we need to cascade the upper levels of
+  // the wheel so that events reaching the buffer window are moved to it.
+  if (unlikely(this->must_cascade))
   {
-    this->flush_delayed_queue();
+    this->wheel_cascade();
   }
 
+  this->cycles_trace.event_real(this->cycles);
+
   vp_assert(this->get_next_event(), NULL, "Executing clock engine while it has no next event\n");
 
   // Now take all events available at the current cycle and execute them all without returning
@@ -411,7 +663,7 @@ int64_t vp::clock_engine::exec()
 
   while (likely(current != NULL))
   {
-    event_queue[current_cycle] = current->next;
+    this->list_remove(current);
     current->enqueued = false;
     nb_enqueued_to_cycle--;
 
@@ -419,6 +671,8 @@ int64_t vp::clock_engine::exec()
     current = event_queue[current_cycle];
   }
 
+  this->event_queue_bitmap &= ~(1ULL << current_cycle);
+
   // Now we need to tell the time engine when is the next event.
   // The most likely is that there is an event in the circular buffer, 
   // in which case we just return the clock period, as we will go through
@@ -429,24 +683,25 @@ int64_t vp::clock_engine::exec()
     cycles++;
     current_cycle = (current_cycle + 1) & CLOCK_EVENT_QUEUE_MASK;
     if (unlikely(current_cycle == 0))
-      this->must_flush_delayed_queue = true;
+      this->must_cascade = true;
     return period;
   }
   else
   {
-    // Otherwise if there is an event in the delayed queue, return the time
+    // Otherwise if there is an event in the upper levels, return the time
     // to this event.
-    // In both cases, force the delayed queue flush so that the next event to be
-    // executed is moved to the circular buffer.
-    this->must_flush_delayed_queue = true;
+    // In both cases, force the cycle resynchronization so that we jump to the
+    // next event when we get called again.
+    this->must_cascade = true;
+    this->must_resync = true;
 
     // Also remember the current time in order to resynchronize the clock engine
     // in case we enqueue and event from another engine.
     this->stop_time = this->get_time();
 
-    if (delayed_queue)
+    if (this->nb_enqueued_to_wheel)
     {
-      return (delayed_queue->cycle - get_cycles()) * period;
+      return (this->wheel_get_next_cycle() - get_cycles()) * period;
     }
     else
     {
@@ -459,7 +714,7 @@ int64_t vp::clock_engine::exec()
 
 
 vp::clock_event::clock_event(component_clock *comp, clock_event_meth_t *meth) 
-: comp(comp), _this((void *)static_cast<vp::component *>((vp::component_clock *)(comp))), meth(meth), enqueued(false)
+: meth(meth), _this((void *)static_cast<vp::component *>((vp::component_clock *)(comp))), enqueued(false), comp(comp), data(NULL)
 {
 
 }
@@ -785,6 +1040,14 @@ void vp::component::conf(string path, vp::component *parent)
   {
     parent->add_child(this);
   }
+
+  // The functional mode is usually set on the top component and inherited
+  // by all the others, but can also be set on any sub-tree.
+  js::config *functional_conf = this->get_js_config()->get("functional");
+  if (functional_conf != NULL)
+    this->functional = functional_conf->get_bool();
+  else if (parent != NULL)
+    this->functional = parent->get_functional();
 }
 
 void vp::component::add_child(vp::component *child)
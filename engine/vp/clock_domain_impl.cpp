@@ -62,6 +62,21 @@ void clock_domain::set_frequency(void *__this, int64_t frequency)
 
 int clock_domain::build()
 {
+  // Number of bits of each upper level of the timing wheel, after the
+  // circular buffer
+  js::config *levels_conf = this->get_js_config()->get("wheel_level_bits");
+  if (levels_conf)
+  {
+    std::vector<int> level_bits;
+    for (auto x: levels_conf->get_elems())
+    {
+      level_bits.push_back(x->get_int());
+    }
+
+    if (this->wheel_init(level_bits))
+      return -1;
+  }
+
   new_master_port("out", &out);
 
   clock_in.set_set_frequency_meth(&clock_domain::set_frequency);
@@ -81,14 +96,23 @@ void clock_domain::pre_start()
 
 
 vp::clock_engine::clock_engine(const char *config)
-  : vp::time_engine_client(config), cycles(0), period(0), freq(0), must_flush_delayed_queue(true)
+  : vp::time_engine_client(config), cycles(0), period(0), freq(0), must_cascade(true)
 {
-  delayed_queue = NULL;
   for (int i=0; i<CLOCK_EVENT_QUEUE_SIZE; i++)
   {
     event_queue[i] = NULL;
   }
   current_cycle = 0;
+
+  // The wheel starts with the default levels, the configured ones are
+  // applied when the domain is built, where they can be reported as invalid
+  std::vector<int> level_bits;
+  for (int i=0; i<CLOCK_WHEEL_DEFAULT_NB_LEVELS; i++)
+  {
+    level_bits.push_back(CLOCK_WHEEL_DEFAULT_LEVEL_BITS);
+  }
+
+  this->wheel_init(level_bits);
 }
 
 
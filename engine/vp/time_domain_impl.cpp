@@ -126,6 +126,23 @@ vp::time_engine::time_engine(const char *config)
 
   run_req = false;
   stop_req = false;
+
+  js::config *item_conf = this->get_js_config()->get("**/gvsoc/time_scheduler");
+  if (item_conf != NULL)
+  {
+    std::string name = item_conf->get_str();
+    if (name == "heap")
+      this->scheduler = vp::TIME_ENGINE_SCHEDULER_HEAP;
+    else if (name == "list")
+      this->scheduler = vp::TIME_ENGINE_SCHEDULER_LIST;
+    else
+    {
+      // The engine mutex is held at this point, we can't go through the
+      // usual fatal path which would try to stop the engine.
+      fprintf(stdout, "[\033[31mFATAL\033[0m] Unknown time scheduler (name: %s)\n", name.c_str());
+      abort();
+    }
+  }
 }
 
 
@@ -211,7 +228,7 @@ void vp::time_engine::start()
 
 void vp::time_engine::wait_ready()
 {
-  while (!first_client)
+  while (!this->get_first_client())
   {
   }
 }
@@ -254,13 +271,10 @@ void vp::time_engine::run_loop()
 
     pthread_mutex_unlock(&mutex);
 
-    time_engine_client *current = first_client;
+    time_engine_client *current = this->pop_first_client();
 
     if (current)
     {
-      first_client = current->next;
-      current->is_enqueued = false;
-
       // Update the global engine time with the current event time
       this->time = current->next_event_time;
 
@@ -284,20 +298,12 @@ void vp::time_engine::run_loop()
         {
           time += this->time;
           current->next_event_time = time;
-          time_engine_client *client = first_client, *prev = NULL;
 
-          while (client && client->next_event_time < time)
-          {
-            prev = client;
-            client = client->next;
-          }
-          if (prev)
-            prev->next = current;
+          time_engine_client *first_client = this->get_first_client();
+          if (first_client == NULL || first_client->next_event_time >= time)
+            this->push_first_client(current);
           else
-            first_client = current;
-
-          current->next = client;
-          current->is_enqueued = true;
+            this->reenqueue_client(current, first_client);
         }
 
         if (!run_req) break;
@@ -307,6 +313,8 @@ void vp::time_engine::run_loop()
         // enqueues a new event.
         while(1)
         {
+          time_engine_client *first_client = this->get_first_client();
+
           if (!first_client)
           {
             if (stop_req || locked) {
@@ -330,20 +338,17 @@ void vp::time_engine::run_loop()
           }
         }
 
-        current = first_client;
+        current = this->pop_first_client();
         if (current)
         {
-          vp_assert(first_client->next_event_time >= get_time(), NULL, "event time is before vp time\n");
-
-          first_client = current->next;
-          current->is_enqueued = false;
+          vp_assert(current->next_event_time >= get_time(), NULL, "event time is before vp time\n");
         }
 
   #else
     
         int64_t time = current->exec();
 
-        time_engine_client *next = first_client;
+        time_engine_client *next = this->get_first_client();
 
         // Shortcut to quickly continue with the same client
         if (likely(time > 0))
@@ -358,10 +363,8 @@ void vp::time_engine::run_loop()
             }
             else
             {
-              current->next = first_client;
-              first_client = current;
               current->next_event_time = time;
-              current->is_enqueued = true;
+              this->push_first_client(current);
               current->running = false;
               break;
             }
@@ -375,28 +378,17 @@ void vp::time_engine::run_loop()
         if (time > 0)
         {
           current->next_event_time = time;
-          time_engine_client *client = next->next, *prev = next;
-          while (client && client->next_event_time < time)
-          {
-            prev = client;
-            client = client->next;
-          }
-          current->next = client;
-          prev->next = current;
-          current->is_enqueued = true;
+          this->reenqueue_client(current, next);
         }
 
         current->running = false;
 
         if (!run_req) break;
 
-        current = first_client;
+        current = this->pop_first_client();
         if (current)
         {
-          vp_assert(first_client->next_event_time >= get_time(), NULL, "event time is before vp time\n");
-
-          first_client = current->next;
-          current->is_enqueued = false;
+          vp_assert(current->next_event_time >= get_time(), NULL, "event time is before vp time\n");
         }
 
   #endif
@@ -413,7 +405,7 @@ void vp::time_engine::run_loop()
 
     running = false;
 
-    while(!first_client && retain_count && !locked)
+    while(!this->get_first_client() && retain_count && !locked)
     {
 #ifdef __VP_USE_SYSTEMC
       pthread_mutex_unlock(&mutex);
@@ -424,9 +416,7 @@ void vp::time_engine::run_loop()
 #endif
     }
 
-    current = first_client;
-
-    if (first_client == NULL && !locked && !retain_count)
+    if (this->get_first_client() == NULL && !locked && !retain_count)
     {
 #ifdef __VP_USE_SYSTEMC
       sc_stop();
@@ -36,6 +36,8 @@ public:
   void set_trace_level(const char *trace_level);
   void add_paths(int events, int nb_path, const char **paths);
   void add_path(int events, const char *path);
+  void remove_paths(int events, int nb_path, const char **paths);
+  void remove_path(int events, const char *path);
   void reg_trace(vp::trace *trace, int event, string path, string name);
 
   int build();
@@ -52,10 +54,19 @@ public:
 
 private:
 
+  void check_trace_active(int id);
+  void check_traces_active(int events);
+
   std::vector<regex_t *> path_regex;
+  std::vector<std::string> path_regex_path;
   std::vector<std::string> path_regex_file;
   std::vector<regex_t *> events_path_regex;
+  std::vector<std::string> events_path_regex_path;
   std::vector<string> events_file;
+  // Full path and kind of each registered trace, indexed by trace ID, so that
+  // the traces can be checked again when the paths are modified.
+  std::vector<std::string> traces_path;
+  std::vector<bool> traces_event;
   int max_path_len = 0;
   vp::trace_level_e trace_level = vp::TRACE;
   std::vector<vp::trace *> init_traces;
@@ -106,14 +117,30 @@ void trace_domain::reg_trace(vp::trace *trace, int event, string path, string na
     full_path = name;
 
   traces_map[full_path] = trace;
+  this->traces_path.push_back(full_path);
+  this->traces_event.push_back(event);
 
   trace->trace_file = stdout;
 
+  this->check_trace_active(trace->id);
+}
+
+// Enable or disable the specified trace, depending on whether one of the
+// paths matches it. This is done when the trace is registered and then
+// each time the paths are modified.
+void trace_domain::check_trace_active(int id)
+{
+  vp::trace *trace = this->traces_array[id];
+  std::string full_path = this->traces_path[id];
+  bool event = this->traces_event[id];
+  bool active = false;
+
   int index = 0;
   for (auto& x: event ? events_path_regex : path_regex) {
 
     if (regexec(x, full_path.c_str(), 0, NULL, 0) == 0)
     {
+      active = true;
       if (event)
       {
         vp::Event_trace *event_trace;
@@ -123,7 +150,6 @@ void trace_domain::reg_trace(vp::trace *trace, int event, string path, string na
           event_trace = event_dumper.get_trace_string(full_path, this->events_file[index]);
         else
           event_trace = event_dumper.get_trace(full_path, this->events_file[index], trace->width);
-        trace->set_event_active(true);
         trace->event_trace = event_trace;
       }
       else
@@ -144,11 +170,24 @@ void trace_domain::reg_trace(vp::trace *trace, int event, string path, string na
           }
           trace->trace_file = this->trace_files[file_path];
         }
-        trace->set_active(true);
       }
     }
     index++;
   }
+
+  if (event)
+    trace->set_event_active(active);
+  else
+    trace->set_active(active);
+}
+
+void trace_domain::check_traces_active(int events)
+{
+  for (unsigned int i=0; i<this->traces_array.size(); i++)
+  {
+    if (this->traces_event[i] == (bool)events)
+      this->check_trace_active(i);
+  }
 }
 
 int trace_domain::build()
@@ -202,6 +241,7 @@ void trace_domain::add_path(int events, const char *path)
       file_path = delim + 1;
     }
     events_path_regex.push_back(regex);
+    events_path_regex_path.push_back(path);
     events_file.push_back((char *)file_path);
   }
   else
@@ -216,6 +256,7 @@ void trace_domain::add_path(int events, const char *path)
       path = dup_path;
     }
     path_regex.push_back(regex);
+    path_regex_path.push_back(path);
     path_regex_file.push_back(file_path);
   }
 
@@ -228,6 +269,48 @@ void trace_domain::add_paths(int events, int nb_path, const char **paths)
   {
     add_path(events, paths[i]);
   }
+
+  // Paths can also be added while the simulation is running, in which case
+  // the traces which are already registered must be enabled
+  this->check_traces_active(events);
+}
+
+void trace_domain::remove_path(int events, const char *path)
+{
+  std::vector<regex_t *> &regexs = events ? events_path_regex : path_regex;
+  std::vector<std::string> &regex_paths = events ? events_path_regex_path : path_regex_path;
+
+  // Paths are given as when they were added, possibly with the file
+  std::string regex_path = path;
+  size_t sep = regex_path.find(events ? '@' : ':');
+  if (sep != std::string::npos)
+    regex_path = regex_path.substr(0, sep);
+
+  for (unsigned int i=0; i<regexs.size(); i++)
+  {
+    if (regex_paths[i] == regex_path)
+    {
+      regfree(regexs[i]);
+      delete regexs[i];
+      regexs.erase(regexs.begin() + i);
+      regex_paths.erase(regex_paths.begin() + i);
+      if (events)
+        events_file.erase(events_file.begin() + i);
+      else
+        path_regex_file.erase(path_regex_file.begin() + i);
+      return;
+    }
+  }
+}
+
+void trace_domain::remove_paths(int events, int nb_path, const char **paths)
+{
+  for (int i=0; i<nb_path; i++)
+  {
+    remove_path(events, paths[i]);
+  }
+
+  this->check_traces_active(events);
 }
 
 void trace_domain::set_trace_level(const char *trace_level)
@@ -259,6 +342,11 @@ extern "C" void vp_trace_add_paths(void *comp, int events, int nb_path, const ch
   ((trace_domain *)comp)->add_paths(events, nb_path, paths);
 }
 
+extern "C" void vp_trace_remove_paths(void *comp, int events, int nb_path, const char **paths)
+{
+  ((trace_domain *)comp)->remove_paths(events, nb_path, paths);
+}
+
 extern "C" void vp_trace_level(void *comp, const char *level)
 {
   ((trace_domain *)comp)->set_trace_level(level);
@@ -53,6 +53,17 @@ class component(vp.component):
           implem_traces[i] = traces[i].encode('utf-8')
         self.impl.module.vp_trace_add_paths(self.impl.instance, event, len(traces), implem_traces)
 
+    def unreg_traces(self, traces, event):
+
+        if event == 0:
+          for trace in traces:
+            self.traces = [x for x in self.traces if x.pattern != trace]
+
+        implem_traces = (ctypes.c_char_p * len(traces))()
+        for i in range(0, len(traces)):
+          implem_traces[i] = traces[i].encode('utf-8')
+        self.impl.module.vp_trace_remove_paths(self.impl.instance, event, len(traces), implem_traces)
+
 
     def build(self):
         self.new_service('trace')
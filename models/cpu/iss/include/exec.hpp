@@ -25,7 +25,7 @@
 void update_external_pccr(iss_t *iss, int id, unsigned int pcer, unsigned int pcmr);
 #endif
 
-static inline int iss_exec_account_cycles(iss_t *iss, int cycles);
+static inline void iss_exec_account_cycles(iss_t *iss, int cycles);
 
 iss_insn_t *iss_exec_insn_with_trace(iss_t *iss, iss_insn_t *insn);
 void iss_trace_dump(iss_t *iss, iss_insn_t *insn);
@@ -72,15 +72,57 @@ static inline iss_insn_t *iss_exec_insn(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *iss_exec_stalled_insn_fast(iss_t *iss, iss_insn_t *insn)
 {
-  iss_perf_account_dependency_stall(iss, insn->latency);
-  return iss_exec_insn_handler(iss, insn, insn->stall_fast_handler);
+  iss_perf_account_dependency_stall(iss, insn->cold->latency);
+  return iss_exec_insn_handler(iss, insn, insn->cold->stall_fast_handler);
 }
 
 static inline iss_insn_t *iss_exec_stalled_insn(iss_t *iss, iss_insn_t *insn)
 {
-  iss_perf_account_dependency_stall(iss, insn->latency);
+  iss_perf_account_dependency_stall(iss, insn->cold->latency);
   iss_pccr_account_event(iss, CSR_PCER_LD_STALL, 1);
-  return iss_exec_insn_handler(iss, insn, insn->stall_handler);
+  return iss_exec_insn_handler(iss, insn, insn->cold->stall_handler);
+}
+
+// Handlers installed in front of the real ones when the execution histogram
+// is enabled, so that counting costs nothing when it is disabled
+static inline iss_insn_t *iss_exec_insn_with_histogram_fast(iss_t *iss, iss_insn_t *insn)
+{
+  insn->cold->exec_count++;
+  return iss_exec_insn_handler(iss, insn, insn->cold->histogram_fast_handler);
+}
+
+static inline iss_insn_t *iss_exec_insn_with_histogram(iss_t *iss, iss_insn_t *insn)
+{
+  insn->cold->exec_count++;
+  return iss_exec_insn_handler(iss, insn, insn->cold->histogram_handler);
+}
+
+// Handlers installed in front of the real ones while the instruction cache
+// line of the instruction is not held by the core. The real handler is taken
+// first as it is put back once the core holds the line.
+static inline iss_insn_t *iss_exec_insn_with_icache(iss_t *iss, iss_insn_t *insn)
+{
+  iss_insn_t *(*handler)(iss_t *, iss_insn_t*) = insn->cold->icache_handler;
+  if (iss_icache_fetch(iss, insn))
+    iss_icache_unwrap(iss, insn);
+  return iss_exec_insn_handler(iss, insn, handler);
+}
+
+static inline iss_insn_t *iss_exec_insn_with_icache_fast(iss_t *iss, iss_insn_t *insn)
+{
+  iss_insn_t *(*handler)(iss_t *, iss_insn_t*) = insn->cold->icache_fast_handler;
+  if (iss_icache_fetch(iss, insn))
+    iss_icache_unwrap(iss, insn);
+  return iss_exec_insn_handler(iss, insn, handler);
+}
+
+// Handler installed on the instructions where the debugger set a breakpoint.
+// The core is halted and stays on the instruction, which is executed only
+// once the debugger resumes it after removing the breakpoint.
+static inline iss_insn_t *iss_exec_insn_breakpoint(iss_t *iss, iss_insn_t *insn)
+{
+  iss_handle_breakpoint(iss, insn);
+  return insn;
 }
 
 
@@ -98,7 +140,14 @@ static inline int iss_exec_step_nofetch(iss_t *iss)
 {
   ISS_EXEC_NO_FETCH_COMMON(iss,iss_exec_insn_fast);
 
-  return iss->cpu.state.insn_cycles;
+  // Only the running totals are updated here, the performance counters are
+  // computed from them when they are read
+  int cycles = iss->cpu.state.insn_cycles;
+  iss->cpu.state.nb_insns++;
+  if (cycles >= 0)
+    iss->cpu.state.nb_cycles += cycles;
+
+  return cycles;
 }
 
 static inline int iss_exec_step(iss_t *iss)
@@ -106,34 +155,59 @@ static inline int iss_exec_step(iss_t *iss)
   return iss_exec_step_nofetch(iss);
 }
 
+// Same as iss_exec_step_nofetch but executes the translated block starting
+// at the current instruction if there is one, and profiles block heads, i.e.
+// instructions which are reached from a jump or a taken branch.
+static inline int iss_exec_step_nofetch_jit(iss_t *iss)
+{
+  iss_insn_t *insn = iss->cpu.current_insn;
+  int cycles;
+
+  if (insn->jit_block)
+  {
+    cycles = insn->jit_block(iss);
+    if (cycles != ISS_JIT_NONE)
+    {
+      if (cycles >= 0 && iss->cpu.current_insn->jit_block == NULL)
+        iss_jit_profile(iss, iss->cpu.current_insn);
+      return cycles;
+    }
+  }
+
+  cycles = iss_exec_step_nofetch(iss);
+
+  if (cycles >= 0 && iss->cpu.current_insn != insn->next && iss->cpu.current_insn->jit_block == NULL)
+    iss_jit_profile(iss, iss->cpu.current_insn);
+
+  return cycles;
+}
+
 
 static inline int iss_exec_switch_to_fast(iss_t *iss)
 {
-#ifdef VP_TRACE_ACTIVE
-  return false;
-#else
-  return !iss->cpu.state.hw_counter_en && !(iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE) && !iss->cpu.csr.stack_conf;
-#endif
+  return !iss_traces_active(iss) && !iss_pccr_check_all(iss) && !iss->cpu.csr.stack_conf;
 }
 
-static inline int iss_exec_account_cycles(iss_t *iss, int cycles)
+static inline void iss_exec_account_cycles(iss_t *iss, int cycles)
 {
-  if (iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE)
+  if (cycles >= 0)
   {
-    if (cycles >= 0 && (iss->cpu.csr.pcer & (1<<CSR_PCER_CYCLES)))
-    {
-      iss->cpu.csr.pccr[CSR_PCER_CYCLES] += cycles;
-    }
+    iss->cpu.state.nb_cycles += cycles;
   }
 
   iss_pccr_incr(iss, CSR_PCER_CYCLES, cycles);
 
 #if defined(ISS_HAS_PERF_COUNTERS)
-  for (int i=CSR_PCER_NB_INTERNAL_EVENTS; i<CSR_PCER_NB_EVENTS; i++)
+  // External counters only need to be pulled for each instruction when
+  // they are traced, otherwise this is done when they are read
+  if (iss_traces_active(iss))
   {
-    if (iss_pccr_trace_active(iss, i))
+    for (int i=CSR_PCER_NB_INTERNAL_EVENTS; i<CSR_PCER_NB_EVENTS; i++)
     {
-      update_external_pccr(iss, i, iss->cpu.csr.pcer, iss->cpu.csr.pcmr);
+      if (iss_pccr_trace_active(iss, i))
+      {
+        update_external_pccr(iss, i, iss->cpu.csr.pcer, iss->cpu.csr.pcmr);
+      }
     }
   }
 #endif
@@ -148,11 +222,7 @@ static inline int iss_exec_step_nofetch_perf(iss_t *iss)
 
   iss_exec_account_cycles(iss, iss->cpu.state.insn_cycles);
 
-  if (iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE)
-  {
-    if (iss->cpu.csr.pcer & (1<<CSR_PCER_INSTR))
-      iss->cpu.csr.pccr[CSR_PCER_INSTR] += 1;
-  }
+  iss->cpu.state.nb_insns++;
   iss_pccr_incr(iss, CSR_PCER_INSTR, 1);
 
   return cycles;
@@ -23,7 +23,44 @@
 
 int insn_cache_init(iss_t *iss);
 void iss_cache_flush(iss_t *iss);
+
+// Discard the decoded instructions of the blocks overlapping the specified
+// range, which must be called when it is written.
+void iss_cache_invalidate(iss_t *iss, iss_addr_t addr, iss_addr_t size);
+
+// Put back all the decoded instructions in their initial state, without
+// moving them, so that they are decoded again with the current settings.
+void iss_cache_reset(iss_t *iss);
 iss_insn_t *insn_cache_get(iss_t *iss, iss_addr_t pc);
 iss_insn_t *insn_cache_get_decoded(iss_t *iss, iss_addr_t pc);
 
+// Return the instruction at the specified address if its block was already
+// allocated, without allocating it otherwise
+iss_insn_t *insn_cache_find(iss_t *iss, iss_addr_t pc);
+iss_insn_cold_t *insn_cold_alloc(iss_t *iss, iss_insn_t *insn);
+
+// Dump the execution count of each executed instruction into a binary file,
+// returns -1 if the file could not be written
+int iss_histogram_dump(iss_t *iss, const char *path);
+
+// Breakpoints of the debugger, the core is halted before executing the
+// instruction at the specified address
+void iss_breakpoint_insert(iss_t *iss, iss_addr_t addr);
+void iss_breakpoint_remove(iss_t *iss, iss_addr_t addr);
+bool iss_breakpoint_is_set(iss_t *iss, iss_addr_t addr);
+
+// Instruction cache. The handler accessing the cache is installed on the
+// instructions of the lines not held by the core, and removed once it holds
+// them, until the cache evicts the specified range.
+void iss_icache_wrap(iss_t *iss, iss_insn_t *insn);
+void iss_icache_unwrap(iss_t *iss, iss_insn_t *insn);
+void iss_icache_evict(iss_t *iss, iss_addr_t addr, iss_addr_t size);
+
+static inline iss_insn_cold_t *insn_cold_get(iss_t *iss, iss_insn_t *insn)
+{
+  if (insn->cold == NULL)
+    insn->cold = insn_cold_alloc(iss, insn);
+  return insn->cold;
+}
+
 #endif
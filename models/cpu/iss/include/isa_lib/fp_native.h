@@ -0,0 +1,295 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __ISA_LIB_FP_NATIVE_H
+#define __ISA_LIB_FP_NATIVE_H
+
+/*
+ *  NATIVE FLOATING-POINT
+ *
+ *  Defining ISS_FP_NATIVE lets the lib_flexfloat_* functions of int.h compute
+ *  the result with the host FPU instead of flexfloat when this is bit-exact
+ *  with IEEE 754, which is the case when the rounding mode is round to nearest
+ *  even and the format is:
+ *    - binary32, on any host with SSE2. Fused multiply-adds also need FMA.
+ *    - binary16, on hosts with F16C. The operation is done in binary32, which
+ *      is exact for add, sub, mul, div and sqrt once rounded to binary16.
+ *  The fflags are taken from the host exceptions accumulated in MXCSR, and
+ *  NaN results are replaced by the canonical NaN as the RISC-V specification
+ *  requires. Other formats, rounding modes and operations go to flexfloat.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(ISS_FP_NATIVE) && defined(__GNUC__) && defined(__SSE2__)
+#define ISS_FP_NATIVE_F32 1
+#if defined(__F16C__)
+#define ISS_FP_NATIVE_F16 1
+#endif
+#if defined(__FMA__)
+#define ISS_FP_NATIVE_FMA 1
+#endif
+#endif
+
+#if defined(ISS_FP_NATIVE_F32)
+#include <immintrin.h>
+#endif
+
+
+static inline bool fp_native_format(uint8_t e, uint8_t m)
+{
+#if defined(ISS_FP_NATIVE_F32)
+  if (e == 8 && m == 23) return true;
+#endif
+#if defined(ISS_FP_NATIVE_F16)
+  if (e == 5 && m == 10) return true;
+#endif
+  return false;
+}
+
+static inline bool fp_native_rne(iss_cpu_state_t *s, unsigned int round)
+{
+  return round == 0 || (round == 7 && s->fcsr.frm == 0);
+}
+
+static inline bool fp_native_enabled(iss_cpu_state_t *s, uint8_t e, uint8_t m, unsigned int round)
+{
+  return fp_native_format(e, m) && fp_native_rne(s, round);
+}
+
+// binary16 fused multiply-adds would be rounded twice, only binary32 ones are
+// native
+static inline bool fp_native_fma_enabled(iss_cpu_state_t *s, uint8_t e, uint8_t m, unsigned int round)
+{
+#if defined(ISS_FP_NATIVE_FMA)
+  return e == 8 && m == 23 && fp_native_rne(s, round);
+#else
+  return false;
+#endif
+}
+
+
+#if defined(ISS_FP_NATIVE_F32)
+
+static inline void fp_native_clear_flags()
+{
+  unsigned int csr;
+  __asm__ volatile("stmxcsr %0" : "=m"(csr));
+  if (csr & 0x3f)
+  {
+    csr &= ~0x3f;
+    __asm__ volatile("ldmxcsr %0" : : "m"(csr));
+  }
+}
+
+// MXCSR has IE, DE, ZE, OE, UE and PE from bit 0 to 5, while fflags has NX,
+// UF, OF, DZ and NV from bit 0 to 4. DE is not an IEEE exception and is
+// dropped
+static inline void fp_native_update_fflags(iss_cpu_state_t *s)
+{
+  unsigned int csr;
+  __asm__ volatile("stmxcsr %0" : "=m"(csr));
+  set_fflags(s, ((csr >> 5) & 1) | ((csr >> 3) & 2) | ((csr >> 1) & 4) | ((csr << 1) & 8) | ((csr & 1) << 4));
+}
+
+static inline float fp_native_unpack(unsigned int a, uint8_t e)
+{
+#if defined(ISS_FP_NATIVE_F16)
+  if (e == 5) return _cvtsh_ss(a & 0xffff);
+#endif
+  float result;
+  memcpy(&result, &a, 4);
+  return result;
+}
+
+static inline unsigned int fp_native_pack(float a, uint8_t e)
+{
+#if defined(ISS_FP_NATIVE_F16)
+  if (e == 5)
+  {
+    unsigned int result = _cvtss_sh(a, _MM_FROUND_TO_NEAREST_INT) & 0xffff;
+    if ((result & 0x7fff) > 0x7c00) return 0x7e00;
+    return result;
+  }
+#endif
+  unsigned int result;
+  memcpy(&result, &a, 4);
+  if ((result & 0x7fffffff) > 0x7f800000) return 0x7fc00000;
+  return result;
+}
+
+// The empty asm statements force the operation to be done between the
+// clearing and the reading of MXCSR, as the compiler does not know that the
+// operation updates it
+#define FP_NATIVE_OP_END(expr)                                                    \
+  unsigned int result = fp_native_pack(expr, e);                                  \
+  __asm__ volatile("" : "+r"(result));                                            \
+  fp_native_update_fflags(s);                                                     \
+  return result;
+
+#define FP_NATIVE_OP1(name, expr)                                                 \
+static inline unsigned int fp_native_##name(iss_cpu_state_t *s, unsigned int a, uint8_t e) \
+{                                                                                 \
+  fp_native_clear_flags();                                                        \
+  __asm__ volatile("" : "+r"(a));                                                 \
+  float fa = fp_native_unpack(a, e);                                              \
+  FP_NATIVE_OP_END(expr)                                                          \
+}
+
+#define FP_NATIVE_OP2(name, expr)                                                 \
+static inline unsigned int fp_native_##name(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e) \
+{                                                                                 \
+  fp_native_clear_flags();                                                        \
+  __asm__ volatile("" : "+r"(a), "+r"(b));                                        \
+  float fa = fp_native_unpack(a, e), fb = fp_native_unpack(b, e);                 \
+  FP_NATIVE_OP_END(expr)                                                          \
+}
+
+#define FP_NATIVE_OP3(name, expr)                                                 \
+static inline unsigned int fp_native_##name(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e) \
+{                                                                                 \
+  fp_native_clear_flags();                                                        \
+  __asm__ volatile("" : "+r"(a), "+r"(b), "+r"(c));                               \
+  float fa = fp_native_unpack(a, e), fb = fp_native_unpack(b, e), fc = fp_native_unpack(c, e); \
+  FP_NATIVE_OP_END(expr)                                                          \
+}
+
+FP_NATIVE_OP2(add, fa + fb)
+FP_NATIVE_OP2(sub, fa - fb)
+FP_NATIVE_OP2(mul, fa * fb)
+FP_NATIVE_OP2(div, fa / fb)
+FP_NATIVE_OP1(sqrt, _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(fa))))
+
+#if defined(ISS_FP_NATIVE_FMA)
+#define FP_NATIVE_FMA(a, b, c) _mm_cvtss_f32(_mm_fmadd_ss(_mm_set_ss(a), _mm_set_ss(b), _mm_set_ss(c)))
+#else
+#define FP_NATIVE_FMA(a, b, c) 0.0f
+#endif
+
+// RISC-V raises NV for infinity times zero even when the addend is a quiet
+// NaN, while x86 does not
+static inline float fp_native_fma(iss_cpu_state_t *s, float a, float b, float c)
+{
+  float result = FP_NATIVE_FMA(a, b, c);
+  if (__builtin_isnan(result) && __builtin_isnan(c) && ((__builtin_isinf(a) && b == 0) || (a == 0 && __builtin_isinf(b))))
+    set_fflags(s, 1 << 4);
+  return result;
+}
+
+FP_NATIVE_OP3(madd, fp_native_fma(s, fa, fb, fc))
+FP_NATIVE_OP3(msub, fp_native_fma(s, fa, fb, -fc))
+FP_NATIVE_OP3(nmsub, fp_native_fma(s, -fa, fb, fc))
+FP_NATIVE_OP3(nmadd, fp_native_fma(s, -fa, fb, -fc))
+
+// Conversions between binary32 and binary16, es and ed being the exponent
+// widths of the source and destination formats
+static inline unsigned int fp_native_cvt(iss_cpu_state_t *s, unsigned int a, uint8_t es, uint8_t ed)
+{
+  fp_native_clear_flags();
+  __asm__ volatile("" : "+r"(a));
+  unsigned int result = fp_native_pack(fp_native_unpack(a, es), ed);
+  __asm__ volatile("" : "+r"(result));
+  fp_native_update_fflags(s);
+  return result;
+}
+
+#else
+
+#define FP_NATIVE_OP1(name, expr) \
+static inline unsigned int fp_native_##name(iss_cpu_state_t *s, unsigned int a, uint8_t e) { return 0; }
+#define FP_NATIVE_OP2(name, expr) \
+static inline unsigned int fp_native_##name(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e) { return 0; }
+#define FP_NATIVE_OP3(name, expr) \
+static inline unsigned int fp_native_##name(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e) { return 0; }
+
+FP_NATIVE_OP2(add, 0)
+FP_NATIVE_OP2(sub, 0)
+FP_NATIVE_OP2(mul, 0)
+FP_NATIVE_OP2(div, 0)
+FP_NATIVE_OP1(sqrt, 0)
+FP_NATIVE_OP3(madd, 0)
+FP_NATIVE_OP3(msub, 0)
+FP_NATIVE_OP3(nmsub, 0)
+FP_NATIVE_OP3(nmadd, 0)
+
+static inline unsigned int fp_native_cvt(iss_cpu_state_t *s, unsigned int a, uint8_t es, uint8_t ed) { return 0; }
+
+#endif
+
+
+// Comparisons do not round and only raise NV, which is computed from the
+// operands: feq only signals on signaling NaNs, flt and fle on any NaN
+static inline bool fp_native_is_nan(unsigned int a, uint8_t e)
+{
+  if (e == 5) return (a & 0x7fff) > 0x7c00;
+  return (a & 0x7fffffff) > 0x7f800000;
+}
+
+static inline bool fp_native_is_snan(unsigned int a, uint8_t e)
+{
+  if (e == 5) return fp_native_is_nan(a, e) && !(a & 0x200);
+  return fp_native_is_nan(a, e) && !(a & 0x400000);
+}
+
+static inline unsigned int fp_native_eq(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e)
+{
+  if (fp_native_is_nan(a, e) || fp_native_is_nan(b, e))
+  {
+    if (fp_native_is_snan(a, e) || fp_native_is_snan(b, e)) set_fflags(s, 1 << 4);
+    return 0;
+  }
+  unsigned int mask = e == 5 ? 0x7fff : 0x7fffffff;
+  // +0 and -0 are equal
+  return (a & (mask | (mask + 1))) == (b & (mask | (mask + 1))) || ((a | b) & mask) == 0;
+}
+
+// Orders the values as signed integers, by mapping negative ones below
+// positive ones, -0 and +0 being mapped to the same value
+static inline int64_t fp_native_order(unsigned int a, uint8_t e)
+{
+  unsigned int sign = e == 5 ? 0x8000 : 0x80000000;
+  if (a & sign) return -(int64_t)(a & (sign - 1));
+  return a;
+}
+
+static inline unsigned int fp_native_lt(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e)
+{
+  if (e == 5) { a &= 0xffff; b &= 0xffff; }
+  if (fp_native_is_nan(a, e) || fp_native_is_nan(b, e))
+  {
+    set_fflags(s, 1 << 4);
+    return 0;
+  }
+  return fp_native_order(a, e) < fp_native_order(b, e);
+}
+
+static inline unsigned int fp_native_le(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e)
+{
+  if (e == 5) { a &= 0xffff; b &= 0xffff; }
+  if (fp_native_is_nan(a, e) || fp_native_is_nan(b, e))
+  {
+    set_fflags(s, 1 << 4);
+    return 0;
+  }
+  return fp_native_order(a, e) <= fp_native_order(b, e);
+}
+
+#endif
@@ -1310,6 +1310,8 @@ static inline void update_fflags_fenv(iss_cpu_state_t *s)
   set_fflags(s, flags);
 }
 
+#include "isa_lib/fp_native.h"
+
 // Inspired by https://stackoverflow.com/a/38470183
 // TODO PROPER ROUNDING WITH FLAGS
 static inline int32_t double_to_int (double dbl) {
@@ -1469,6 +1471,7 @@ static inline void restoreFFRoundingMode(unsigned int mode)
 }
 
 static inline unsigned int lib_flexfloat_madd_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_fma_enabled(s, e, m, round)) return fp_native_madd(s, a, b, c, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_madd(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1476,6 +1479,7 @@ static inline unsigned int lib_flexfloat_madd_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_msub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_fma_enabled(s, e, m, round)) return fp_native_msub(s, a, b, c, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_msub(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1483,6 +1487,7 @@ static inline unsigned int lib_flexfloat_msub_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_nmadd_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_fma_enabled(s, e, m, round)) return fp_native_nmadd(s, a, b, c, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_nmadd(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1490,6 +1495,7 @@ static inline unsigned int lib_flexfloat_nmadd_round(iss_cpu_state_t *s, unsigne
 }
 
 static inline unsigned int lib_flexfloat_nmsub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, unsigned int c, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_fma_enabled(s, e, m, round)) return fp_native_nmsub(s, a, b, c, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_nmsub(s, a, b, c, e, m);
   restoreFFRoundingMode(old);
@@ -1497,6 +1503,7 @@ static inline unsigned int lib_flexfloat_nmsub_round(iss_cpu_state_t *s, unsigne
 }
 
 static inline unsigned int lib_flexfloat_add_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_enabled(s, e, m, round)) return fp_native_add(s, a, b, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_add(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1504,6 +1511,7 @@ static inline unsigned int lib_flexfloat_add_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_sub_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_enabled(s, e, m, round)) return fp_native_sub(s, a, b, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_sub(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1511,6 +1519,7 @@ static inline unsigned int lib_flexfloat_sub_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_mul_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_enabled(s, e, m, round)) return fp_native_mul(s, a, b, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_mul(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1518,6 +1527,7 @@ static inline unsigned int lib_flexfloat_mul_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_div_round(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_enabled(s, e, m, round)) return fp_native_div(s, a, b, e);
   int old = setFFRoundingMode(s, round);
   unsigned int result = lib_flexfloat_div(s, a, b, e, m);
   restoreFFRoundingMode(old);
@@ -1532,6 +1542,7 @@ static inline unsigned int lib_flexfloat_avg_round(iss_cpu_state_t *s, unsigned
 }
 
 static inline unsigned int lib_flexfloat_sqrt_round(iss_cpu_state_t *s, unsigned int a, uint8_t e, uint8_t m, unsigned int round) {
+  if (fp_native_enabled(s, e, m, round)) return fp_native_sqrt(s, a, e);
   int old = setFFRoundingMode(s, round);
   FF_INIT_1(a, e, m)
   feclearexcept(FE_ALL_EXCEPT);
@@ -1634,6 +1645,7 @@ static inline unsigned int lib_flexfloat_cvt_ff_lu_round(iss_cpu_state_t *s, uin
 }
 
 static inline int lib_flexfloat_cvt_ff_ff_round(iss_cpu_state_t *s, unsigned int a, uint8_t es, uint8_t ms, uint8_t ed, uint8_t md, unsigned int round) {
+  if (fp_native_format(es, ms) && fp_native_enabled(s, ed, md, round)) return fp_native_cvt(s, a, es, ed);
   int old = setFFRoundingMode(s, round);
   FF_INIT_1(a, es, ms)
   ff_cast(&ff_res, &ff_a, (flexfloat_desc_t) {ed,md});
@@ -1650,6 +1662,7 @@ static inline unsigned int lib_flexfloat_fmv_ff_x(iss_cpu_state_t *s, unsigned i
 }
 
 static inline unsigned int lib_flexfloat_eq(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (fp_native_format(e, m)) return fp_native_eq(s, a, b, e);
   FF_INIT_2(a, b, e, m)
   feclearexcept(FE_ALL_EXCEPT);
   int32_t res = ff_eq(&ff_a, &ff_b);
@@ -1658,6 +1671,7 @@ static inline unsigned int lib_flexfloat_eq(iss_cpu_state_t *s, unsigned int a,
 }
 
 static inline unsigned int lib_flexfloat_lt(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (fp_native_format(e, m)) return fp_native_lt(s, a, b, e);
   FF_INIT_2(a, b, e, m)
   feclearexcept(FE_ALL_EXCEPT);
   int32_t res = ff_lt(&ff_a, &ff_b);
@@ -1666,6 +1680,7 @@ static inline unsigned int lib_flexfloat_lt(iss_cpu_state_t *s, unsigned int a,
 }
 
 static inline unsigned int lib_flexfloat_le(iss_cpu_state_t *s, unsigned int a, unsigned int b, uint8_t e, uint8_t m) {
+  if (fp_native_format(e, m)) return fp_native_le(s, a, b, e);
   FF_INIT_2(a, b, e, m)
   feclearexcept(FE_ALL_EXCEPT);
   int32_t res = ff_le(&ff_a, &ff_b);
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __ISA_LIB_VEC_H
+#define __ISA_LIB_VEC_H
+
+/*
+ *  LANE OPERATIONS
+ *
+ *  Operations on a 32-bit register seen as 2 lanes of 16 bits (_16 suffix) or
+ *  4 lanes of 8 bits (_8 suffix), lane 0 being the least significant one.
+ *  Results are bit-exact with the lib_VEC_* functions of int.h.
+ *
+ *  Elementwise operations use the compiler vector extensions, so that the
+ *  compiler can use the host SIMD instructions, and dot products use SSE2 when
+ *  available. Defining ISS_VEC_NO_HOST_SIMD selects the portable version,
+ *  which processes each lane separately.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(ISS_VEC_NO_HOST_SIMD) && defined(__GNUC__)
+#define ISS_VEC_HOST_SIMD 1
+#endif
+
+#if defined(ISS_VEC_HOST_SIMD) && defined(__SSE2__)
+#include <emmintrin.h>
+#define ISS_VEC_HOST_SSE2 1
+#endif
+
+#if defined(ISS_VEC_HOST_SIMD) && defined(__SSSE3__)
+#include <tmmintrin.h>
+#define ISS_VEC_HOST_SSSE3 1
+#endif
+
+
+
+// Replicate the lowest lane on all lanes, for the scalar (.sc and .sci) variants
+static inline uint32_t vec_splat_8(uint32_t a)
+{
+  return (a & 0xff) * 0x01010101;
+}
+
+static inline uint32_t vec_splat_16(uint32_t a)
+{
+  return (a & 0xffff) * 0x00010001;
+}
+
+#if defined(ISS_VEC_HOST_SIMD)
+
+typedef int8_t vec_int8_t __attribute__((vector_size(4)));
+typedef uint8_t vec_uint8_t __attribute__((vector_size(4)));
+typedef int16_t vec_int16_t __attribute__((vector_size(4)));
+typedef uint16_t vec_uint16_t __attribute__((vector_size(4)));
+
+#define VEC_LANES(elemType)                                                       \
+static inline vec_##elemType vec_to_##elemType(uint32_t a) {                      \
+  vec_##elemType v;                                                               \
+  memcpy(&v, &a, 4);                                                              \
+  return v;                                                                       \
+}                                                                                 \
+                                                                                  \
+template<typename T> static inline uint32_t vec_from_##elemType(T v) {            \
+  uint32_t a;                                                                     \
+  memcpy(&a, &v, 4);                                                              \
+  return a;                                                                       \
+}
+
+VEC_LANES(int8_t)
+VEC_LANES(uint8_t)
+VEC_LANES(int16_t)
+VEC_LANES(uint16_t)
+
+// Lanes are combined with the vector operators, which already wrap around on
+// each lane
+#define VEC_WRAP(elemType, x) (x)
+
+#define VEC_LANE_OP(name, elemType, elemSize, expr)                               \
+static inline uint32_t vec_##name##_##elemSize(uint32_t a, uint32_t b) {          \
+  vec_##elemType va = vec_to_##elemType(a);                                       \
+  vec_##elemType vb = vec_to_##elemType(b);                                       \
+  return vec_from_##elemType(expr);                                               \
+}
+
+#define VEC_LANE_OP1(name, elemType, elemSize, expr)                              \
+static inline uint32_t vec_##name##_##elemSize(uint32_t a) {                      \
+  vec_##elemType va = vec_to_##elemType(a);                                       \
+  return vec_from_##elemType(expr);                                               \
+}
+
+#else
+
+// Lanes are promoted to int by the C operators and must be truncated where
+// the result of the operation is used on the lane width
+#define VEC_WRAP(elemType, x) ((elemType)(x))
+
+#define VEC_LANE_OP(name, elemType, elemSize, expr)                               \
+static inline uint32_t vec_##name##_##elemSize(uint32_t a, uint32_t b) {          \
+  uint32_t out = 0;                                                               \
+  for (int i = 0; i < 32; i += elemSize) {                                        \
+    elemType va = (elemType)(a >> i);                                             \
+    elemType vb = (elemType)(b >> i);                                             \
+    out |= ((uint32_t)(elemType)(expr) & ((1U << elemSize) - 1)) << i;            \
+  }                                                                               \
+  return out;                                                                     \
+}
+
+#define VEC_LANE_OP1(name, elemType, elemSize, expr)                              \
+static inline uint32_t vec_##name##_##elemSize(uint32_t a) {                      \
+  uint32_t out = 0;                                                               \
+  for (int i = 0; i < 32; i += elemSize) {                                        \
+    elemType va = (elemType)(a >> i);                                             \
+    out |= ((uint32_t)(elemType)(expr) & ((1U << elemSize) - 1)) << i;            \
+  }                                                                               \
+  return out;                                                                     \
+}
+
+#endif
+
+
+
+// Lanes are selected with the conditional operator, which also works lane-wise
+// on vectors and lets the compiler use the host min and max instructions.
+// SSE2 misses most of them, in which case the comparison result, which has
+// all bits set on the lanes where it is true, is rather used as a mask so that
+// the compiler does not go back to scalar code.
+#if defined(ISS_VEC_HOST_SSE2) && !defined(__SSE4_1__)
+#define VEC_SEL(cond, x, y) (((x) & (__typeof__(x))(cond)) | ((y) & ~(__typeof__(x))(cond)))
+#else
+#define VEC_SEL(cond, x, y) ((cond) ? (x) : (y))
+#endif
+
+#if defined(ISS_VEC_HOST_SIMD)
+#define VEC_LANE_CMP(name, elemType, elemSize, oper)                              \
+  VEC_LANE_OP(name, elemType, elemSize, (va oper vb))
+#else
+#define VEC_LANE_CMP(name, elemType, elemSize, oper)                              \
+  VEC_LANE_OP(name, elemType, elemSize, (va oper vb ? -1 : 0))
+#endif
+
+#define VEC_LANE_OPS(elemSize, sType, uType)                                      \
+VEC_LANE_OP(add, sType, elemSize, va + vb)                                        \
+VEC_LANE_OP(sub, sType, elemSize, va - vb)                                        \
+VEC_LANE_OP(and, sType, elemSize, va & vb)                                        \
+VEC_LANE_OP(or, sType, elemSize, va | vb)                                         \
+VEC_LANE_OP(xor, sType, elemSize, va ^ vb)                                        \
+VEC_LANE_OP(avg, sType, elemSize, VEC_WRAP(sType, va + vb) >> 1)                  \
+VEC_LANE_OP(avgu, uType, elemSize, VEC_WRAP(uType, va + vb) >> 1)                 \
+VEC_LANE_OP(avg4, sType, elemSize, VEC_WRAP(sType, va + vb) >> 2)                 \
+VEC_LANE_OP(subavg, sType, elemSize, VEC_WRAP(sType, va - vb) >> 1)               \
+VEC_LANE_OP(subavg4, sType, elemSize, VEC_WRAP(sType, va - vb) >> 2)              \
+VEC_LANE_OP(srl, uType, elemSize, va >> (vb & (elemSize - 1)))                    \
+VEC_LANE_OP(sra, sType, elemSize, va >> (vb & (elemSize - 1)))                    \
+VEC_LANE_OP(sll, uType, elemSize, va << (vb & (elemSize - 1)))                    \
+VEC_LANE_CMP(cmpeq, sType, elemSize, ==)                                          \
+VEC_LANE_CMP(cmpne, sType, elemSize, !=)                                          \
+VEC_LANE_CMP(cmpgt, sType, elemSize, >)                                           \
+VEC_LANE_CMP(cmpge, sType, elemSize, >=)                                          \
+VEC_LANE_CMP(cmplt, sType, elemSize, <)                                           \
+VEC_LANE_CMP(cmple, sType, elemSize, <=)                                          \
+VEC_LANE_CMP(cmpgtu, uType, elemSize, >)                                          \
+VEC_LANE_CMP(cmpgeu, uType, elemSize, >=)                                         \
+VEC_LANE_CMP(cmpltu, uType, elemSize, <)                                          \
+VEC_LANE_CMP(cmpleu, uType, elemSize, <=)                                         \
+VEC_LANE_OP(min, sType, elemSize, VEC_SEL(va > vb, vb, va))                \
+VEC_LANE_OP(minu, uType, elemSize, VEC_SEL(va > vb, vb, va))               \
+VEC_LANE_OP(max, sType, elemSize, VEC_SEL(va > vb, va, vb))                \
+VEC_LANE_OP(maxu, uType, elemSize, VEC_SEL(va > vb, va, vb))               \
+VEC_LANE_OP1(abs, sType, elemSize, VEC_SEL(va < 0, -va, va))
+
+VEC_LANE_OPS(8, int8_t, uint8_t)
+VEC_LANE_OPS(16, int16_t, uint16_t)
+
+
+
+/*
+ *  DOT PRODUCTS
+ *
+ *  The sums are computed modulo 2^32, like the 32-bit accumulator of the core.
+ */
+
+static inline uint32_t vec_dotup_16(uint32_t a, uint32_t b)
+{
+  return (a & 0xffff) * (b & 0xffff) + (a >> 16) * (b >> 16);
+}
+
+static inline uint32_t vec_dotusp_16(uint32_t a, uint32_t b)
+{
+  return (uint32_t)((int32_t)(a & 0xffff) * (int16_t)b) + (uint32_t)((int32_t)(a >> 16) * (int16_t)(b >> 16));
+}
+
+#if defined(ISS_VEC_HOST_SSE2)
+
+static inline __m128i vec_sse_sext_8(uint32_t a)
+{
+  __m128i v = _mm_cvtsi32_si128(a);
+  return _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+}
+
+static inline __m128i vec_sse_zext_8(uint32_t a)
+{
+  return _mm_unpacklo_epi8(_mm_cvtsi32_si128(a), _mm_setzero_si128());
+}
+
+// Each lane is at most 16 bits once extended, so that products and partial
+// sums of pmaddwd fit in 32 bits
+static inline uint32_t vec_sse_madd(__m128i a, __m128i b)
+{
+  __m128i sum = _mm_madd_epi16(a, b);
+  sum = _mm_add_epi32(sum, _mm_srli_epi64(sum, 32));
+  return _mm_cvtsi128_si32(sum);
+}
+
+static inline uint32_t vec_dotsp_16(uint32_t a, uint32_t b)
+{
+  return vec_sse_madd(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b));
+}
+
+static inline uint32_t vec_dotsp_8(uint32_t a, uint32_t b)
+{
+  return vec_sse_madd(vec_sse_sext_8(a), vec_sse_sext_8(b));
+}
+
+static inline uint32_t vec_dotup_8(uint32_t a, uint32_t b)
+{
+  return vec_sse_madd(vec_sse_zext_8(a), vec_sse_zext_8(b));
+}
+
+static inline uint32_t vec_dotusp_8(uint32_t a, uint32_t b)
+{
+  return vec_sse_madd(vec_sse_zext_8(a), vec_sse_sext_8(b));
+}
+
+#else
+
+static inline uint32_t vec_dotsp_16(uint32_t a, uint32_t b)
+{
+  return (uint32_t)((int16_t)a * (int16_t)b) + (uint32_t)((int16_t)(a >> 16) * (int16_t)(b >> 16));
+}
+
+#define VEC_DOT_8(name, typeA, typeB)                                             \
+static inline uint32_t vec_##name##_8(uint32_t a, uint32_t b) {                   \
+  return (typeA)a * (typeB)b + (typeA)(a >> 8) * (typeB)(b >> 8) +                \
+    (typeA)(a >> 16) * (typeB)(b >> 16) + (typeA)(a >> 24) * (typeB)(b >> 24);    \
+}
+
+VEC_DOT_8(dotsp, int8_t, int8_t)
+VEC_DOT_8(dotup, uint8_t, uint8_t)
+VEC_DOT_8(dotusp, uint8_t, int8_t)
+
+#endif
+
+static inline uint32_t vec_sdotsp_16(uint32_t acc, uint32_t a, uint32_t b) { return acc + vec_dotsp_16(a, b); }
+static inline uint32_t vec_sdotup_16(uint32_t acc, uint32_t a, uint32_t b) { return acc + vec_dotup_16(a, b); }
+static inline uint32_t vec_sdotusp_16(uint32_t acc, uint32_t a, uint32_t b) { return acc + vec_dotusp_16(a, b); }
+static inline uint32_t vec_sdotsp_8(uint32_t acc, uint32_t a, uint32_t b) { return acc + vec_dotsp_8(a, b); }
+static inline uint32_t vec_sdotup_8(uint32_t acc, uint32_t a, uint32_t b) { return acc + vec_dotup_8(a, b); }
+static inline uint32_t vec_sdotusp_8(uint32_t acc, uint32_t a, uint32_t b) { return acc + vec_dotusp_8(a, b); }
+
+
+
+/*
+ *  SHUFFLES
+ *
+ *  Each lane of the result is the lane of a selected by the corresponding
+ *  lane of b.
+ */
+
+static inline uint32_t vec_shuffle_16(uint32_t a, uint32_t b)
+{
+  uint32_t low = b & 1 ? a >> 16 : a & 0xffff;
+  uint32_t high = b & (1 << 16) ? a & 0xffff0000 : a << 16;
+  return low | high;
+}
+
+static inline uint32_t vec_shuffle_8(uint32_t a, uint32_t b)
+{
+#if defined(ISS_VEC_HOST_SSSE3)
+  return _mm_cvtsi128_si32(_mm_shuffle_epi8(_mm_cvtsi32_si128(a), _mm_cvtsi32_si128(b & 0x03030303)));
+#else
+  return ((a >> ((b & 0x3) << 3)) & 0xff) |
+    (((a >> (((b >> 8) & 0x3) << 3)) & 0xff) << 8) |
+    (((a >> (((b >> 16) & 0x3) << 3)) & 0xff) << 16) |
+    ((a >> (((b >> 24) & 0x3) << 3)) << 24);
+#endif
+}
+
+#endif
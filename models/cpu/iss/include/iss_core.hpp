@@ -35,6 +35,7 @@ static inline void iss_exec_insn_terminate(iss_t *iss);
 #include "lsu.hpp"
 #include "prefetcher.hpp"
 #include "insn_cache.hpp"
+#include "jit.hpp"
 #include "irq.hpp"
 #include "exceptions.hpp"
 #include "exec.hpp"
@@ -45,12 +46,17 @@ void iss_reset(iss_t *iss);
 void iss_start(iss_t *iss);
 
 void iss_register_debug_info(iss_t *iss, const char *binary);
+bool iss_has_debug_info();
 
 void iss_pc_set(iss_t *iss, iss_addr_t value);
 
 iss_insn_t *iss_decode_pc(iss_t *cpu, iss_insn_t *pc);
 iss_insn_t *iss_decode_pc_noexec(iss_t *cpu, iss_insn_t *pc);
 void iss_decode_activate_isa(iss_t *cpu, char *isa);
+iss_decode_cache_t *iss_decode_cache_get(iss_t *cpu, const char *isa);
+// Decodes an opcode with the functions generated for each ISA, or by walking
+// the decoder trees if use_tree is true, which is kept as a reference.
+int iss_decode_opcode(iss_t *cpu, iss_decoded_insn_t *insn, iss_opcode_t opcode, bool use_tree);
 
 
 
@@ -62,4 +68,9 @@ bool iss_csr_write(iss_t *iss, iss_reg_t reg, iss_reg_t value);
 
 int iss_trace_pc_info(iss_addr_t addr, const char **func, const char **inline_func, const char **file, int *line);
 
+// Returns the name of the function containing the address and its address
+// range, or NULL if it is unknown. The name stays valid until the end of the
+// simulation, and is the same pointer for all addresses of the function.
+const char *iss_debug_func(iss_addr_t addr, iss_addr_t *start, iss_addr_t *end);
+
 #endif
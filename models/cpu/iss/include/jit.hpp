@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#ifndef __CPU_ISS_ISS_JIT_HPP
+#define __CPU_ISS_ISS_JIT_HPP
+
+#include "types.hpp"
+
+// Returned by a translated block when it could not execute any instruction,
+// in which case the instruction must be executed by the interpreter
+#define ISS_JIT_NONE (-2)
+
+// Default number of times a block head must be reached before the block
+// is translated
+#define ISS_JIT_THRESHOLD 64
+
+// Maximum number of instructions in a translated block
+#define ISS_JIT_MAX_INSNS 64
+
+// Maximum number of instructions executed inline without going back to the
+// clock engine. This must stay below the size of the clock engine circular
+// buffer, which is the longest distance it can advance to.
+#define ISS_JIT_MAX_RUN 16
+
+// Size of the host code buffer of each core
+#define ISS_JIT_CODE_SIZE (1<<20)
+
+// Allocate the code buffer. Returns -1 if the JIT can not be used on this
+// host, in which case it stays disabled.
+int iss_jit_init(iss_t *iss);
+
+// Drop all translated blocks. Must be called when the instruction cache
+// is flushed.
+void iss_jit_flush(iss_t *iss);
+
+// Drop all translated blocks while keeping the instructions. Must be called
+// when some instructions are invalidated, as translated blocks contain
+// copies of their operands.
+void iss_jit_invalidate(iss_t *iss);
+
+// Translate the block starting at the specified instruction
+void iss_jit_translate(iss_t *iss, iss_insn_t *insn);
+
+static inline void iss_jit_profile(iss_t *iss, iss_insn_t *insn)
+{
+  if (++insn->jit_count >= iss->cpu.jit.threshold)
+  {
+    insn->jit_count = 0;
+    iss_jit_translate(iss, insn);
+  }
+}
+
+#endif
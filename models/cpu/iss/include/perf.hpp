@@ -34,6 +34,38 @@ static inline void iss_pccr_account_event(iss_t *iss, unsigned int event, int in
   //if (cpu->traceEvent) sim_trace_event_incr(cpu, event, incr);
 }
 
+// Events whose counters do not need the instruction handlers checking
+// everything. The cycle and instruction counters are computed from the
+// running totals, and the external ones are counted outside the core.
+#define ISS_PCER_LAZY_EVENTS (CSR_PCER_EVENT_MASK(CSR_PCER_CYCLES) | CSR_PCER_EVENT_MASK(CSR_PCER_INSTR) | \
+  ~((1 << CSR_PCER_NB_INTERNAL_EVENTS) - 1))
+
+// Bring the cycle and instruction counters up to date with the running
+// totals. This must be called before the counters are read and before the
+// counting configuration is modified.
+static inline void iss_pccr_update(iss_t *iss)
+{
+  iss_cpu_state_t *state = &iss->cpu.state;
+
+  if (iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE)
+  {
+    if (iss->cpu.csr.pcer & CSR_PCER_EVENT_MASK(CSR_PCER_CYCLES))
+      iss->cpu.csr.pccr[CSR_PCER_CYCLES] += state->nb_cycles - state->pccr_nb_cycles;
+    if (iss->cpu.csr.pcer & CSR_PCER_EVENT_MASK(CSR_PCER_INSTR))
+      iss->cpu.csr.pccr[CSR_PCER_INSTR] += state->nb_insns - state->pccr_nb_insns;
+  }
+
+  state->pccr_nb_cycles = state->nb_cycles;
+  state->pccr_nb_insns = state->nb_insns;
+}
+
+// Tell if some of the active counters are only updated by the instruction
+// handlers checking everything
+static inline bool iss_pccr_check_all(iss_t *iss)
+{
+  return (iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE) && (iss->cpu.csr.pcer & ~ISS_PCER_LAZY_EVENTS);
+}
+
 static inline void iss_perf_account_taken_branch(iss_t *iss)
 {
   iss->cpu.state.insn_cycles += 2;  
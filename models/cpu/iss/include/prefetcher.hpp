@@ -27,11 +27,11 @@
 
 static inline void prefetcher_init(iss_t *iss);
 static inline iss_opcode_t prefetcher_get_word(iss_t *iss, iss_addr_t addr);
-static inline iss_opcode_t prefetcher_fill(iss_t *iss, iss_addr_t addr);
+static inline void prefetcher_fill(iss_t *iss, iss_addr_t addr);
 
 
 
-static inline iss_opcode_t prefetcher_fill(iss_t *iss, iss_addr_t addr)
+static inline void prefetcher_fill(iss_t *iss, iss_addr_t addr)
 {
   iss_prefetcher_t *prefetcher = &iss->cpu.prefetcher;
   // TODO this is a temporary work-around until the vp can split all fetch requests
@@ -51,8 +51,10 @@ static inline iss_opcode_t prefetcher_get_word(iss_t *iss, iss_addr_t addr)
 {
   iss_prefetcher_t *prefetcher = &iss->cpu.prefetcher;
 
+  // Compare the addresses rather than the sign of the index, as after a flush
+  // (addr == -1) the index of address 0 would otherwise look valid
   int index = addr - prefetcher->addr;
-  if (index< 0 || index + ISS_OPCODE_MAX_SIZE > ISS_PREFETCHER_SIZE)
+  if (addr < prefetcher->addr || index + ISS_OPCODE_MAX_SIZE > ISS_PREFETCHER_SIZE)
   {
     prefetcher_fill(iss, addr);
     index = addr - prefetcher->addr;
@@ -21,6 +21,8 @@
 #ifndef __CPU_ISS_PULP_V2_HPP
 #define __CPU_ISS_PULP_V2_HPP
 
+#include "isa_lib/vec.h"
+
 #define PULPV2_HWLOOP_LPSTART0 0
 #define PULPV2_HWLOOP_LPEND0   1
 #define PULPV2_HWLOOP_LPCOUNT0 2
@@ -540,7 +542,10 @@ static inline iss_insn_t *hwloop_check_exec(iss_t *iss, iss_insn_t *insn)
 
   // First execute the instructions as it is the last one of the loop body.
   // The real handler has been saved when the loop was started.
-  iss_insn_t *insn_next = iss_exec_insn_handler(iss, insn, insn->hwloop_handler);
+  iss_insn_t *insn_next = iss_exec_insn_handler(iss, insn, insn->cold->hwloop_handler);
+
+  // The instruction was not executed as it has a breakpoint
+  if (insn_next == insn) return insn;
 
   // First check HW loop 0 as it has higher priority compared to HW loop 1
   if (iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPCOUNT0] && iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND0] == pc)
@@ -575,10 +580,11 @@ static inline void hwloop_set_start(iss_t *iss, iss_insn_t *insn, int index, iss
 static inline void hwloop_set_end(iss_t *iss, iss_insn_t *insn, int index, iss_reg_t end)
 {
   iss_insn_t *end_insn = insn_cache_get_decoded(iss, end);
+  iss_insn_cold_t *cold = insn_cold_get(iss, end_insn);
 
-  if (end_insn->hwloop_handler == NULL)
+  if (cold->hwloop_handler == NULL)
   {
-    end_insn->hwloop_handler = end_insn->handler;
+    cold->hwloop_handler = end_insn->handler;
     end_insn->handler = hwloop_check_exec;
     end_insn->fast_handler = hwloop_check_exec;
   }
@@ -734,283 +740,287 @@ static inline iss_insn_t *p_elw_exec(iss_t *iss, iss_insn_t *insn)
 }
 
 
-#define PV_OP_RS_EXEC(insn_name,lib_name)                                           \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)                \
+// The packed-SIMD instructions are executed with the lane operations of
+// isa_lib/vec.h. The scalar variants (.sc and .sci) replicate the scalar on all
+// lanes and then execute the vector operation.
+
+#define PV_OP_RS_EXEC(insn_name)                                                             \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_int16_t_to_int32_t, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), REG_GET(1)));                                  \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sc_h_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_sc_h_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_int16_t_to_int32_t, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(REG_GET(1))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sci_h_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_sci_h_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_int16_t_to_int32_t, REG_GET(0), SIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(SIM_GET(0))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)                \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_int8_t_to_int32_t, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), REG_GET(1)));                                   \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sc_b_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_sc_b_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_int8_t_to_int32_t, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(REG_GET(1))));                      \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sci_b_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_sci_b_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_int8_t_to_int32_t, REG_GET(0), SIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(SIM_GET(0))));                      \
   return insn->next;                                                                         \
 }
 
 
 
-#define PV_OP_RU_EXEC(insn_name,lib_name)                                           \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)                \
+#define PV_OP_RU_EXEC(insn_name)                                                             \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_uint16_t_to_uint32_t, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), REG_GET(1)));                                  \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sc_h_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_sc_h_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_uint16_t_to_uint32_t, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(REG_GET(1))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sci_h_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_sci_h_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_uint16_t_to_uint32_t, REG_GET(0), UIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(UIM_GET(0))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)                \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_uint8_t_to_uint32_t, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), REG_GET(1)));                                   \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sc_b_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_sc_b_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_uint8_t_to_uint32_t, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(REG_GET(1))));                      \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_sci_b_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_sci_b_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_uint8_t_to_uint32_t, REG_GET(0), UIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(UIM_GET(0))));                      \
   return insn->next;                                                                         \
 }
 
 
-#define PV_OP_RS_EXEC2(insn_name,lib_name)                                           \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)                \
+#define PV_OP_RS_EXEC2(insn_name)                                                            \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_16, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), REG_GET(1)));                                  \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_16, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(REG_GET(1))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_16, REG_GET(0), SIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(SIM_GET(0))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)                \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_8, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), REG_GET(1)));                                   \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_8, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(REG_GET(1))));                      \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_8, REG_GET(0), SIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(SIM_GET(0))));                      \
   return insn->next;                                                                         \
 }
 
 
 
-#define PV_OP_RU_EXEC2(insn_name,lib_name)                                           \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)                \
+#define PV_OP_RU_EXEC2(insn_name)                                                            \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_16, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), REG_GET(1)));                                  \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_16, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(REG_GET(1))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_16, REG_GET(0), UIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), vec_splat_16(UIM_GET(0))));                    \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)                \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_8, REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), REG_GET(1)));                                   \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_8, REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(REG_GET(1))));                      \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL2(lib_VEC_##lib_name##_SC_8, REG_GET(0), UIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), vec_splat_8(UIM_GET(0))));                      \
   return insn->next;                                                                         \
 }
 
 
-#define PV_OP_RRS_EXEC2(insn_name,lib_name)                                           \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)                \
+#define PV_OP_RRS_EXEC2(insn_name)                                                           \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_16, REG_GET(2), REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(2), REG_GET(0), REG_GET(1)));                      \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_16, REG_GET(2), REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(2), REG_GET(0), vec_splat_16(REG_GET(1))));        \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_16, REG_GET(0), REG_GET(1), SIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), REG_GET(1), vec_splat_16(SIM_GET(0))));        \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)                \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_8, REG_GET(2), REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(2), REG_GET(0), REG_GET(1)));                       \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_8, REG_GET(2), REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(2), REG_GET(0), vec_splat_8(REG_GET(1))));          \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_8, REG_GET(0), REG_GET(1), SIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), REG_GET(1), vec_splat_8(SIM_GET(0))));          \
   return insn->next;                                                                         \
 }
 
 
 
-#define PV_OP_RRU_EXEC2(insn_name,lib_name)                                           \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)                \
+#define PV_OP_RRU_EXEC2(insn_name)                                                           \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_16, REG_GET(2), REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(2), REG_GET(0), REG_GET(1)));                      \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_h_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_16, REG_GET(2), REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(2), REG_GET(0), vec_splat_16(REG_GET(1))));        \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_h_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_16, REG_GET(0), REG_GET(1), UIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0), REG_GET(1), vec_splat_16(UIM_GET(0))));        \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)                \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)              \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_8, REG_GET(2), REG_GET(0), REG_GET(1)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(2), REG_GET(0), REG_GET(1)));                       \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)             \
+static inline iss_insn_t *pv_##insn_name##_b_sc_exec(iss_t *iss, iss_insn_t *insn)           \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_8, REG_GET(2), REG_GET(0), REG_GET(1))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(2), REG_GET(0), vec_splat_8(REG_GET(1))));          \
   return insn->next;                                                                         \
 }                                                                                            \
                                                                                              \
-static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)            \
+static inline iss_insn_t *pv_##insn_name##_b_sci_exec(iss_t *iss, iss_insn_t *insn)          \
 {                                                                                            \
-  REG_SET(0, LIB_CALL3(lib_VEC_##lib_name##_SC_8, REG_GET(0), REG_GET(1), UIM_GET(0))); \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0), REG_GET(1), vec_splat_8(UIM_GET(0))));          \
   return insn->next;                                                                         \
 }
 
 
 
 
-#define PV_OP1_RS_EXEC(insn_name,lib_name)                          \
-static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)      \
+#define PV_OP1_RS_EXEC(insn_name)                                                  \
+static inline iss_insn_t *pv_##insn_name##_h_exec(iss_t *iss, iss_insn_t *insn)    \
 {                                                                                  \
-  REG_SET(0, LIB_CALL1(lib_VEC_##lib_name##_int16_t_to_int32_t, REG_GET(0)));    \
+  REG_SET(0, vec_##insn_name##_16(REG_GET(0)));                                    \
   return insn->next;                                                               \
 }                                                                                  \
                                                                                    \
-static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)      \
+static inline iss_insn_t *pv_##insn_name##_b_exec(iss_t *iss, iss_insn_t *insn)    \
 {                                                                                  \
-  REG_SET(0, LIB_CALL1(lib_VEC_##lib_name##_int8_t_to_int32_t, REG_GET(0)));    \
+  REG_SET(0, vec_##insn_name##_8(REG_GET(0)));                                     \
   return insn->next;                                                               \
 }
 
 
 
-PV_OP_RS_EXEC(add,ADD)
+PV_OP_RS_EXEC(add)
 
-PV_OP_RS_EXEC(sub,SUB)
+PV_OP_RS_EXEC(sub)
 
-PV_OP_RS_EXEC(avg,AVG)
+PV_OP_RS_EXEC(avg)
 
-PV_OP_RU_EXEC(avgu,AVGU)
+PV_OP_RU_EXEC(avgu)
 
-PV_OP_RS_EXEC(min,MIN)
+PV_OP_RS_EXEC(min)
 
-PV_OP_RU_EXEC(minu,MINU)
+PV_OP_RU_EXEC(minu)
 
-PV_OP_RS_EXEC(max,MAX)
+PV_OP_RS_EXEC(max)
 
-PV_OP_RU_EXEC(maxu,MAXU)
+PV_OP_RU_EXEC(maxu)
 
-PV_OP_RU_EXEC(srl,SRL)
+PV_OP_RU_EXEC(srl)
 
-PV_OP_RS_EXEC(sra,SRA)
+PV_OP_RS_EXEC(sra)
 
-PV_OP_RU_EXEC(sll,SLL)
+PV_OP_RU_EXEC(sll)
 
-PV_OP_RS_EXEC(or,OR)
+PV_OP_RS_EXEC(or)
 
-PV_OP_RS_EXEC(xor,XOR)
+PV_OP_RS_EXEC(xor)
 
-PV_OP_RS_EXEC(and,AND)
+PV_OP_RS_EXEC(and)
 
-PV_OP1_RS_EXEC(abs,ABS)
+PV_OP1_RS_EXEC(abs)
 
 
 
@@ -1062,23 +1072,23 @@ static inline iss_insn_t *pv_insert_b_exec(iss_t *iss, iss_insn_t *insn)
 
 
 
-PV_OP_RS_EXEC2(dotsp,DOTSP)
+PV_OP_RS_EXEC2(dotsp)
 
-PV_OP_RU_EXEC2(dotup,DOTUP)
+PV_OP_RU_EXEC2(dotup)
 
-PV_OP_RS_EXEC2(dotusp,DOTUSP)
+PV_OP_RS_EXEC2(dotusp)
 
-PV_OP_RRS_EXEC2(sdotsp,SDOTSP)
+PV_OP_RRS_EXEC2(sdotsp)
 
-PV_OP_RRU_EXEC2(sdotup,SDOTUP)
+PV_OP_RRU_EXEC2(sdotup)
 
-PV_OP_RRS_EXEC2(sdotusp,SDOTUSP)
+PV_OP_RRS_EXEC2(sdotusp)
 
 
 
 static inline iss_insn_t *pv_shuffle_h_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_SHUFFLE_16, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_shuffle_16(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -1092,7 +1102,7 @@ static inline iss_insn_t *pv_shuffle_h_sci_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *pv_shuffle_b_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_SHUFFLE_8, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_shuffle_8(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -1156,25 +1166,25 @@ static inline iss_insn_t *pv_packlo_b_exec(iss_t *iss, iss_insn_t *insn)
 
 
 
-PV_OP_RS_EXEC(cmpeq,CMPEQ)
+PV_OP_RS_EXEC(cmpeq)
 
-PV_OP_RS_EXEC(cmpne,CMPNE)
+PV_OP_RS_EXEC(cmpne)
 
-PV_OP_RS_EXEC(cmpgt,CMPGT)
+PV_OP_RS_EXEC(cmpgt)
 
-PV_OP_RS_EXEC(cmpge,CMPGE)
+PV_OP_RS_EXEC(cmpge)
 
-PV_OP_RS_EXEC(cmplt,CMPLT)
+PV_OP_RS_EXEC(cmplt)
 
-PV_OP_RS_EXEC(cmple,CMPLE)
+PV_OP_RS_EXEC(cmple)
 
-PV_OP_RU_EXEC(cmpgtu,CMPGTU)
+PV_OP_RU_EXEC(cmpgtu)
 
-PV_OP_RU_EXEC(cmpgeu,CMPGEU)
+PV_OP_RU_EXEC(cmpgeu)
 
-PV_OP_RU_EXEC(cmpltu,CMPLTU)
+PV_OP_RU_EXEC(cmpltu)
 
-PV_OP_RU_EXEC(cmpleu,CMPLEU)
+PV_OP_RU_EXEC(cmpleu)
 
 
 
@@ -57,6 +57,7 @@ static inline iss_insn_t *jal_exec_common(iss_t *iss, iss_insn_t *insn, int perf
     iss_pccr_account_event(iss, CSR_PCER_JUMP, 1);
   }
   iss_perf_account_jump(iss);
+  iss_profiler_jump(iss, insn, insn->next->addr, -1);
   return insn->next;
 }
 
@@ -81,9 +82,25 @@ static inline void jal_decode(iss_t *iss, iss_insn_t *insn)
 
 
 
+static inline void jalr_decode(iss_t *iss, iss_insn_t *insn)
+{
+  // The branch field caches the last jump target so that jumping again to
+  // the same target does not need an instruction cache lookup. This is safe
+  // as all instructions are freed at the same time when the cache is flushed.
+  insn->branch = NULL;
+}
+
+
+
 static inline iss_insn_t *jalr_exec_common(iss_t *iss, iss_insn_t *insn, int perf)
 {
-  iss_insn_t *next_insn = insn_cache_get(iss, insn->sim[0] + iss_get_reg_for_jump(iss, insn->in_regs[0]));
+  iss_addr_t target = insn->sim[0] + iss_get_reg_for_jump(iss, insn->in_regs[0]);
+  iss_insn_t *next_insn = insn->branch;
+  if (next_insn == NULL || next_insn->addr != target)
+  {
+    next_insn = insn_cache_get(iss, target);
+    insn->branch = next_insn;
+  }
   unsigned int D = insn->out_regs[0];
   if (D != 0) REG_SET(0, insn->addr + insn->size);
   if (perf)
@@ -91,6 +108,7 @@ static inline iss_insn_t *jalr_exec_common(iss_t *iss, iss_insn_t *insn, int per
     iss_pccr_account_event(iss, CSR_PCER_JUMP, 1);
   }
   iss_perf_account_jump(iss);
+  iss_profiler_jump(iss, insn, target, insn->in_regs[0]);
   return next_insn;
 }
 
@@ -627,7 +645,10 @@ static inline iss_insn_t *ecall_exec(iss_t *iss, iss_insn_t *insn)
    pc->uim[0], getReg(cpu, 17), getReg(cpu, 10), getReg(cpu, 11), getReg(cpu, 12), getReg(cpu, 13));
 */
 
-  iss_handle_ecall(iss, insn);
+  // The platform can directly handle the call (e.g. syscall emulation in the
+  // standalone ISS), otherwise this is an exception for the software
+  if (iss_handle_ecall(iss, insn))
+    return insn->next;
 
   return iss_except_raise(iss, ISS_EXCEPT_ECALL);
 #if 0
@@ -24,6 +24,7 @@
 #include "iss_core.hpp"
 #include "isa_lib/int.h"
 #include "isa_lib/macros.h"
+#include "isa_lib/vec.h"
 
 
 
@@ -133,7 +134,7 @@ static inline iss_insn_t *lib_VEC_PACK_SC_HL_16_exec(iss_t *iss, iss_insn_t *ins
 
 static inline iss_insn_t *lib_VEC_ADD_8_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_ADD_int8_t_to_int32_t_div2, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_avg_8(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -141,7 +142,7 @@ static inline iss_insn_t *lib_VEC_ADD_8_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_ADD_8_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_ADD_int8_t_to_int32_t_div4, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_avg4_8(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -149,7 +150,7 @@ static inline iss_insn_t *lib_VEC_ADD_8_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_ADD_16_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_ADD_int16_t_to_int32_t_div2, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_avg_16(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -157,7 +158,7 @@ static inline iss_insn_t *lib_VEC_ADD_16_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_ADD_16_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_ADD_int16_t_to_int32_t_div4, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_avg4_16(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -165,7 +166,7 @@ static inline iss_insn_t *lib_VEC_ADD_16_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_SUB_8_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_SUB_int8_t_to_int32_t_div2, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_subavg_8(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -173,7 +174,7 @@ static inline iss_insn_t *lib_VEC_SUB_8_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_SUB_8_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_SUB_int8_t_to_int32_t_div4, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_subavg4_8(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -181,7 +182,7 @@ static inline iss_insn_t *lib_VEC_SUB_8_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_SUB_16_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_SUB_int16_t_to_int32_t_div2, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_subavg_16(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -189,7 +190,7 @@ static inline iss_insn_t *lib_VEC_SUB_16_DIV2_exec(iss_t *iss, iss_insn_t *insn)
 
 static inline iss_insn_t *lib_VEC_SUB_16_DIV4_exec(iss_t *iss, iss_insn_t *insn)
 {
-  REG_SET(0, LIB_CALL2(lib_VEC_SUB_int16_t_to_int32_t_div4, REG_GET(0), REG_GET(1)));
+  REG_SET(0, vec_subavg4_16(REG_GET(0), REG_GET(1)));
   return insn->next;
 }
 
@@ -88,7 +88,6 @@ class iss;
 
 #define ISS_INSN_BLOCK_SIZE_LOG2 8
 #define ISS_INSN_BLOCK_SIZE (1<<ISS_INSN_BLOCK_SIZE_LOG2)
-#define ISS_INSN_PC_BITS 1
 #define ISS_INSN_BLOCK_ID_BITS 12
 #define ISS_INSN_NB_BLOCKS (1<<ISS_INSN_BLOCK_ID_BITS)
 
@@ -100,6 +99,9 @@ typedef struct iss_cpu_s iss_cpu_t;
 typedef struct iss_insn_s iss_insn_t;
 typedef struct iss_insn_block_s iss_insn_block_t;
 typedef struct iss_insn_cache_s iss_insn_cache_t;
+typedef struct iss_decoded_insn_s iss_decoded_insn_t;
+typedef struct iss_decode_cache_s iss_decode_cache_t;
+typedef struct iss_insn_cold_s iss_insn_cold_t;
 typedef struct iss_decoder_item_s iss_decoder_item_t;
 
 typedef enum {
@@ -263,6 +265,9 @@ typedef struct iss_isa_s
 {
   char *name;
   iss_decoder_item_t *tree;
+  // Function generated from the tree, which decodes with constant masks and
+  // shifts instead of walking it
+  int (*decode)(iss_t *, iss_decoded_insn_t *, iss_opcode_t);
 } iss_isa_t;
 
 typedef struct iss_isa_set_s
@@ -282,29 +287,74 @@ typedef struct {
   iss_addr_t addr;
 } iss_prefetcher_t;
 
-typedef struct iss_insn_s {
-  iss_addr_t addr;
-  iss_reg_t opcode;
-  iss_insn_t *(*fast_handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*hwloop_handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*stall_handler)(iss_t *, iss_insn_t*);
-  iss_insn_t *(*stall_fast_handler)(iss_t *, iss_insn_t*);
+// Result of the decoding of an opcode. It only depends on the opcode and on
+// the active ISA, so it is shared by all cores with the same ISA and it is
+// never modified once decoded.
+typedef struct iss_decoded_insn_s {
+  iss_opcode_t opcode;
+  iss_decoder_item_t *decoder_item;
   int size;
   int nb_out_reg;
   int nb_in_reg;
   int out_regs[ISS_MAX_NB_OUT_REGS];
   int in_regs[ISS_MAX_NB_IN_REGS];
-  iss_uim_t uim[ISS_MAX_IMMEDIATES];
-  iss_sim_t sim[ISS_MAX_IMMEDIATES];
+  // Same layout as the immediates of the core instruction, to copy them at once
+  union {
+    iss_uim_t uim[ISS_MAX_IMMEDIATES];
+    iss_sim_t sim[ISS_MAX_IMMEDIATES];
+  };
   iss_insn_arg_t args[ISS_MAX_DECODE_ARGS];
-  iss_insn_t *next;
-  iss_decoder_item_t *decoder_item;
-
+  iss_decoded_insn_t *next;
+} iss_decoded_insn_t;
+
+// Per-core state of an instruction which is only needed when its handler
+// is replaced (stalls, hardware loops, traces, execution histogram, instruction
+// cache). It is allocated the first time it is needed so that it does not
+// take space in the instruction.
+typedef struct iss_insn_cold_s {
+  iss_insn_t *(*hwloop_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*stall_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*stall_fast_handler)(iss_t *, iss_insn_t*);
   iss_insn_t *(*saved_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*histogram_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*histogram_fast_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*icache_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*icache_fast_handler)(iss_t *, iss_insn_t*);
+  int latency;
+
+  // Number of times the instruction was executed, for the execution histogram
+  uint64_t exec_count;
+} iss_insn_cold_t;
+
+// Per-core instruction. The operands are copied from the shared decoding
+// so that handlers can access them directly, and the decode hooks can
+// adapt them to the address. Fields used by the handlers are kept first
+// and register indexes are stored on bytes to keep it compact.
+typedef struct iss_insn_s {
+  iss_insn_t *(*fast_handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *(*handler)(iss_t *, iss_insn_t*);
+  iss_insn_t *next;
   iss_insn_t *branch;
+  iss_addr_t addr;
+  int8_t size;
+  int8_t nb_out_reg;
+  int8_t nb_in_reg;
+  int8_t out_regs[ISS_MAX_NB_OUT_REGS];
+  int8_t in_regs[ISS_MAX_NB_IN_REGS];
+  // No instruction format uses the same index for a signed and an unsigned
+  // immediate, so they share their slots to keep the instruction small
+  union {
+    iss_uim_t uim[ISS_MAX_IMMEDIATES];
+    iss_sim_t sim[ISS_MAX_IMMEDIATES];
+  };
 
-  int latency;
+  // Translated block starting at this instruction, and number of times
+  // this instruction was reached as a block head
+  int (*jit_block)(iss_t *);
+  int jit_count;
+
+  iss_decoded_insn_t *decoded;
+  iss_insn_cold_t *cold;
 
 } iss_insn_t;
 
@@ -314,8 +364,44 @@ typedef struct iss_insn_block_s {
   iss_insn_block_t *next;
 } iss_insn_block_t;
 
+#define ISS_DECODE_CACHE_SIZE_LOG2 12
+#define ISS_DECODE_CACHE_SIZE (1<<ISS_DECODE_CACHE_SIZE_LOG2)
+
+typedef struct iss_decode_cache_s {
+  char *isa;
+  iss_decoded_insn_t *insns[ISS_DECODE_CACHE_SIZE];
+  int nb_insns;
+  iss_decode_cache_t *next;
+} iss_decode_cache_t;
+
+typedef struct {
+  iss_addr_t addr;
+  uint64_t count;
+} iss_insn_count_t;
+
 typedef struct iss_insn_cache_s {
   iss_insn_block_t *blocks[ISS_INSN_NB_BLOCKS];
+  // Number of low bits of the pc which are not used to index instructions in
+  // a block. Instructions can start on any halfword with compressed
+  // instructions, and only on words otherwise, in which case blocks cover
+  // twice more code.
+  int pc_bits;
+  iss_decode_cache_t *decode_cache;
+  // Number of times instructions were discarded due to code writes
+  int64_t nb_invalidations;
+  // Execution histogram. The counts of the instructions freed when the cache
+  // is flushed are kept here until the histogram is dumped.
+  bool histogram;
+  iss_insn_count_t *flushed_counts;
+  int nb_flushed_counts;
+  int flushed_counts_size;
+  // Addresses where the debugger set a breakpoint
+  iss_addr_t *breakpoints;
+  int nb_breakpoints;
+  // True when the core is connected to an instruction cache model, in which
+  // case the instructions whose cache line is not held by the core go through
+  // the cache before being executed
+  bool icache;
 } iss_insn_cache_t;
 
 typedef struct iss_regfile_s {
@@ -353,7 +439,14 @@ typedef struct iss_cpu_state_s {
   void (*stall_callback)(iss_t *iss);
   int stall_reg;
   int stall_size;
-  int hw_counter_en;
+
+  // Running totals of executed instructions and cycles, from which the cycle
+  // and instruction performance counters are computed when they are needed,
+  // and the totals at the last time these counters were updated.
+  uint64_t nb_insns;
+  uint64_t nb_cycles;
+  uint64_t pccr_nb_insns;
+  uint64_t pccr_nb_cycles;
 
   iss_insn_arg_t saved_args[ISS_MAX_DECODE_ARGS];
 
@@ -395,6 +488,17 @@ typedef struct iss_csr_s
 } iss_csr_t;
 
 
+typedef struct iss_jit_s
+{
+  bool enabled;
+  int threshold;
+  uint8_t *code;
+  int code_size;
+  int code_pos;
+  int exit_cycles;
+} iss_jit_t;
+
+
 #define PULPV2_HWLOOP_NB_REGS 7
 
 typedef struct iss_pulpv2_s
@@ -416,6 +520,7 @@ typedef struct iss_cpu_s {
   iss_irq_t irq;
   iss_csr_t csr;
   iss_pulpv2_t pulpv2;
+  iss_jit_t jit;
 } iss_cpu_t;
 
 #endif
@@ -52,6 +52,9 @@ class Const(object):
     def gen(self, isaFile):
         pass
 
+    def gen_decode(self, is_signed=False):
+        return '%d' % self.val
+
 class Range(object):
     def __init__(self, first, width=1, shift=0):
         self.first = first
@@ -70,6 +73,24 @@ class Range(object):
     def len(self):
         return 1
 
+    def gen_decode_field(self):
+        field = '((opcode >> %d) & 0x%x)' % (self.first, (1 << self.width) - 1)
+        if self.shift != 0:
+            field = '(%s << %d)' % (field, self.shift)
+        return field
+
+    def gen_decode(self, is_signed=False):
+        return gen_decode_ranges([self], is_signed)
+
+def gen_decode_ranges(ranges, is_signed):
+    # Same computation as decode_ranges in decoder.cpp, with constant masks
+    # and shifts
+    value = ' | '.join([range.gen_decode_field() for range in ranges])
+    if is_signed:
+        bits = max([range.width + range.shift for range in ranges])
+        return 'iss_get_signed_value(%s, %d)' % (value, bits)
+    return '(%s)' % value
+
 class Ranges(object):
     def __init__(self, fieldsList):
         self.ranges = []
@@ -87,6 +108,9 @@ class Ranges(object):
     def len(self):
         return len(self.ranges)
 
+    def gen_decode(self, is_signed=False):
+        return gen_decode_ranges(self.ranges, is_signed)
+
 
 class OpcodeField(object):
     def __init__(self, id, ranges, dumpName=True, flags=[]):
@@ -103,6 +127,19 @@ class OpcodeField(object):
     def set_latency(self, latency):
         self.latency = latency
 
+    def gen_decode_reg(self, isaFile, index):
+        arg = 'insn->args[%d]' % index
+        dump(isaFile, '  %s.u.reg.index = %s%s;\n' % (arg, self.ranges.gen_decode(), ' + 8' if 'ISS_DECODER_ARG_FLAG_COMPRESSED' in self.flags else ''))
+        if 'ISS_DECODER_ARG_FLAG_FREG' in self.flags:
+            dump(isaFile, '#ifndef ISS_SINGLE_REGFILE\n')
+            dump(isaFile, '  %s.u.reg.index += ISS_NB_REGS;\n' % arg)
+            dump(isaFile, '#endif\n')
+        dump(isaFile, '  insn->%s[%d] = %s.u.reg.index;\n' % ('out_regs' if self.is_out() else 'in_regs', self.id, arg))
+
+    def gen_decode_indirect_reg(self, isaFile, field):
+        dump(isaFile, '  %s = %s%s;\n' % (field, self.ranges.gen_decode(), ' + 8' if 'ISS_DECODER_ARG_FLAG_COMPRESSED' in self.flags else ''))
+        dump(isaFile, '  insn->in_regs[%d] = %s;\n' % (self.id, field))
+
 class Indirect(OpcodeField):
     def __init__(self, base, offset=None, postInc=False, preInc=False):
         self.base = base
@@ -164,6 +201,21 @@ class Indirect(OpcodeField):
             dump(isaFile, '%s  },\n' % (' '*indent))
             dump(isaFile, '%s},\n' % (' '*indent))
 
+    def gen_decode(self, isaFile, index):
+        # The flags are the ones of the decoder item, which is generated first
+        arg = 'insn->args[%d]' % index
+        if self.offset.is_reg():
+            dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_INDIRECT_REG;\n' % arg)
+            dump(isaFile, '  %s.flags = (iss_decoder_arg_flag_e)(%s);\n' % (arg, ' | '.join(self.flags)))
+            self.base.gen_decode_indirect_reg(isaFile, '%s.u.indirect_reg.base_reg_index' % arg)
+            self.offset.gen_decode_indirect_reg(isaFile, '%s.u.indirect_reg.offset_reg_index' % arg)
+        else:
+            dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_INDIRECT_IMM;\n' % arg)
+            dump(isaFile, '  %s.flags = (iss_decoder_arg_flag_e)(%s);\n' % (arg, ' | '.join(self.flags)))
+            self.base.gen_decode_indirect_reg(isaFile, '%s.u.indirect_imm.reg_index' % arg)
+            dump(isaFile, '  %s.u.indirect_imm.imm = (int)%s;\n' % (arg, self.offset.ranges.gen_decode(self.offset.isSigned)))
+            dump(isaFile, '  insn->sim[%d] = %s.u.indirect_imm.imm;\n' % (self.offset.id, arg))
+
 class SignedImm(OpcodeField):
     def __init__(self, id, ranges, isSigned=True):
         self.ranges = ranges
@@ -195,6 +247,13 @@ class SignedImm(OpcodeField):
         dump(isaFile, '\n%s  },\n' % (' '*indent))
         dump(isaFile, '%s},\n' % (' '*indent))
 
+    def gen_decode(self, isaFile, index):
+        arg = 'insn->args[%d]' % index
+        dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_SIMM;\n' % arg)
+        dump(isaFile, '  %s.flags = ISS_DECODER_ARG_FLAG_NONE;\n' % arg)
+        dump(isaFile, '  %s.u.sim.value = %s;\n' % (arg, self.ranges.gen_decode(self.isSigned)))
+        dump(isaFile, '  insn->sim[%d] = %s.u.sim.value;\n' % (self.id, arg))
+
 class UnsignedImm(OpcodeField):
     def __init__(self, id, ranges, isSigned=False):
         self.ranges = ranges
@@ -226,6 +285,13 @@ class UnsignedImm(OpcodeField):
         dump(isaFile, '\n%s  },\n' % (' '*indent))
         dump(isaFile, '%s},\n' % (' '*indent))
 
+    def gen_decode(self, isaFile, index):
+        arg = 'insn->args[%d]' % index
+        dump(isaFile, '  %s.type = ISS_DECODER_ARG_TYPE_UIMM;\n' % arg)
+        dump(isaFile, '  %s.flags = ISS_DECODER_ARG_FLAG_NONE;\n' % arg)
+        dump(isaFile, '  %s.u.uim.value = %s;\n' % (arg, self.ranges.gen_decode(self.isSigned)))
+        dump(isaFile, '  insn->uim[%d] = %s.u.uim.value;\n' % (self.id, arg))
+
 class OutReg(OpcodeField):
     def genExtract(self, isaFile, level):
         dump(isaFile, level, '  pc->outReg[%d] = %s;\n' % (self.id, self.ranges.gen()))
@@ -254,6 +320,11 @@ class OutReg(OpcodeField):
         dump(isaFile, '\n%s  },\n' % (' '*indent))
         dump(isaFile, '%s},\n' % (' '*indent))
 
+    def gen_decode(self, isaFile, index):
+        dump(isaFile, '  insn->args[%d].type = ISS_DECODER_ARG_TYPE_OUT_REG;\n' % index)
+        dump(isaFile, '  insn->args[%d].flags = (iss_decoder_arg_flag_e)(%s);\n' % (index, ' | '.join(self.flags)))
+        self.gen_decode_reg(isaFile, index)
+
 class OutFReg(OutReg):
     def __init__(self, id, ranges, dumpName=True):
         super(OutFReg, self).__init__(id=id, ranges=ranges, dumpName=dumpName, flags=['ISS_DECODER_ARG_FLAG_FREG'])
@@ -306,6 +377,11 @@ class InReg(OpcodeField):
         dump(isaFile, '\n%s  },\n' % (' '*indent))
         dump(isaFile, '%s},\n' % (' '*indent))
 
+    def gen_decode(self, isaFile, index):
+        dump(isaFile, '  insn->args[%d].type = ISS_DECODER_ARG_TYPE_IN_REG;\n' % index)
+        dump(isaFile, '  insn->args[%d].flags = (iss_decoder_arg_flag_e)(%s);\n' % (index, ' | '.join(self.flags)))
+        self.gen_decode_reg(isaFile, index)
+
 class InFReg(InReg):
     def __init__(self, id, ranges, dumpName=True):
         super(InFReg, self).__init__(id=id, ranges=ranges, dumpName=dumpName, flags=['ISS_DECODER_ARG_FLAG_FREG'])
@@ -355,6 +431,9 @@ class DecodeLeaf(object):
     def get_name(self):
         return self.instr.get_full_name()
 
+    def get_decode_name(self):
+        return self.instr.get_decode_name()
+
 class DecodeTree(object):
     def __init__(self, isaFile, instrs, mask, opcode):
         self.opcode = opcode
@@ -503,6 +582,38 @@ class DecodeTree(object):
         else:
             return list(self.subtrees.values())[0].get_name()
 
+    def get_decode_name(self):
+        if self.needTree:
+            return self.get_name() + '_decode'
+        else:
+            return list(self.subtrees.values())[0].get_decode_name()
+
+    # Generates a function decoding the group like decode_opcode_group in
+    # decoder.cpp, with a switch on the group opcode instead of a search.
+    # When several groups have the same opcode, the first one is taken.
+    def gen_decode(self):
+        others = None
+        cases = {}
+        for opcode, subtree in self.subtrees.items():
+            if opcode == 'OTHERS':
+                others = subtree
+            elif cases.get(int(opcode, 2)) is None:
+                cases[int(opcode, 2)] = subtree
+
+        self.dump('static int %s(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode)\n' % self.get_decode_name())
+        self.dump('{\n')
+        self.dump('  switch ((opcode >> %d) & 0x%x)\n' % (self.firstBit, (1 << self.opcode_width) - 1))
+        self.dump('  {\n')
+        for opcode, subtree in cases.items():
+            self.dump('    case 0x%x: return %s(iss, insn, opcode);\n' % (opcode, subtree.get_decode_name()))
+        if others is not None:
+            self.dump('    default: return %s(iss, insn, opcode);\n' % others.get_decode_name())
+        else:
+            self.dump('    default: return -1;\n')
+        self.dump('  }\n')
+        self.dump('}\n')
+        self.dump('\n')
+
 
     def gen(self, is_top=False):
 
@@ -544,6 +655,8 @@ class DecodeTree(object):
                 self.dump('  }\n')
                 self.dump('};\n')
                 self.dump('\n')
+
+                self.gen_decode()
             
         
 class IsaSubset(object):
@@ -605,7 +718,7 @@ class IsaDecodeTree(object):
             self.tree.gen(is_top=True)
 
     def dump_ref(self, isa, isaFile):
-        dump(isaFile, '  {(char *)"%s", &%s},\n' % (self.name, self.tree.get_name()))
+        dump(isaFile, '  {(char *)"%s", &%s, %s},\n' % (self.name, self.tree.get_name(), self.tree.get_decode_name()))
 
 
 class Isa(object):
@@ -1004,6 +1117,40 @@ class Instr(object):
         self.dump(isaFile, '};\n')
         self.dump(isaFile, '\n')
 
+        self.gen_decode(isaFile)
+
+    def get_decode_name(self):
+        return self.get_full_name() + '_decode'
+
+    # Generates a function decoding the instruction like decode_insn in
+    # decoder.cpp, but with the argument fields known at compile time
+    def gen_decode(self, isaFile):
+        nb_out_reg = 0
+        nb_in_reg = 0
+        for arg in self.args:
+            if arg.is_reg():
+                if arg.is_out():
+                    nb_out_reg = max(nb_out_reg, arg.id + 1)
+                else:
+                    nb_in_reg = max(nb_in_reg, arg.id + 1)
+
+        name = self.get_full_name()
+
+        self.dump(isaFile, 'static int %s(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode)\n' % self.get_decode_name())
+        self.dump(isaFile, '{\n')
+        self.dump(isaFile, '  if (!%s.is_active) return -1;\n' % name)
+        self.dump(isaFile, '\n')
+        self.dump(isaFile, '  insn->decoder_item = &%s;\n' % name)
+        self.dump(isaFile, '  insn->size = %d;\n' % (self.len/8))
+        self.dump(isaFile, '  insn->nb_out_reg = %d;\n' % nb_out_reg)
+        self.dump(isaFile, '  insn->nb_in_reg = %d;\n' % nb_in_reg)
+        for index, arg in enumerate(self.args):
+            arg.gen_decode(isaFile, index)
+        self.dump(isaFile, '\n')
+        self.dump(isaFile, '  return 0;\n')
+        self.dump(isaFile, '}\n')
+        self.dump(isaFile, '\n')
+
 
     def getOptions(self):
         if self.group != None: return self.group.getOptions()
@@ -536,7 +536,7 @@ rv32i = IsaSubset('i', [
     R5('lui',   'U',  '------- ----- ----- --- ----- 0110111'),
     R5('auipc', 'U',  '------- ----- ----- --- ----- 0010111', 'auipc_decode'),
     R5('jal',   'UJ', '------- ----- ----- --- ----- 1101111', 'jal_decode', fast_handler=True),
-    R5('jalr',  'I',  '------- ----- ----- 000 ----- 1100111', fast_handler=True),
+    R5('jalr',  'I',  '------- ----- ----- 000 ----- 1100111', 'jalr_decode', fast_handler=True),
     R5('beq',   'SB', '------- ----- ----- 000 ----- 1100011', 'bxx_decode', fast_handler=True),
     R5('bne',   'SB', '------- ----- ----- 001 ----- 1100011', 'bxx_decode', fast_handler=True),
     R5('blt',   'SB', '------- ----- ----- 100 ----- 1100011', 'bxx_decode', fast_handler=True),
@@ -1241,10 +1241,10 @@ rv32c = IsaSubset('c', [
     R5('c.bnez',     'CB1', '111 --- --- -- --- 01', fast_handler=True, decode='bxx_decode'),
     R5('c.slli',     'CI1U','000 --- --- -- --- 10', fast_handler=True),
     R5('c.lwsp',     'CI3', '010 --- --- -- --- 10', fast_handler=True, tags=["load"]),
-    R5('c.jr',       'CR1', '100 0-- --- 00 000 10', fast_handler=True),
+    R5('c.jr',       'CR1', '100 0-- --- 00 000 10', fast_handler=True, decode='jalr_decode'),
     R5('c.mv',       'CR2', '100 0-- --- -- --- 10', fast_handler=True),
     R5('c.ebreak',   'CR',  '100 100 000 00 000 10'),
-    R5('c.jalr',     'CR3', '100 1-- --- 00 000 10', fast_handler=True),
+    R5('c.jalr',     'CR3', '100 1-- --- 00 000 10', fast_handler=True, decode='jalr_decode'),
     R5('c.add',      'CR',  '100 1-- --- -- --- 10', fast_handler=True),
     R5('c.swsp',     'CSS', '110 --- --- -- --- 10', fast_handler=True),
     R5('c.sbreak',   'CI1', '100 000 000 00 000 10'),
@@ -48,10 +48,21 @@ typedef struct iss_s
   unsigned char *mem_array;
   size_t mem_size;
 
+  int verbose;
+
 } iss_t;
 
+// Exit codes returned by the standalone ISS when the simulated program did
+// not exit by itself, chosen so that they can't be confused with usual
+// program exit codes.
+#define ISS_EXIT_TIMEOUT  124
+#define ISS_EXIT_USAGE    125
+#define ISS_EXIT_ABORT    126
+
 void handle_syscall(iss_t *iss, iss_insn_t *insn);
 
+void iss_abort(iss_t *iss, iss_insn_t *insn, const char *fmt, ...);
+
 
 //#define USE_INSN_TRACES 1
 
@@ -64,6 +75,20 @@ static inline bool iss_insn_trace_active(iss_t *iss)
 #endif
 }
 
+static inline bool iss_traces_active(iss_t *iss)
+{
+  return iss_insn_trace_active(iss);
+}
+
+static inline bool iss_functional_mode(iss_t *iss)
+{
+  return false;
+}
+
+static inline void iss_profiler_jump(iss_t *iss, iss_insn_t *insn, iss_addr_t target, int rs1)
+{
+}
+
 #define iss_fatal(iss, fmt, x...)
 
 #define iss_warning(iss, fmt, x...)
@@ -93,43 +118,127 @@ inline void iss_insn_msg(iss_t *iss, const char *fmt, ...)
 
 #endif
 
+static inline void iss_fetch_watch(iss_t *iss, uint64_t addr)
+{
+}
+
 static inline int iss_fetch_req(iss_t *iss, uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
 {
-  memcpy(data, iss->mem_array + addr, size);
+  // The prefetcher may fetch a full line beyond the end of the memory, just
+  // return zeros for this part so that an invalid instruction is decoded if
+  // the core really jumps there
+  if (addr >= iss->mem_size)
+  {
+    memset(data, 0, size);
+    return 0;
+  }
+
+  uint64_t valid_size = iss->mem_size - addr;
+  if (valid_size < size)
+  {
+    memcpy(data, iss->mem_array + addr, valid_size);
+    memset(data + valid_size, 0, size - valid_size);
+  }
+  else
+  {
+    memcpy(data, iss->mem_array + addr, size);
+  }
   return 0;
 }
 
 static inline int iss_irq_ack(iss_t *iss, int irq)
 {
+  return 0;
+}
+
+static inline bool iss_lsu_check(iss_t *iss, iss_insn_t *insn, iss_addr_t addr, int size, bool is_write)
+{
+  if ((uint64_t)addr + size <= iss->mem_size)
+    return true;
+
+  iss_abort(iss, insn, "Invalid %s access (addr: 0x%x, size: 0x%x)", is_write ? "write" : "read", addr, size);
+  return false;
 }
 
 static inline void iss_lsu_load(iss_t *iss, iss_insn_t *insn, iss_addr_t addr, int size, int reg)
 {
-  if (addr + size > iss->mem_size)
+  iss_reg_t value = 0;
+
+  if (!iss_lsu_check(iss, insn, addr, size, false))
     return;
 
-  iss_set_reg(iss, reg, iss_get_zext_value(*(iss_reg_t *)(iss->mem_array + addr), size*8));
+  memcpy(&value, iss->mem_array + addr, size);
+  iss_set_reg(iss, reg, value);
 }
 
 static inline void iss_lsu_load_signed(iss_t *iss, iss_insn_t *insn, iss_addr_t addr, int size, int reg)
 {
-  if (addr + size > iss->mem_size)
+  iss_reg_t value = 0;
+
+  if (!iss_lsu_check(iss, insn, addr, size, false))
     return;
-  
-  iss_set_reg(iss, reg, iss_get_zext_value(*(iss_reg_t *)(iss->mem_array + addr), size*8));
+
+  memcpy(&value, iss->mem_array + addr, size);
+  iss_set_reg(iss, reg, iss_get_signed_value(value, size*8));
+}
+
+static inline void iss_lsu_elw(iss_t *iss, iss_insn_t *insn, iss_addr_t addr, int size, int reg)
+{
+  // There is no event unit in the standalone ISS, this is a normal load
+  iss_lsu_load(iss, insn, addr, size, reg);
 }
 
 static inline void iss_lsu_store(iss_t *iss, iss_insn_t *insn, iss_addr_t addr, int size, int reg)
 {
-  if (addr + size > iss->mem_size)
+  if (!iss_lsu_check(iss, insn, addr, size, true))
     return;
-  
+
   memcpy(iss->mem_array + addr, &iss->cpu.regfile.regs[reg], size);
 }
 
-static inline void iss_handle_ecall(iss_t *iss, iss_insn_t *insn)
+static inline bool iss_handle_ecall(iss_t *iss, iss_insn_t *insn)
 {
   handle_syscall(iss, insn);
+  return true;
+}
+
+static inline void iss_handle_ebreak(iss_t *iss, iss_insn_t *insn)
+{
+  iss_abort(iss, insn, "Reached ebreak");
+}
+
+// There is no debugger connected to the standalone ISS
+static inline void iss_handle_breakpoint(iss_t *iss, iss_insn_t *insn)
+{
+  iss_abort(iss, insn, "Reached breakpoint");
+}
+
+// The standalone ISS is never connected to an instruction cache
+static inline bool iss_icache_fetch(iss_t *iss, iss_insn_t *insn)
+{
+  return true;
+}
+
+static inline void iss_pccr_incr(iss_t *iss, unsigned int event, int incr)
+{
+}
+
+static inline int iss_pccr_trace_active(iss_t *iss, unsigned int event)
+{
+  return 0;
+}
+
+static inline int iss_insn_event_active(iss_t *iss)
+{
+  return 0;
+}
+
+static inline void iss_insn_event_dump(iss_t *iss, const char *msg)
+{
+}
+
+static inline void iss_unstall(iss_t *iss)
+{
 }
 
 static inline void iss_set_halt_mode(iss_t *iss, bool halted, int cause)
@@ -140,12 +249,27 @@ static inline void iss_wait_for_interrupt(iss_t *iss)
 {
 }
 
+// Something changed which the fast loop does not check (interrupt enable,
+// HW loop or performance counter configuration, etc), leave the fast mode
+// so that the main loop goes through the full checks again.
 static inline void iss_trigger_check_all(iss_t *iss)
 {
+  iss->fast_mode = 0;
 }
 
 static inline void iss_trigger_irq_check(iss_t *iss)
 {
+  iss->fast_mode = 0;
+}
+
+static inline bool iss_exec_advance(iss_t *iss, int64_t cycles)
+{
+  return true;
+}
+
+static inline bool iss_exec_can_continue(iss_t *iss)
+{
+  return iss->fast_mode;
 }
 
 static void iss_csr_ext_counter_set(iss_t *iss, int id, unsigned int value)
@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Decodes random opcodes with the functions generated by isa_gen and by
+// walking the decoder trees, checks that both give the same result and
+// measures how many opcodes per second each of them decodes.
+// Usage: decode_bench [isa] [number of opcodes]
+
+#include "sa_iss.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define BENCH_ROUNDS 10
+
+static double get_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+static void decoded_init(iss_decoded_insn_t *insn)
+{
+  memset(insn, 0, sizeof(*insn));
+  for (int i=0; i<ISS_MAX_NB_OUT_REGS; i++)
+    insn->out_regs[i] = -1;
+  for (int i=0; i<ISS_MAX_NB_IN_REGS; i++)
+    insn->in_regs[i] = -1;
+}
+
+// Half of the opcodes are 32 bits ones, i.e. with the 2 low bits set, and the
+// other half compressed ones
+static iss_opcode_t random_opcode()
+{
+  uint32_t opcode = ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+  if (rand() & 1)
+    return opcode | 3;
+  return (opcode & ~3) | (rand() % 3);
+}
+
+static double bench(iss_t *iss, iss_opcode_t *opcodes, int nb_opcodes, bool use_tree)
+{
+  iss_decoded_insn_t insn;
+  int valid = 0;
+
+  double start = get_time();
+  for (int j=0; j<BENCH_ROUNDS; j++)
+  {
+    for (int i=0; i<nb_opcodes; i++)
+    {
+      for (int k=0; k<ISS_MAX_NB_OUT_REGS; k++)
+        insn.out_regs[k] = -1;
+      for (int k=0; k<ISS_MAX_NB_IN_REGS; k++)
+        insn.in_regs[k] = -1;
+      valid += iss_decode_opcode(iss, &insn, opcodes[i], use_tree) == 0;
+    }
+  }
+  double duration = get_time() - start;
+
+  printf("%-10s %8.2f Mopcodes/s (valid: %d/%d)\n", use_tree ? "tree:" : "generated:",
+    (double)nb_opcodes * BENCH_ROUNDS / duration / 1000000, valid / BENCH_ROUNDS, nb_opcodes);
+
+  return duration;
+}
+
+int main(int argc, char **argv)
+{
+  const char *isa = argc > 1 ? argv[1] : "rv32imfcXpulpv2";
+  int nb_opcodes = argc > 2 ? atoi(argv[2]) : 1000000;
+
+  iss_t *iss = new iss_t();
+  iss->cpu.config.isa = strdup(isa);
+  iss->cpu.jit.enabled = false;
+  if (iss_open(iss)) return ISS_EXIT_USAGE;
+
+  iss_opcode_t *opcodes = new iss_opcode_t[nb_opcodes];
+  srand(1);
+  for (int i=0; i<nb_opcodes; i++)
+  {
+    opcodes[i] = random_opcode();
+  }
+
+  int errors = 0;
+  for (int i=0; i<nb_opcodes; i++)
+  {
+    iss_decoded_insn_t tree_insn, gen_insn;
+    decoded_init(&tree_insn);
+    decoded_init(&gen_insn);
+
+    int tree_result = iss_decode_opcode(iss, &tree_insn, opcodes[i], true);
+    int gen_result = iss_decode_opcode(iss, &gen_insn, opcodes[i], false);
+
+    if (tree_result != gen_result || memcmp(&tree_insn, &gen_insn, sizeof(tree_insn)) != 0)
+    {
+      if (errors < 10)
+      {
+        printf("Mismatch for opcode 0x%08lx (tree: %s, generated: %s)\n", (unsigned long)opcodes[i],
+          tree_result == 0 ? tree_insn.decoder_item->u.insn.label : "illegal",
+          gen_result == 0 ? gen_insn.decoder_item->u.insn.label : "illegal");
+      }
+      errors++;
+    }
+  }
+
+  printf("ISA: %s, %d opcodes, %d mismatch(es)\n", isa, nb_opcodes, errors);
+
+  double tree_duration = bench(iss, opcodes, nb_opcodes, true);
+  double gen_duration = bench(iss, opcodes, nb_opcodes, false);
+  printf("speedup:   %8.2fx\n", tree_duration / gen_duration);
+
+  return errors != 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Decodes a straight-line program made of 32 bits and compressed
+// instructions, like the cores do when they execute it once, and reports the
+// memory used by the instruction cache and how many of its entries are used.
+// All the cores share the memory containing the code, like the cores of a
+// cluster running the same kernel, so that the increase of the resident
+// memory while they decode it only comes from their instruction caches and
+// from the decoded instructions they share.
+// Usage: footprint_bench [isa] [code size in KB] [percentage of compressed instructions] [number of cores]
+
+#include "sa_iss.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define OPCODE_ADDI_X5_X5_1    0x00128293
+#define OPCODE_ADD_X6_X5_X5    0x00528333
+#define OPCODE_C_ADDI_X5_1     0x0285
+#define OPCODE_C_MV_X6_X5      0x8316
+
+// Resident memory of the process in KB, from /proc/self/statm
+static long resident_kb()
+{
+  long size, resident;
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (file == NULL) return 0;
+  int nb_read = fscanf(file, "%ld %ld", &size, &resident);
+  fclose(file);
+  return nb_read == 2 ? resident * sysconf(_SC_PAGESIZE) / 1024 : 0;
+}
+
+int main(int argc, char **argv)
+{
+  const char *isa = argc > 1 ? argv[1] : "rv32imcXpulpv2";
+  int code_size = (argc > 2 ? atoi(argv[2]) : 256) * 1024;
+  int compressed = argc > 3 ? atoi(argv[3]) : 50;
+  int nb_cores = argc > 4 ? atoi(argv[4]) : 1;
+
+  // Some room is left after the code as the decoder may look at the next
+  // instruction
+  int mem_size = code_size + 2 * ISS_OPCODE_MAX_SIZE;
+  unsigned char *mem_array = (unsigned char *)calloc(1, mem_size);
+
+  iss_t **cores = new iss_t *[nb_cores];
+  for (int i=0; i<nb_cores; i++)
+  {
+    iss_t *core = new iss_t();
+    core->cpu.config.isa = strdup(isa);
+    core->cpu.jit.enabled = false;
+    core->mem_size = mem_size;
+    core->mem_array = mem_array;
+    if (iss_open(core)) return ISS_EXIT_USAGE;
+    iss_start(core);
+    cores[i] = core;
+  }
+
+  iss_t *iss = cores[0];
+
+  // Compressed instructions are only generated if the ISA has them, which is
+  // when the instruction cache has entries for odd halfwords
+  if (iss->cpu.insn_cache.pc_bits != 1)
+    compressed = 0;
+
+  srand(1);
+  int nb_insns = 0;
+  int nb_compressed = 0;
+  iss_addr_t addr = 0;
+  while (addr + 4 <= (iss_addr_t)code_size)
+  {
+    if (rand() % 100 < compressed)
+    {
+      uint16_t opcode = nb_insns & 1 ? OPCODE_C_MV_X6_X5 : OPCODE_C_ADDI_X5_1;
+      storeByte(iss, addr, opcode & 0xff);
+      storeByte(iss, addr + 1, opcode >> 8);
+      addr += 2;
+      nb_compressed++;
+    }
+    else
+    {
+      storeWord(iss, addr, nb_insns & 1 ? OPCODE_ADD_X6_X5_X5 : OPCODE_ADDI_X5_X5_1);
+      addr += 4;
+    }
+    nb_insns++;
+  }
+  iss_addr_t end = addr;
+
+  long resident_start = resident_kb();
+
+  for (int i=0; i<nb_cores; i++)
+  {
+    for (addr = 0; addr < end;)
+    {
+      iss_insn_t *insn = insn_cache_get_decoded(cores[i], addr);
+      addr += insn->size;
+    }
+  }
+
+  long resident = resident_kb() - resident_start;
+
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  int nb_blocks = 0;
+  int nb_used = 0;
+  int nb_cold = 0;
+  for (int i=0; i<ISS_INSN_NB_BLOCKS; i++)
+  {
+    for (iss_insn_block_t *b = cache->blocks[i]; b; b = b->next)
+    {
+      nb_blocks++;
+      for (int j=0; j<ISS_INSN_BLOCK_SIZE; j++)
+      {
+        if (b->insns[j].handler != iss_decode_pc)
+          nb_used++;
+        if (b->insns[j].cold)
+          nb_cold++;
+      }
+    }
+  }
+
+  double blocks_size = (double)nb_blocks * sizeof(iss_insn_block_t);
+
+  printf("ISA: %s, code: %d KB, %d instructions, %d%% compressed\n", isa, code_size / 1024,
+    nb_insns, nb_insns ? nb_compressed * 100 / nb_insns : 0);
+  printf("instruction: %d bytes, block: %d bytes for %d bytes of code\n", (int)sizeof(iss_insn_t),
+    (int)sizeof(iss_insn_block_t), ISS_INSN_BLOCK_SIZE << cache->pc_bits);
+  printf("blocks:      %d, %.1f KB, %.1f bytes per instruction, %.1f%% of the entries used\n",
+    nb_blocks, blocks_size / 1024, blocks_size / nb_insns,
+    nb_blocks ? 100.0 * nb_used / (nb_blocks * ISS_INSN_BLOCK_SIZE) : 0.0);
+  printf("cold:        %d, %.1f KB\n", nb_cold, (double)nb_cold * sizeof(iss_insn_cold_t) / 1024);
+  printf("cores:       %d, resident memory increased by %ld KB, %ld KB per core\n", nb_cores,
+    resident, resident / nb_cores);
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Checks that the stall handler installed by a load on the instruction using
+// its result is kept, and installed only once, when the code is invalidated
+// on either side of the pair, e.g. by a breakpoint or a code write.
+// Usage: insn_cache_test
+
+#include "sa_iss.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEMORY_SIZE (64*1024)
+
+#define OPCODE_LW_X5_0_X10     0x00052283
+#define OPCODE_ADD_X6_X5_X5    0x00528333
+
+static int errors = 0;
+
+static void check(bool cond, const char *test, const char *msg)
+{
+  if (!cond)
+  {
+    printf("%s: %s\n", test, msg);
+    errors++;
+  }
+}
+
+// Decode the pair like the core does when it executes it and check that the
+// instruction using the loaded register goes through the stall handler once
+static void check_pair(iss_t *iss, const char *test, iss_addr_t addr)
+{
+  iss_insn_t *load = insn_cache_get_decoded(iss, addr);
+  iss_insn_t *use = insn_cache_get_decoded(iss, addr + 4);
+
+  check(load->next == use, test, "load is not followed by its use");
+  // The handlers are static so they can not be compared to ours, but when
+  // the stall handler is installed twice it is also the one it calls
+  check(use->cold && use->cold->stall_handler != NULL, test, "stall handler is not installed");
+  check(use->cold == NULL || use->cold->stall_handler != use->handler, test, "stall handler is installed twice");
+
+  if (use->cold && use->cold->stall_handler != use->handler)
+  {
+    check(use->handler(iss, use) == use->next, test, "stalled instruction did not execute");
+  }
+}
+
+int main(int argc, char **argv)
+{
+  iss_t *iss = new iss_t();
+  iss->cpu.config.isa = strdup("rv32imcXpulpv2");
+  iss->cpu.jit.enabled = false;
+  iss->mem_size = MEMORY_SIZE;
+  iss->mem_array = (unsigned char *)calloc(1, MEMORY_SIZE);
+  if (iss_open(iss)) return ISS_EXIT_USAGE;
+  iss_start(iss);
+
+  iss_addr_t block_size = 1 << (ISS_INSN_BLOCK_SIZE_LOG2 + iss->cpu.insn_cache.pc_bits);
+
+  // The load is discarded but the next instruction is after the discarded
+  // range, it must not be stalled twice when the load is decoded again
+  iss_addr_t addr = block_size;
+  storeWord(iss, addr, OPCODE_LW_X5_0_X10);
+  storeWord(iss, addr + 4, OPCODE_ADD_X6_X5_X5);
+  check_pair(iss, "end", addr);
+  iss_cache_invalidate(iss, 0, 1);
+  check_pair(iss, "end", addr);
+
+  // The use is discarded but the load is before the discarded range, the
+  // stall must not be lost when the use is decoded again
+  addr = block_size * 3 - 8;
+  storeWord(iss, addr, OPCODE_LW_X5_0_X10);
+  storeWord(iss, addr + 4, OPCODE_ADD_X6_X5_X5);
+  check_pair(iss, "start", addr);
+  iss_cache_invalidate(iss, block_size * 3, 1);
+  check_pair(iss, "start", addr);
+
+  // The use is just before the discarded range and is also discarded as it
+  // may have installed a stall handler in it. Its own stall must be installed
+  // again although the load is not decoded again.
+  addr = block_size * 5 - 12;
+  storeWord(iss, addr, OPCODE_LW_X5_0_X10);
+  storeWord(iss, addr + 4, OPCODE_ADD_X6_X5_X5);
+  check_pair(iss, "before", addr);
+  iss_cache_invalidate(iss, block_size * 5, 1);
+  check(insn_cache_get(iss, addr + 4)->handler == iss_decode_pc, "before", "use is not discarded");
+  check_pair(iss, "before", addr);
+
+  printf("%d error(s)\n", errors);
+
+  return errors != 0;
+}
@@ -170,10 +170,10 @@ int load_binary(iss_t *iss, const char *name, int argc, char **argv, iss_reg_t *
 {
   bfd *abfd;
   int trace = 0;
-  char *myname;
+  const char *myname = "iss";
   asection *s;
   int lma_p = 0;
-  int verbose_p = 10;
+  int verbose_p = iss->verbose;
   int found_loadable_section = 0;
   unsigned long data_count = 0; /* Number of bytes transferred to memory */
   struct timeval start_time;
@@ -184,14 +184,14 @@ int load_binary(iss_t *iss, const char *name, int argc, char **argv, iss_reg_t *
     {
       fprintf (stderr, "%s: can't open %s: %s\n",
           myname, name, bfd_errmsg (bfd_get_error ()));
-      exit (1);
+      return -1;
     } 
 
   if (!bfd_check_format (abfd, bfd_object))
     {
       fprintf (stderr, "%s: can't load %s: %s\n",
          myname, name, bfd_errmsg (bfd_get_error ()));
-      exit (1);
+      return -1;
     }
 
 
@@ -219,13 +219,20 @@ int load_binary(iss_t *iss, const char *name, int argc, char **argv, iss_reg_t *
         buffer = (unsigned char *)malloc (size);
         if (buffer == NULL)
         {
-          printf("%s: insufficient memory to load \"%s\"\n", myname, name);
+          fprintf(stderr, "%s: insufficient memory to load \"%s\"\n", myname, name);
           return -1;
         }
         if (lma_p)
           lma = bfd_section_lma (abfd, s);
         else
           lma = bfd_section_vma (abfd, s);
+        if (lma + size > iss->mem_size)
+        {
+          fprintf(stderr, "%s: section %s (0x%lx-0x%lx) does not fit in simulator memory (0x%lx), use --mem-size\n",
+           myname, bfd_get_section_name (abfd, s), (unsigned long) lma, (unsigned long) (lma + size), (unsigned long) iss->mem_size);
+          free (buffer);
+          return -1;
+        }
         if (verbose_p)
         {
           printf("Loading section %s, size 0x%lx %s ",
@@ -246,7 +253,7 @@ int load_binary(iss_t *iss, const char *name, int argc, char **argv, iss_reg_t *
 
   if (!found_loadable_section)
   {
-    printf(
+    fprintf(stderr,
      "%s: no loadable sections \"%s\"\n",
      myname, name);
     return -1;
@@ -258,7 +265,7 @@ int load_binary(iss_t *iss, const char *name, int argc, char **argv, iss_reg_t *
   }
 
   if (!handle_argc_argc(iss, abfd, argv)) {
-  printf("Failed to initialize argc/argv\n"); return -1;
+  fprintf(stderr, "Failed to initialize argc/argv\n"); return -1;
   }
   iss->abfd = abfd;
 
@@ -22,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <sys/mman.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdarg.h>
@@ -30,47 +31,238 @@
 
 
 
+static void usage(const char *name)
+{
+  fprintf(stderr, "Usage: %s [options] <binary> [binary arguments]\n", name);
+  fprintf(stderr, "\n");
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --mem-size=<size>   Size of the simulated memory, with optional K, M or G suffix (default: 16M)\n");
+  fprintf(stderr, "  --isa=<isa>         ISA of the simulated core (default: rv32imcXpulpv2)\n");
+  fprintf(stderr, "  --max-insns=<n>     Stop the simulation with exit code %d after <n> instructions\n", ISS_EXIT_TIMEOUT);
+  fprintf(stderr, "  --histogram=<file>  Dump the execution count of each instruction into <file>\n");
+  fprintf(stderr, "  --no-fast           Always execute instructions with full checks\n");
+  fprintf(stderr, "  --jit               Translate hot blocks into host code\n");
+  fprintf(stderr, "  --jit-threshold=<n> Translate blocks reached <n> times (default: %d)\n", ISS_JIT_THRESHOLD);
+  fprintf(stderr, "  --state=<file>      Dump the registers and the number of instructions and cycles into <file> at the end\n");
+  fprintf(stderr, "  --quiet             Do not print the execution report\n");
+  fprintf(stderr, "  --verbose           Print loader information\n");
+  fprintf(stderr, "\n");
+  fprintf(stderr, "The exit code is the one of the simulated program, or %d if the simulation was aborted\n", ISS_EXIT_ABORT);
+  fprintf(stderr, "(unsupported syscall, invalid access, ebreak) and %d for invalid options or binary.\n", ISS_EXIT_USAGE);
+}
+
+
+
+static bool parse_size(const char *str, uint64_t *result)
+{
+  char *end;
+  uint64_t value = strtoull(str, &end, 0);
+
+  switch (*end)
+  {
+    case 'k': case 'K': value <<= 10; end++; break;
+    case 'm': case 'M': value <<= 20; end++; break;
+    case 'g': case 'G': value <<= 30; end++; break;
+  }
+
+  if (end == str || *end != 0)
+    return false;
+
+  *result = value;
+  return true;
+}
+
+
+
+// Dump what the simulated program computed and how long it took, which must
+// not depend on how instructions are executed, so that runs can be compared
+static int dump_state(iss_t *iss, const char *path)
+{
+  FILE *file = fopen(path, "w");
+  if (file == NULL) return -1;
+
+  fprintf(file, "exit_status: %d\n", iss->exit_status);
+  fprintf(file, "instructions: %lu\n", (unsigned long)iss->cpu.state.nb_insns);
+  fprintf(file, "cycles: %lu\n", (unsigned long)iss->cpu.state.nb_cycles);
+  fprintf(file, "pc: 0x%lx\n", (unsigned long)iss->cpu.current_insn->addr);
+  for (int i=0; i<ISS_NB_REGS; i++)
+    fprintf(file, "x%d: 0x%lx\n", i, (unsigned long)iss->cpu.regfile.regs[i]);
+  for (int i=0; i<ISS_NB_FREGS; i++)
+    fprintf(file, "f%d: 0x%lx\n", i, (unsigned long)iss->cpu.regfile.regs[ISS_NB_REGS + i]);
+
+  fclose(file);
+  return 0;
+}
+
+
+
+static double get_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
+
+
 int main(int argc, char **argv)
 {
   iss_t *iss;
   iss_reg_t bootaddr;
+  uint64_t mem_size = MEMORY_SIZE;
+  uint64_t max_insns = 0;
+  const char *isa = "rv32imcXpulpv2";
+  const char *histogram = NULL;
+  const char *state = NULL;
+  bool fast = true;
+  bool jit = false;
+  uint64_t jit_threshold = ISS_JIT_THRESHOLD;
+  bool quiet = false;
+  int verbose = 0;
+  int arg;
+
+  for (arg=1; arg<argc && argv[arg][0] == '-'; arg++)
+  {
+    const char *opt = argv[arg];
+
+    if (strncmp(opt, "--mem-size=", 11) == 0)
+    {
+      if (!parse_size(opt + 11, &mem_size) || mem_size == 0 || mem_size > (1ULL << 32))
+      {
+        fprintf(stderr, "Invalid memory size: %s\n", opt + 11);
+        return ISS_EXIT_USAGE;
+      }
+    }
+    else if (strncmp(opt, "--max-insns=", 12) == 0)
+    {
+      if (!parse_size(opt + 12, &max_insns))
+      {
+        fprintf(stderr, "Invalid instruction count: %s\n", opt + 12);
+        return ISS_EXIT_USAGE;
+      }
+    }
+    else if (strncmp(opt, "--isa=", 6) == 0)
+    {
+      isa = opt + 6;
+    }
+    else if (strncmp(opt, "--histogram=", 12) == 0)
+    {
+      histogram = opt + 12;
+    }
+    else if (strncmp(opt, "--state=", 8) == 0)
+    {
+      state = opt + 8;
+    }
+    else if (strcmp(opt, "--no-fast") == 0)
+    {
+      fast = false;
+    }
+    else if (strcmp(opt, "--jit") == 0)
+    {
+      jit = true;
+    }
+    else if (strncmp(opt, "--jit-threshold=", 16) == 0)
+    {
+      if (!parse_size(opt + 16, &jit_threshold) || jit_threshold == 0 || jit_threshold > INT32_MAX)
+      {
+        fprintf(stderr, "Invalid JIT threshold: %s\n", opt + 16);
+        return ISS_EXIT_USAGE;
+      }
+    }
+    else if (strcmp(opt, "--quiet") == 0)
+    {
+      quiet = true;
+    }
+    else if (strcmp(opt, "--verbose") == 0)
+    {
+      verbose = 1;
+    }
+    else if (strcmp(opt, "--help") == 0 || strcmp(opt, "-h") == 0)
+    {
+      usage(argv[0]);
+      return 0;
+    }
+    else
+    {
+      fprintf(stderr, "Unknown option: %s\n", opt);
+      usage(argv[0]);
+      return ISS_EXIT_USAGE;
+    }
+  }
+
+  if (arg == argc)
+  {
+    usage(argv[0]);
+    return ISS_EXIT_USAGE;
+  }
 
-  iss = new iss_t;
+  iss = new iss_t();
 
   iss->fast_mode = 0;
-  iss->mem_size = MEMORY_SIZE;
-  iss->mem_array = (unsigned char *)malloc(MEMORY_SIZE);
-  if (iss->mem_array == NULL) return -1;
+  iss->hit_exit = 0;
+  iss->exit_status = 0;
+  iss->verbose = verbose;
+  // Translated blocks are only executed in fast mode
+  iss->cpu.jit.enabled = jit && fast;
+  iss->cpu.jit.threshold = jit_threshold;
+  iss->cpu.insn_cache.histogram = histogram != NULL;
+  iss->mem_size = mem_size;
 
-  if (load_binary(iss, argv[1], argc, argv, &bootaddr))
-    return -1;
+  // The memory is reserved but only the pages touched by the simulated
+  // program are really allocated, so that big memories are cheap
+  void *mem = mmap(NULL, mem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (mem == MAP_FAILED)
+  {
+    fprintf(stderr, "Failed to allocate simulated memory (size: 0x%lx)\n", (unsigned long)mem_size);
+    return ISS_EXIT_USAGE;
+  }
+  iss->mem_array = (unsigned char *)mem;
+
+  // The simulated program sees its binary as argv[0]
+  if (load_binary(iss, argv[arg], argc - arg, &argv[arg], &bootaddr))
+    return ISS_EXIT_USAGE;
 
-  iss->cpu.config.isa = strdup("rv32imcXpulpv2");
+  iss->cpu.config.isa = strdup(isa);
 
-  if (iss_open(iss)) return -1;
+  if (iss_open(iss)) return ISS_EXIT_USAGE;
 
   iss_start(iss);
  
   iss_pc_set(iss, bootaddr);
 
-#ifdef FAST_LOOP
+  double start_time = get_time();
 
-  // Experimental, not yet fully stable
+  if (max_insns == 0)
+    max_insns = UINT64_MAX;
 
   do
   {
-    iss->fast_mode = iss_exec_switch_to_fast(iss);
+    iss->fast_mode = fast && iss_exec_switch_to_fast(iss);
 
     if (iss->fast_mode)
     {
       // The fast mode is only executing instructions
       // and can be used when there is no check to do
       // like interupts, HW loops or performance
-      // counters
-      do
+      // counters. Anything changing this (CSR write, interrupt
+      // enable, exit, error) clears fast_mode through the platform
+      // hooks so that we come back to the full checks.
+      // The JIT is disabled by iss_open if the host does not support it.
+      // A translated block executes up to ISS_JIT_MAX_INSNS instructions, so
+      // the last ones before the instruction limit are interpreted to stop
+      // exactly on it.
+      if (iss->cpu.jit.enabled)
+      {
+        while (iss->fast_mode && iss->cpu.state.nb_insns + ISS_JIT_MAX_INSNS < max_insns)
+        {
+          iss_exec_step_nofetch_jit(iss);
+        }
+      }
+
+      while (iss->fast_mode && iss->cpu.state.nb_insns < max_insns)
       {
         iss_exec_step(iss);
-      } while(iss->fast_mode);
+      }
     }
     else
     {
@@ -78,16 +270,33 @@ int main(int argc, char **argv)
       // also always be called to simplify
       iss_exec_step_check_all(iss);
     }
+
+    if (iss->cpu.state.nb_insns >= max_insns && !iss->hit_exit)
+    {
+      fprintf(stderr, "Reached maximum number of instructions (%lu), aborting simulation\n", (unsigned long)max_insns);
+      iss_exit(iss, ISS_EXIT_TIMEOUT);
+    }
   } while (iss->hit_exit == 0);
 
-#else
-  
-  while (iss->hit_exit == 0)
+  double duration = get_time() - start_time;
+
+  if (histogram && iss_histogram_dump(iss, histogram))
   {
-    iss_exec_step_check_all(iss);
+    fprintf(stderr, "Failed to dump execution histogram (path: %s)\n", histogram);
   }
 
-#endif
+  if (state && dump_state(iss, state))
+  {
+    fprintf(stderr, "Failed to dump state (path: %s)\n", state);
+  }
+
+  if (!quiet)
+  {
+    uint64_t nb_insns = iss->cpu.state.nb_insns;
+    fprintf(stderr, "[ISS] Exit status: %d, instructions: %lu, cycles: %lu, time: %.3f s, speed: %.2f MIPS\n",
+      iss->exit_status, (unsigned long)nb_insns, (unsigned long)iss->cpu.state.nb_cycles, duration,
+      duration > 0 ? nb_insns / duration / 1000000.0 : 0.0);
+  }
 
   return iss->exit_status;
 }
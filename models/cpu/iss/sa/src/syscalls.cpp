@@ -81,16 +81,21 @@
 
 static char IO_Buffer[IO_SIZE_MAX];
 
-static void sim_io_error(iss_insn_t *At_PC, const char *Message, ...)
+void iss_abort(iss_t *iss, iss_insn_t *At_PC, const char *Message, ...)
 
 {
   va_list Args;
 
   va_start(Args, Message);
-  fprintf(stderr, "Error At PC=%X:", At_PC->addr);
+  fprintf(stderr, "Error At PC=%X: ", At_PC->addr);
   vfprintf(stderr, Message, Args);
   fprintf(stderr, ". Aborting simulation\n");
-  exit(0);
+  va_end(Args);
+
+  // Only report the first error, the current instruction may trigger
+  // several of them before the main loop stops
+  if (!iss->hit_exit)
+    iss_exit(iss, ISS_EXIT_ABORT);
 }
 
 static void sim_io_eprintf(const char *Message, ...)
@@ -114,7 +119,7 @@ static int copy_name(iss_t *cpu, iss_insn_t *pc, unsigned int rv32_buff, char *H
     if (c == 0) break;
     Host_buff[i++] = c;
     if (i == (MAX_FNAME_LENGTH-1)) {
-          sim_io_error (pc, "Max file/path name length exceed");
+          iss_abort (iss, pc, "Max file/path name length exceed");
       i--;
       break;
     }
@@ -159,7 +164,8 @@ void handle_syscall(iss_t *iss, iss_insn_t *pc)
         unsigned int stack = iss_get_reg(iss, 12);
         unsigned int sp = iss_get_reg(iss, 2);
         unsigned int gp = iss_get_reg(iss, 3);
-        printf("Mem request: Head: %8X, Incr: %8X, Stack: %8X, Sp: %8X, Gp: %8X, New Head: %8X, Gap Frame/Stack: %d\n",
+        if (iss->verbose)
+          fprintf(stderr, "Mem request: Head: %8X, Incr: %8X, Stack: %8X, Sp: %8X, Gp: %8X, New Head: %8X, Gap Frame/Stack: %d\n",
           head_ptr, incr, stack, sp, gp, (head_ptr+incr), (int) (sp - (head_ptr+incr)));
 
       }
@@ -178,8 +184,12 @@ void handle_syscall(iss_t *iss, iss_insn_t *pc)
       }
       break;
     case RV_SYS_exit:
+    case RV_SYS_exit_group:
       iss_exit(iss, iss_get_reg(iss, 10));
       break;
+    case RV_SYS_getpid:
+      iss_set_reg(iss, 10, getpid());
+      break;
     case RV_SYS_close:
       {
         int fd = iss_get_reg(iss, 10);     // fd in a0
@@ -233,8 +243,15 @@ void handle_syscall(iss_t *iss, iss_insn_t *pc)
         while (Len != 0) {
           unsigned int L = (Len > IO_SIZE_MAX)?IO_SIZE_MAX:Len;
           ssize_t L1 = read(fd, IO_Buffer, L);
+          if (L1 < 0) {
+            if (Read_Len == 0) Read_Len = -1;
+            break;
+          }
           Read_Len += L1;
           for (i = 0; i<L1; i++) storeByte(iss, (buffer+i+Off), IO_Buffer[i]);
+          // Stop on short reads (end of file, terminal input) instead of
+          // blocking again for the rest of the buffer
+          if (L1 < L) break;
           Len -= L;
           Off += L;
         }
@@ -477,7 +494,7 @@ void handle_syscall(iss_t *iss, iss_insn_t *pc)
     default:
       errno = EBADRQC;
       iss_set_reg(iss, 10, -1);
-          sim_io_error (pc, "SYS call %X (%d) not supported", sys_fun, sys_fun);
+          iss_abort (iss, pc, "SYS call %X (%d) not supported", sys_fun, sys_fun);
       break;
   }
 }
\ No newline at end of file
@@ -862,14 +862,15 @@ static bool umode_read(iss_t *iss, iss_reg_t *value) {
 
 
 static bool pcer_write(iss_t *iss, unsigned int prev_val, unsigned int value) {
+  iss_pccr_update(iss);
   iss->cpu.csr.pcer = value;
   check_perf_config_change(iss, prev_val, iss->cpu.csr.pcmr);
   return false;
 }
 
 static bool pcmr_write(iss_t *iss, unsigned int prev_val, unsigned int value) {
+  iss_pccr_update(iss);
   iss->cpu.csr.pcmr = value;
-  iss->cpu.state.hw_counter_en = iss->cpu.csr.pcmr & CSR_PCMR_ACTIVE;
 
   check_perf_config_change(iss, iss->cpu.csr.pcer, prev_val);
   return false;
@@ -934,6 +935,8 @@ void flushExternalCounters(iss_t *iss)
 }
 
 static bool perfCounters_read(iss_t *iss, int reg, iss_reg_t *value) {
+  iss_pccr_update(iss);
+
   // In case of counters connected to external signals, we need to synchronize first
   if (reg >= CSR_PCCR(CSR_PCER_NB_INTERNAL_EVENTS) && reg < CSR_PCCR(CSR_NB_PCCR))
   {
@@ -983,6 +986,8 @@ static bool perfCounters_write(iss_t *iss, int reg, unsigned int value)
   {
     iss_perf_counter_msg(iss, "Setting value to all PCCR (value: 0x%x)\n", value);
 
+    iss_pccr_update(iss);
+
     int i;
     for (i=0; i<CSR_PCER_NB_EVENTS; i++)
     {
@@ -996,6 +1001,7 @@ static bool perfCounters_write(iss_t *iss, int reg, unsigned int value)
   else
   {
     iss_perf_counter_msg(iss, "Setting PCCR value (pccr: %d, value: 0x%x)\n", reg - CSR_PCCR(0), value);
+    iss_pccr_update(iss);
     iss->cpu.csr.pccr[reg - CSR_PCCR(0)] = value;
   }
   return false;
@@ -1325,6 +1331,7 @@ void iss_csr_init(iss_t *iss)
   iss->cpu.csr.mcause = 0;
 #if defined(ISS_HAS_PERF_COUNTERS)
   iss->cpu.csr.pcmr = 3;
+  iss->cpu.csr.pcer = 0;
 #endif
   iss->cpu.csr.stack_conf = 0;
 }
@@ -0,0 +1,778 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Debug information of the simulated binaries, used to show the function,
+// file and line of the executed instructions in the traces.
+//
+// It is read directly from the symbol table and from the DWARF line table of
+// the ELF binaries, or from the text files generated by pulp-pc-info, and is
+// kept as address intervals sorted by address, which point to interned
+// strings.
+
+#include "iss.hpp"
+#include <elf.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+typedef struct {
+  uint64_t start;
+  uint64_t end;
+  const char *name;
+} debug_func_t;
+
+typedef struct {
+  uint64_t start;
+  uint64_t end;
+  const char *file;
+  const char *inline_func;  // Only known from pulp-pc-info files, NULL otherwise
+  int line;
+} debug_line_t;
+
+// Tell if two entries give the same information, whatever their intervals.
+// The strings are shared through debug_strings so their pointers are compared.
+static inline bool debug_same_info(const debug_func_t &a, const debug_func_t &b)
+{
+  return a.name == b.name;
+}
+
+static inline bool debug_same_info(const debug_line_t &a, const debug_line_t &b)
+{
+  return a.file == b.file && a.inline_func == b.inline_func && a.line == b.line;
+}
+
+template<typename T> class debug_index
+{
+public:
+  // Intervals are added in any order and sorted on the first lookup after
+  // they have been modified
+  inline void add(const T &entry);
+  inline const T *get(uint64_t addr);
+
+private:
+  static bool compare(const T &a, const T &b) { return a.start < b.start; }
+
+  std::vector<T> entries;
+  bool sorted = true;
+  const T *last = NULL;
+};
+
+template<typename T> inline void debug_index<T>::add(const T &entry)
+{
+  if (entry.end <= entry.start)
+    return;
+
+  // Contiguous entries with the same information, like the PCs of the same
+  // line in pulp-pc-info files, are merged
+  if (this->entries.size() != 0)
+  {
+    T *prev = &this->entries.back();
+    if (prev->end == entry.start && debug_same_info(*prev, entry))
+    {
+      prev->end = entry.end;
+      this->sorted = false;
+      this->last = NULL;
+      return;
+    }
+  }
+
+  this->entries.push_back(entry);
+  this->sorted = false;
+  this->last = NULL;
+}
+
+template<typename T> inline const T *debug_index<T>::get(uint64_t addr)
+{
+  // Consecutive lookups are usually for the same function or line
+  if (this->last && addr >= this->last->start && addr < this->last->end)
+    return this->last;
+
+  if (!this->sorted)
+  {
+    std::stable_sort(this->entries.begin(), this->entries.end(), compare);
+    this->sorted = true;
+  }
+
+  T key;
+  memset(&key, 0, sizeof(key));
+  key.start = addr;
+  auto it = std::upper_bound(this->entries.begin(), this->entries.end(), key, compare);
+  if (it == this->entries.begin())
+    return NULL;
+
+  const T *entry = &*(it - 1);
+  if (addr >= entry->end)
+    return NULL;
+
+  this->last = entry;
+  return entry;
+}
+
+static debug_index<debug_func_t> debug_funcs;
+static debug_index<debug_line_t> debug_lines;
+static std::unordered_set<std::string> debug_strings;
+static std::vector<std::string> binaries;
+
+// Strings are kept only once whatever the number of intervals using them.
+// Pointers to the elements of an unordered set stay valid when it grows.
+static const char *debug_string(const char *str, size_t len)
+{
+  return debug_strings.insert(std::string(str, len)).first->c_str();
+}
+
+static const char *debug_string(std::string str)
+{
+  return debug_strings.insert(str).first->c_str();
+}
+
+
+
+/*
+ * DWARF line table
+ */
+
+#define DW_LNS_copy               1
+#define DW_LNS_advance_pc         2
+#define DW_LNS_advance_line       3
+#define DW_LNS_set_file           4
+#define DW_LNS_const_add_pc       8
+#define DW_LNS_fixed_advance_pc   9
+
+#define DW_LNE_end_sequence       1
+#define DW_LNE_set_address        2
+#define DW_LNE_define_file        3
+
+#define DW_LNCT_path              1
+#define DW_LNCT_directory_index   2
+
+#define DW_FORM_block2            0x03
+#define DW_FORM_block4            0x04
+#define DW_FORM_data2             0x05
+#define DW_FORM_data4             0x06
+#define DW_FORM_data8             0x07
+#define DW_FORM_string            0x08
+#define DW_FORM_block             0x09
+#define DW_FORM_block1            0x0a
+#define DW_FORM_data1             0x0b
+#define DW_FORM_sdata             0x0d
+#define DW_FORM_strp              0x0e
+#define DW_FORM_udata             0x0f
+#define DW_FORM_data16            0x1e
+#define DW_FORM_line_strp         0x1f
+
+typedef struct {
+  const uint8_t *ptr;
+  const uint8_t *end;
+  bool error;
+} dwarf_reader_t;
+
+typedef struct {
+  const uint8_t *data;
+  uint64_t size;
+} dwarf_section_t;
+
+typedef struct {
+  const char *name;
+  uint64_t dir;
+  const char *path;     // Full path, computed when the file is first used
+} dwarf_file_t;
+
+// The readers never go past their end, they return 0 and flag an error
+// instead, which aborts the current unit
+static inline uint64_t dwarf_read(dwarf_reader_t *reader, int size)
+{
+  if (reader->end - reader->ptr < size)
+  {
+    reader->error = true;
+    reader->ptr = reader->end;
+    return 0;
+  }
+
+  uint64_t value = 0;
+  for (int i=0; i<size; i++)
+  {
+    value |= (uint64_t)reader->ptr[i] << (i*8);
+  }
+  reader->ptr += size;
+  return value;
+}
+
+static inline uint64_t dwarf_read_uleb(dwarf_reader_t *reader)
+{
+  uint64_t value = 0;
+  int shift = 0;
+  while (1)
+  {
+    uint8_t byte = dwarf_read(reader, 1);
+    if (shift < 64)
+      value |= (uint64_t)(byte & 0x7f) << shift;
+    shift += 7;
+    if ((byte & 0x80) == 0 || reader->error)
+      return value;
+  }
+}
+
+static inline int64_t dwarf_read_sleb(dwarf_reader_t *reader)
+{
+  int64_t value = 0;
+  int shift = 0;
+  uint8_t byte;
+  do
+  {
+    byte = dwarf_read(reader, 1);
+    if (shift < 64)
+      value |= (uint64_t)(byte & 0x7f) << shift;
+    shift += 7;
+  } while ((byte & 0x80) && !reader->error);
+
+  if (shift < 64 && (byte & 0x40))
+    value |= -((int64_t)1 << shift);
+
+  return value;
+}
+
+static inline const char *dwarf_read_str(dwarf_reader_t *reader)
+{
+  const char *str = (const char *)reader->ptr;
+  size_t len = strnlen(str, reader->end - reader->ptr);
+  if (len == (size_t)(reader->end - reader->ptr))
+  {
+    reader->error = true;
+    reader->ptr = reader->end;
+    return "";
+  }
+  reader->ptr += len + 1;
+  return str;
+}
+
+static inline void dwarf_skip(dwarf_reader_t *reader, uint64_t size)
+{
+  if ((uint64_t)(reader->end - reader->ptr) < size)
+  {
+    reader->error = true;
+    reader->ptr = reader->end;
+  }
+  else
+  {
+    reader->ptr += size;
+  }
+}
+
+static const char *dwarf_section_str(dwarf_section_t *section, uint64_t offset)
+{
+  if (section->data == NULL || offset >= section->size)
+    return "";
+
+  const char *str = (const char *)section->data + offset;
+  if (strnlen(str, section->size - offset) == section->size - offset)
+    return "";
+
+  return str;
+}
+
+// Reads a value of a DWARF 5 directory or file entry. Only strings and
+// unsigned values are returned, the other forms are skipped.
+static uint64_t dwarf_read_form(dwarf_reader_t *reader, uint64_t form, int offset_size,
+  dwarf_section_t *debug_str, dwarf_section_t *debug_line_str, const char **str)
+{
+  *str = NULL;
+
+  switch (form)
+  {
+    case DW_FORM_string:    *str = dwarf_read_str(reader); return 0;
+    case DW_FORM_strp:      *str = dwarf_section_str(debug_str, dwarf_read(reader, offset_size)); return 0;
+    case DW_FORM_line_strp: *str = dwarf_section_str(debug_line_str, dwarf_read(reader, offset_size)); return 0;
+    case DW_FORM_data1:     return dwarf_read(reader, 1);
+    case DW_FORM_data2:     return dwarf_read(reader, 2);
+    case DW_FORM_data4:     return dwarf_read(reader, 4);
+    case DW_FORM_data8:     return dwarf_read(reader, 8);
+    case DW_FORM_data16:    dwarf_skip(reader, 16); return 0;
+    case DW_FORM_udata:     return dwarf_read_uleb(reader);
+    case DW_FORM_sdata:     return dwarf_read_sleb(reader);
+    case DW_FORM_block:     dwarf_skip(reader, dwarf_read_uleb(reader)); return 0;
+    case DW_FORM_block1:    dwarf_skip(reader, dwarf_read(reader, 1)); return 0;
+    case DW_FORM_block2:    dwarf_skip(reader, dwarf_read(reader, 2)); return 0;
+    case DW_FORM_block4:    dwarf_skip(reader, dwarf_read(reader, 4)); return 0;
+  }
+
+  reader->error = true;
+  return 0;
+}
+
+// Reads the DWARF 5 directory or file table
+static void dwarf_read_entries(dwarf_reader_t *reader, int offset_size, dwarf_section_t *debug_str,
+  dwarf_section_t *debug_line_str, std::vector<dwarf_file_t> &entries)
+{
+  std::vector<std::pair<uint64_t, uint64_t>> formats;
+  int nb_formats = dwarf_read(reader, 1);
+  for (int i=0; i<nb_formats; i++)
+  {
+    uint64_t content = dwarf_read_uleb(reader);
+    uint64_t form = dwarf_read_uleb(reader);
+    formats.push_back(std::make_pair(content, form));
+  }
+
+  uint64_t nb_entries = dwarf_read_uleb(reader);
+  for (uint64_t i=0; i<nb_entries && !reader->error; i++)
+  {
+    dwarf_file_t entry = { "", 0, NULL };
+    for (auto &format: formats)
+    {
+      const char *str;
+      uint64_t value = dwarf_read_form(reader, format.second, offset_size, debug_str, debug_line_str, &str);
+      if (format.first == DW_LNCT_path && str)
+        entry.name = str;
+      else if (format.first == DW_LNCT_directory_index)
+        entry.dir = value;
+    }
+    entries.push_back(entry);
+  }
+}
+
+static const char *dwarf_file_path(std::vector<dwarf_file_t> &files, std::vector<dwarf_file_t> &dirs, uint64_t index)
+{
+  if (index >= files.size())
+    return "-";
+
+  dwarf_file_t *file = &files[index];
+  if (file->path == NULL)
+  {
+    const char *dir = file->dir < dirs.size() ? dirs[file->dir].name : "";
+    if (file->name[0] == '/' || dir[0] == 0)
+      file->path = debug_string(file->name, strlen(file->name));
+    else
+      file->path = debug_string(std::string(dir) + "/" + file->name);
+  }
+
+  return file->path;
+}
+
+// Decodes one unit of the line table and adds an interval for each row,
+// which goes up to the address of the next row
+static void dwarf_parse_line_unit(dwarf_reader_t *reader, dwarf_section_t *debug_str, dwarf_section_t *debug_line_str)
+{
+  int offset_size = 4;
+  uint64_t unit_length = dwarf_read(reader, 4);
+  if (unit_length == 0xffffffff)
+  {
+    offset_size = 8;
+    unit_length = dwarf_read(reader, 8);
+  }
+
+  if (reader->error || unit_length > (uint64_t)(reader->end - reader->ptr))
+  {
+    reader->error = true;
+    return;
+  }
+
+  dwarf_reader_t unit = { reader->ptr, reader->ptr + unit_length, false };
+  reader->ptr += unit_length;
+
+  int version = dwarf_read(&unit, 2);
+  if (version < 2 || version > 5)
+    return;
+
+  if (version >= 5)
+  {
+    dwarf_read(&unit, 1);   // address_size
+    dwarf_read(&unit, 1);   // segment_selector_size
+  }
+
+  uint64_t header_length = dwarf_read(&unit, offset_size);
+  if (header_length > (uint64_t)(unit.end - unit.ptr))
+    return;
+  const uint8_t *program = unit.ptr + header_length;
+
+  int min_insn_length = dwarf_read(&unit, 1);
+  if (version >= 4)
+    dwarf_read(&unit, 1);   // maximum_operations_per_instruction
+  bool default_is_stmt = dwarf_read(&unit, 1);
+  int line_base = (int8_t)dwarf_read(&unit, 1);
+  int line_range = dwarf_read(&unit, 1);
+  int opcode_base = dwarf_read(&unit, 1);
+
+  std::vector<uint8_t> opcode_lengths(opcode_base > 0 ? opcode_base : 1, 0);
+  for (int i=1; i<opcode_base; i++)
+  {
+    opcode_lengths[i] = dwarf_read(&unit, 1);
+  }
+
+  // Before DWARF 5, index 0 of the directories is the compilation directory
+  // and the files start at index 1
+  std::vector<dwarf_file_t> dirs;
+  std::vector<dwarf_file_t> files;
+
+  if (version >= 5)
+  {
+    dwarf_read_entries(&unit, offset_size, debug_str, debug_line_str, dirs);
+    dwarf_read_entries(&unit, offset_size, debug_str, debug_line_str, files);
+  }
+  else
+  {
+    dirs.push_back({ "", 0, NULL });
+    while (!unit.error)
+    {
+      const char *dir = dwarf_read_str(&unit);
+      if (dir[0] == 0)
+        break;
+      dirs.push_back({ dir, 0, NULL });
+    }
+
+    files.push_back({ "", 0, NULL });
+    while (!unit.error)
+    {
+      const char *name = dwarf_read_str(&unit);
+      if (name[0] == 0)
+        break;
+      uint64_t dir = dwarf_read_uleb(&unit);
+      dwarf_read_uleb(&unit);   // modification time
+      dwarf_read_uleb(&unit);   // size
+      files.push_back({ name, dir, NULL });
+    }
+  }
+
+  if (unit.error || line_range == 0)
+    return;
+
+  unit.ptr = program;
+
+  uint64_t address = 0;
+  uint64_t file = 1;
+  int64_t line = 1;
+
+  bool has_row = false;
+  uint64_t row_address = 0;
+  uint64_t row_file = 0;
+  int64_t row_line = 0;
+
+  while (unit.ptr < unit.end && !unit.error)
+  {
+    int opcode = dwarf_read(&unit, 1);
+    bool emit_row = false;
+    bool end_sequence = false;
+
+    if (opcode >= opcode_base)
+    {
+      int adjusted = opcode - opcode_base;
+      address += (adjusted / line_range) * min_insn_length;
+      line += line_base + adjusted % line_range;
+      emit_row = true;
+    }
+    else if (opcode == 0)
+    {
+      uint64_t len = dwarf_read_uleb(&unit);
+      const uint8_t *next = unit.ptr + len;
+      if (len == 0 || len > (uint64_t)(unit.end - unit.ptr))
+        break;
+
+      int sub_opcode = dwarf_read(&unit, 1);
+      if (sub_opcode == DW_LNE_end_sequence)
+      {
+        emit_row = true;
+        end_sequence = true;
+      }
+      else if (sub_opcode == DW_LNE_set_address)
+      {
+        address = dwarf_read(&unit, len - 1 > 8 ? 8 : len - 1);
+      }
+      else if (sub_opcode == DW_LNE_define_file)
+      {
+        const char *name = dwarf_read_str(&unit);
+        uint64_t dir = dwarf_read_uleb(&unit);
+        files.push_back({ name, dir, NULL });
+      }
+      unit.ptr = next;
+    }
+    else if (opcode == DW_LNS_copy)
+    {
+      emit_row = true;
+    }
+    else if (opcode == DW_LNS_advance_pc)
+    {
+      address += dwarf_read_uleb(&unit) * min_insn_length;
+    }
+    else if (opcode == DW_LNS_advance_line)
+    {
+      line += dwarf_read_sleb(&unit);
+    }
+    else if (opcode == DW_LNS_set_file)
+    {
+      file = dwarf_read_uleb(&unit);
+    }
+    else if (opcode == DW_LNS_const_add_pc)
+    {
+      address += ((255 - opcode_base) / line_range) * min_insn_length;
+    }
+    else if (opcode == DW_LNS_fixed_advance_pc)
+    {
+      address += dwarf_read(&unit, 2);
+    }
+    else
+    {
+      // Other standard opcodes only change the state of rows we don't use
+      for (int i=0; i<opcode_lengths[opcode]; i++)
+      {
+        dwarf_read_uleb(&unit);
+      }
+    }
+
+    if (emit_row)
+    {
+      if (has_row && address > row_address)
+      {
+        debug_lines.add({ row_address, address, dwarf_file_path(files, dirs, row_file), NULL, (int)row_line });
+      }
+
+      has_row = !end_sequence;
+      row_address = address;
+      row_file = file;
+      row_line = line;
+
+      if (end_sequence)
+      {
+        address = 0;
+        file = 1;
+        line = 1;
+      }
+    }
+  }
+
+  (void)default_is_stmt;
+}
+
+
+
+/*
+ * ELF binaries
+ */
+
+template<typename Ehdr, typename Shdr, typename Sym>
+static int elf_load(iss_t *iss, const char *binary, const uint8_t *data, uint64_t size)
+{
+  if (size < sizeof(Ehdr))
+    return -1;
+
+  const Ehdr *ehdr = (const Ehdr *)data;
+  if (ehdr->e_shoff == 0 || ehdr->e_shentsize != sizeof(Shdr) ||
+    ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Shdr) > size || ehdr->e_shstrndx >= ehdr->e_shnum)
+  {
+    return -1;
+  }
+
+  const Shdr *shdrs = (const Shdr *)(data + ehdr->e_shoff);
+  const Shdr *shstrtab = &shdrs[ehdr->e_shstrndx];
+
+  for (int i=0; i<ehdr->e_shnum; i++)
+  {
+    if (shdrs[i].sh_type != SHT_NOBITS && shdrs[i].sh_offset + shdrs[i].sh_size > size)
+      return -1;
+  }
+
+  dwarf_section_t debug_line = { NULL, 0 };
+  dwarf_section_t debug_str = { NULL, 0 };
+  dwarf_section_t debug_line_str = { NULL, 0 };
+
+  for (int i=0; i<ehdr->e_shnum; i++)
+  {
+    const Shdr *shdr = &shdrs[i];
+
+    if (shdr->sh_type == SHT_SYMTAB && shdr->sh_link < ehdr->e_shnum)
+    {
+      const Sym *syms = (const Sym *)(data + shdr->sh_offset);
+      const Shdr *strtab = &shdrs[shdr->sh_link];
+      dwarf_section_t strings = { data + strtab->sh_offset, strtab->sh_size };
+      int nb_syms = shdr->sh_size / sizeof(Sym);
+
+      for (int j=0; j<nb_syms; j++)
+      {
+        const Sym *sym = &syms[j];
+        if ((sym->st_info & 0xf) == STT_FUNC && sym->st_shndx != SHN_UNDEF && sym->st_size != 0)
+        {
+          const char *name = dwarf_section_str(&strings, sym->st_name);
+          debug_funcs.add({ sym->st_value, sym->st_value + sym->st_size, debug_string(name, strlen(name)) });
+        }
+      }
+    }
+    else if (shstrtab->sh_type != SHT_NOBITS && shdr->sh_name < shstrtab->sh_size)
+    {
+      dwarf_section_t names = { data + shstrtab->sh_offset, shstrtab->sh_size };
+      const char *name = dwarf_section_str(&names, shdr->sh_name);
+      dwarf_section_t section = { data + shdr->sh_offset, shdr->sh_size };
+
+      if (strcmp(name, ".debug_line") == 0)
+        debug_line = section;
+      else if (strcmp(name, ".debug_str") == 0)
+        debug_str = section;
+      else if (strcmp(name, ".debug_line_str") == 0)
+        debug_line_str = section;
+    }
+  }
+
+  if (debug_line.data)
+  {
+    dwarf_reader_t reader = { debug_line.data, debug_line.data + debug_line.size, false };
+    while (reader.ptr < reader.end && !reader.error)
+    {
+      dwarf_parse_line_unit(&reader, &debug_str, &debug_line_str);
+    }
+
+    if (reader.error)
+    {
+      iss_warning(iss, "Invalid line table, debug information may be incomplete (binary: %s)\n", binary);
+    }
+  }
+
+  return 0;
+}
+
+static int elf_register_debug_info(iss_t *iss, const char *binary, int fd)
+{
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+    return -1;
+
+  void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED)
+    return -1;
+
+  const unsigned char *ident = (const unsigned char *)data;
+  int err = -1;
+
+  // Targets and hosts are both little-endian
+  if (ident[EI_DATA] == ELFDATA2LSB)
+  {
+    if (ident[EI_CLASS] == ELFCLASS32)
+      err = elf_load<Elf32_Ehdr, Elf32_Shdr, Elf32_Sym>(iss, binary, (const uint8_t *)data, st.st_size);
+    else if (ident[EI_CLASS] == ELFCLASS64)
+      err = elf_load<Elf64_Ehdr, Elf64_Shdr, Elf64_Sym>(iss, binary, (const uint8_t *)data, st.st_size);
+  }
+
+  munmap(data, st.st_size);
+
+  return err;
+}
+
+
+
+/*
+ * pulp-pc-info files
+ */
+
+// Each line gives the information of one PC:
+// <pc> <function> <inline function> <file> <line>
+static void text_register_debug_info(iss_t *iss, FILE *file)
+{
+  char *line = NULL;
+  size_t len = 0;
+  while (getline(&line, &len, file) != -1)
+  {
+    char *tokens[5];
+    int index = 0;
+    char *token = strtok(line, " \n");
+    while (token && index < 5)
+    {
+      tokens[index++] = token;
+      token = strtok(NULL, " \n");
+    }
+
+    if (index == 5 && token == NULL)
+    {
+      uint64_t pc = strtoull(tokens[0], NULL, 16);
+      debug_funcs.add({ pc, pc + 2, debug_string(tokens[1], strlen(tokens[1])) });
+      debug_lines.add({ pc, pc + 2, debug_string(tokens[3], strlen(tokens[3])),
+        debug_string(tokens[2], strlen(tokens[2])), atoi(tokens[4]) });
+    }
+  }
+
+  free(line);
+}
+
+
+
+void iss_register_debug_info(iss_t *iss, const char *binary)
+{
+  if (std::find(binaries.begin(), binaries.end(), std::string(binary)) != binaries.end())
+    return;
+
+  binaries.push_back(std::string(binary));
+
+  FILE *file = fopen(binary, "r");
+  if (file == NULL)
+  {
+    iss_warning(iss, "Unable to open debug information (binary: %s)\n", binary);
+    return;
+  }
+
+  char magic[SELFMAG];
+  if (fread(magic, 1, SELFMAG, file) == SELFMAG && memcmp(magic, ELFMAG, SELFMAG) == 0)
+  {
+    if (elf_register_debug_info(iss, binary, fileno(file)))
+    {
+      iss_warning(iss, "Invalid ELF binary, no debug information is available (binary: %s)\n", binary);
+    }
+  }
+  else
+  {
+    rewind(file);
+    text_register_debug_info(iss, file);
+  }
+
+  fclose(file);
+}
+
+const char *iss_debug_func(iss_addr_t addr, iss_addr_t *start, iss_addr_t *end)
+{
+  const debug_func_t *func_info = debug_funcs.get(addr);
+  if (func_info == NULL)
+    return NULL;
+
+  *start = func_info->start;
+  *end = func_info->end;
+
+  return func_info->name;
+}
+
+bool iss_has_debug_info()
+{
+  return binaries.size() != 0;
+}
+
+int iss_trace_pc_info(iss_addr_t addr, const char **func, const char **inline_func, const char **file, int *line)
+{
+  const debug_func_t *func_info = debug_funcs.get(addr);
+  const debug_line_t *line_info = debug_lines.get(addr);
+
+  if (func_info == NULL && line_info == NULL)
+    return -1;
+
+  *func = func_info ? func_info->name : "-";
+  *inline_func = line_info && line_info->inline_func ? line_info->inline_func : *func;
+  *file = line_info ? line_info->file : "-";
+  *line = line_info ? line_info->line : 0;
+
+  return 0;
+}
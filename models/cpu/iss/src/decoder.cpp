@@ -24,7 +24,7 @@
 extern iss_isa_set_t __iss_isa_set;
 extern iss_isa_tag_t __iss_isa_tags[];
 
-static int decode_item(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item);
+static int decode_item(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item);
 
 static uint64_t decode_ranges(iss_t *iss, iss_opcode_t opcode, iss_decoder_range_set_t *range_set, bool is_signed)
 {
@@ -44,7 +44,7 @@ static uint64_t decode_ranges(iss_t *iss, iss_opcode_t opcode, iss_decoder_range
 }
 
 
-static int decode_info(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_arg_info_t *info, bool is_signed)
+static int decode_info(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode, iss_decoder_arg_info_t *info, bool is_signed)
 {
   if (info->type == ISS_DECODER_VALUE_TYPE_RANGE)
   {
@@ -62,25 +62,15 @@ static int decode_info(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
   return 0;
 }
 
-static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
+static int decode_insn(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
 {
   if (!item->is_active) return -1;
 
-  insn->hwloop_handler = NULL;
-  insn->fast_handler = item->u.insn.fast_handler;
-  insn->handler = item->u.insn.handler;
-
   insn->decoder_item = item;
   insn->size = item->u.insn.size;
   insn->nb_out_reg = 0;
   insn->nb_in_reg = 0;
 
-  for (int i=0; i<item->u.insn.nb_args; i++)
-  {
-    insn->out_regs[i] = -1;
-    insn->in_regs[i] = -1;
-  }
-
   for (int i=0; i<item->u.insn.nb_args; i++)
   {
     iss_decoder_arg_t *darg = &item->u.insn.args[i];
@@ -115,45 +105,6 @@ static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
           insn->out_regs[darg->u.reg.id] = arg->u.reg.index;
         }
 
-        if (darg->type == ISS_DECODER_ARG_TYPE_OUT_REG && darg->u.reg.latency != 0)
-        {
-          iss_insn_t *next = insn_cache_get_decoded(iss, insn->addr + insn->size);
-
-          bool stall = false;
-
-          // We can stall the next instruction either if latency is superior
-          // to 2 (due to number of pipeline stages) or if there is a data
-          // dependency
-          if (darg->u.reg.latency > 2)
-          {
-            next->latency = darg->u.reg.latency - 1;
-            stall = true;
-          }
-
-          // Go through the registers and set the handler to the stall handler
-          // in case we find a register dependency so that we can properly
-          // handle the stall
-          for (int j=0; j<next->nb_in_reg; j++)
-          {
-            if (next->in_regs[j] == arg->u.reg.index)
-            {
-              stall = true;
-              next->latency = darg->u.reg.latency;
-              break;
-            }
-          }
-
-          if (stall)
-          {
-            next->stall_handler = next->handler;
-            next->stall_fast_handler = next->fast_handler;
-            next->handler = iss_exec_stalled_insn;
-            next->fast_handler = iss_exec_stalled_insn_fast;
-          }
-
-        }
-
-
         break;
 
       case ISS_DECODER_ARG_TYPE_UIMM:
@@ -187,17 +138,10 @@ static int decode_insn(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_de
     }
   }
 
-  insn->next = insn_cache_get(iss, insn->addr + insn->size);
-
-  if (item->u.insn.decode != NULL)
-  {
-    item->u.insn.decode(iss, insn);
-  }
-
   return 0;
 }
 
-static int decode_opcode_group(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
+static int decode_opcode_group(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
 {
   iss_opcode_t group_opcode = (opcode >> item->u.group.bit) & ((1ULL << item->u.group.width) - 1);
   iss_decoder_item_t *group_item_other = NULL;
@@ -214,18 +158,25 @@ static int decode_opcode_group(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode
   return -1;
 }
 
-static int decode_item(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
+static int decode_item(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode, iss_decoder_item_t *item)
 {
   if (item->is_insn) return decode_insn(iss, insn, opcode, item);
   else return decode_opcode_group(iss, insn, opcode, item);
 }
 
-static int decode_opcode(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode)
+int iss_decode_opcode(iss_t *iss, iss_decoded_insn_t *insn, iss_opcode_t opcode, bool use_tree)
 {
   for (int i=0; i<__iss_isa_set.nb_isa; i++)
   {
     iss_isa_t *isa = &__iss_isa_set.isa_set[i];
-    if (decode_item(iss, insn, opcode, isa->tree) == 0) return 0;
+    if (use_tree)
+    {
+      if (decode_item(iss, insn, opcode, isa->tree) == 0) return 0;
+    }
+    else
+    {
+      if (isa->decode(iss, insn, opcode) == 0) return 0;
+    }
   }
 
   iss_decoder_msg(iss, "Unknown instruction\n");
@@ -234,6 +185,158 @@ static int decode_opcode(iss_t *iss, iss_insn_t *insn, iss_opcode_t opcode)
 }
 
 
+
+// Decoded instructions are shared by all cores with the same ISA, as the
+// decoder items activated for an ISA are global
+static iss_decode_cache_t *decode_caches = NULL;
+
+iss_decode_cache_t *iss_decode_cache_get(iss_t *iss, const char *isa)
+{
+  for (iss_decode_cache_t *cache = decode_caches; cache; cache = cache->next)
+  {
+    if (strcmp(cache->isa, isa) == 0) return cache;
+  }
+
+  iss_decode_cache_t *cache = (iss_decode_cache_t *)calloc(1, sizeof(iss_decode_cache_t));
+  cache->isa = strdup(isa);
+  cache->next = decode_caches;
+  decode_caches = cache;
+
+  return cache;
+}
+
+static inline unsigned int decode_cache_hash(iss_opcode_t opcode)
+{
+  uint32_t value = (uint64_t)opcode ^ ((uint64_t)opcode >> 32);
+  return (value * 0x9E3779B1) >> (32 - ISS_DECODE_CACHE_SIZE_LOG2);
+}
+
+// Returns the decoding of the specified opcode, or NULL if it is not a
+// valid instruction for this ISA. Only the opcode bits used by the
+// instruction are kept, so that compressed instructions are shared whatever
+// the instruction following them.
+static iss_decoded_insn_t *decode_cache_get(iss_t *iss, iss_opcode_t opcode)
+{
+  iss_decode_cache_t *cache = iss->cpu.insn_cache.decode_cache;
+
+  if ((opcode & 3) != 3)
+    opcode &= 0xffff;
+
+  unsigned int index = decode_cache_hash(opcode);
+
+  for (iss_decoded_insn_t *insn = cache->insns[index]; insn; insn = insn->next)
+  {
+    if (insn->opcode == opcode)
+      return insn->decoder_item ? insn : NULL;
+  }
+
+  iss_decoded_insn_t *insn = (iss_decoded_insn_t *)calloc(1, sizeof(iss_decoded_insn_t));
+
+  for (int i=0; i<ISS_MAX_NB_OUT_REGS; i++)
+    insn->out_regs[i] = -1;
+  for (int i=0; i<ISS_MAX_NB_IN_REGS; i++)
+    insn->in_regs[i] = -1;
+
+  if (iss_decode_opcode(iss, insn, opcode, false) == -1)
+  {
+    // Illegal opcodes are also kept to not go through the decoder again
+    insn->decoder_item = NULL;
+  }
+
+  insn->opcode = opcode;
+  insn->next = cache->insns[index];
+  cache->insns[index] = insn;
+  cache->nb_insns++;
+
+  return insn->decoder_item ? insn : NULL;
+}
+
+// Install the stall handler on the instruction following the specified one if
+// it has to wait for one of its results. The next instruction is decoded if
+// it is not given and it may have to be stalled.
+static void decode_insn_stall(iss_t *iss, iss_insn_t *insn, iss_insn_t *next)
+{
+  iss_decoder_item_t *item = insn->decoded->decoder_item;
+
+  for (int i=0; i<item->u.insn.nb_args; i++)
+  {
+    iss_decoder_arg_t *darg = &item->u.insn.args[i];
+
+    // The stalls are not modeled in functional mode
+    if (darg->type == ISS_DECODER_ARG_TYPE_OUT_REG && darg->u.reg.latency != 0 && !iss_functional_mode(iss))
+    {
+      int reg = insn->decoded->args[i].u.reg.index;
+      bool stall = false;
+
+      if (next == NULL)
+        next = insn_cache_get_decoded(iss, insn->addr + insn->size);
+
+      // We can stall the next instruction either if latency is superior
+      // to 2 (due to number of pipeline stages) or if there is a data
+      // dependency
+      if (darg->u.reg.latency > 2)
+      {
+        insn_cold_get(iss, next)->latency = darg->u.reg.latency - 1;
+        stall = true;
+      }
+
+      // Go through the registers and set the handler to the stall handler
+      // in case we find a register dependency so that we can properly
+      // handle the stall
+      for (int j=0; j<next->nb_in_reg; j++)
+      {
+        if (next->in_regs[j] == reg)
+        {
+          stall = true;
+          insn_cold_get(iss, next)->latency = darg->u.reg.latency;
+          break;
+        }
+      }
+
+      // The handler is installed only once, as the two instructions can be
+      // decoded again separately when only one of them is discarded
+      if (stall && next->cold->stall_handler == NULL)
+      {
+        next->cold->stall_handler = next->handler;
+        next->cold->stall_fast_handler = next->fast_handler;
+        next->handler = iss_exec_stalled_insn;
+        next->fast_handler = iss_exec_stalled_insn_fast;
+      }
+    }
+  }
+}
+
+// Setup the core instruction from the shared decoding. This must be done by
+// each core as it involves pointers to its own instructions.
+static void decode_insn_setup(iss_t *iss, iss_insn_t *insn, iss_decoded_insn_t *decoded)
+{
+  iss_decoder_item_t *item = decoded->decoder_item;
+
+  insn->decoded = decoded;
+  insn->fast_handler = item->u.insn.fast_handler;
+  insn->handler = item->u.insn.handler;
+
+  insn->size = decoded->size;
+  insn->nb_out_reg = decoded->nb_out_reg;
+  insn->nb_in_reg = decoded->nb_in_reg;
+  for (int i=0; i<ISS_MAX_NB_OUT_REGS; i++)
+    insn->out_regs[i] = decoded->out_regs[i];
+  for (int i=0; i<ISS_MAX_NB_IN_REGS; i++)
+    insn->in_regs[i] = decoded->in_regs[i];
+  memcpy(insn->uim, decoded->uim, sizeof(insn->uim));
+
+  // The next instruction is stalled if it consumes one of our outputs
+  decode_insn_stall(iss, insn, NULL);
+
+  insn->next = insn_cache_get(iss, insn->addr + insn->size);
+
+  if (item->u.insn.decode != NULL)
+  {
+    item->u.insn.decode(iss, insn);
+  }
+}
+
+
 void iss_decode_activate_isa(iss_t *cpu, char *name)
 {
   iss_isa_tag_t *isa = &__iss_isa_tags[0];
@@ -266,24 +369,63 @@ iss_insn_t *iss_decode_pc_noexec(iss_t *iss, iss_insn_t *insn)
 
   iss_opcode_t opcode = prefetcher_get_word(iss, insn->addr);
 
+  // Get notified if the instruction is modified
+  iss_fetch_watch(iss, insn->addr);
+
   iss_decoder_msg(iss, "Got opcode (opcode: 0x%lx)\n", opcode);
 
-  if (decode_opcode(iss, insn, opcode) == -1)
+  iss_decoded_insn_t *decoded = decode_cache_get(iss, opcode);
+  if (decoded == NULL)
   {
+    insn->decoded = NULL;
     insn->handler = iss_exec_insn_illegal;
     insn->fast_handler = iss_exec_insn_illegal;
     return insn;
   }
 
-  insn->opcode = opcode;
+  decode_insn_setup(iss, insn, decoded);
+
+  if (iss->cpu.insn_cache.histogram)
+  {
+    iss_insn_cold_t *cold = insn_cold_get(iss, insn);
+    cold->histogram_handler = insn->handler;
+    cold->histogram_fast_handler = insn->fast_handler;
+    insn->handler = iss_exec_insn_with_histogram;
+    insn->fast_handler = iss_exec_insn_with_histogram_fast;
+  }
 
   if (iss_insn_trace_active(iss) || iss_insn_event_active(iss))
   {
-    insn->saved_handler = insn->handler;
+    insn_cold_get(iss, insn)->saved_handler = insn->handler;
     insn->handler = iss_exec_insn_with_trace;
     insn->fast_handler = iss_exec_insn_with_trace;
   }
 
+  // The instruction goes through the instruction cache until the core holds
+  // its line
+  if (iss->cpu.insn_cache.icache)
+  {
+    iss_icache_wrap(iss, insn);
+  }
+
+  // The instruction is not executed at all when it has a breakpoint, it is
+  // decoded again once the breakpoint is removed
+  if (iss->cpu.insn_cache.nb_breakpoints && iss_breakpoint_is_set(iss, insn->addr))
+  {
+    insn->handler = iss_exec_insn_breakpoint;
+    insn->fast_handler = iss_exec_insn_breakpoint;
+  }
+
+  // This instruction is stalled if the previous one produces one of its
+  // inputs. This is normally done when the previous one is decoded, but it
+  // may have been decoded before this one was discarded.
+  for (int i=2; i<=ISS_OPCODE_MAX_SIZE; i+=2)
+  {
+    iss_insn_t *prev = insn_cache_find(iss, insn->addr - i);
+    if (prev && prev->handler != iss_decode_pc && prev->decoded && prev->addr + prev->size == insn->addr)
+      decode_insn_stall(iss, prev, insn);
+  }
+
   return insn;
 }
 
@@ -20,13 +20,30 @@
 
 #include "iss.hpp"
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 
 void insn_init(iss_insn_t *insn, iss_addr_t addr);
 
+static void histogram_save_count(iss_insn_cache_t *cache, iss_insn_t *insn)
+{
+  if (cache->nb_flushed_counts == cache->flushed_counts_size)
+  {
+    cache->flushed_counts_size = cache->flushed_counts_size ? cache->flushed_counts_size * 2 : 1024;
+    cache->flushed_counts = (iss_insn_count_t *)realloc(cache->flushed_counts,
+      cache->flushed_counts_size * sizeof(iss_insn_count_t));
+  }
+
+  cache->flushed_counts[cache->nb_flushed_counts].addr = insn->addr;
+  cache->flushed_counts[cache->nb_flushed_counts].count = insn->cold->exec_count;
+  cache->nb_flushed_counts++;
+}
+
 static void flush_cache(iss_t *iss, iss_insn_cache_t *cache)
 {
   prefetcher_flush(iss);
+  iss_jit_flush(iss);
 
   for (int i=0; i<ISS_INSN_NB_BLOCKS; i++)
   {
@@ -34,6 +51,15 @@ static void flush_cache(iss_t *iss, iss_insn_cache_t *cache)
     while(b)
     {
       iss_insn_block_t *next = b->next;
+      for (int j=0; j<ISS_INSN_BLOCK_SIZE; j++)
+      {
+        if (b->insns[j].cold)
+        {
+          if (cache->histogram && b->insns[j].cold->exec_count)
+            histogram_save_count(cache, &b->insns[j]);
+          free(b->insns[j].cold);
+        }
+      }
       free((void *)b);
       b = next;
     }
@@ -46,22 +72,34 @@ int insn_cache_init(iss_t *iss)
 {
   iss_insn_cache_t *cache = &iss->cpu.insn_cache;
   memset(cache->blocks, 0, sizeof(iss_insn_block_t *)*ISS_INSN_NB_BLOCKS);
+  cache->decode_cache = iss_decode_cache_get(iss, iss->cpu.config.isa);
+  cache->nb_invalidations = 0;
+  cache->flushed_counts = NULL;
+  cache->nb_flushed_counts = 0;
+  cache->flushed_counts_size = 0;
+  cache->breakpoints = NULL;
+  cache->nb_breakpoints = 0;
+  cache->icache = false;
+  return 0;
 }
 
 void insn_init(iss_insn_t *insn, iss_addr_t addr) {
   insn->handler = iss_decode_pc;
   insn->fast_handler = iss_decode_pc;
   insn->addr = addr;
+  insn->decoded = NULL;
   insn->next = NULL;
-  insn->hwloop_handler = NULL;
+  insn->cold = NULL;
+  insn->jit_block = NULL;
+  insn->jit_count = 0;
 }
 
-static void insn_block_init(iss_insn_block_t *b, iss_addr_t pc)
+static void insn_block_init(iss_insn_block_t *b, iss_addr_t pc, int pc_bits)
 {
   for (int i=0; i<ISS_INSN_BLOCK_SIZE; i++)
   {
     iss_insn_t *insn = &b->insns[i];
-    insn_init(insn, pc + (i<<ISS_INSN_PC_BITS));
+    insn_init(insn, pc + (i<<pc_bits));
   }
 }
 
@@ -81,12 +119,289 @@ void iss_cache_flush(iss_t *iss)
 
 
 
-iss_insn_t *insn_cache_get(iss_t *iss, iss_addr_t pc)
+// Put back the instruction in its initial state so that it is decoded again
+// the next time it is executed. The instruction stays at the same place, as
+// other instructions or the core may still point to it, and the successor
+// pointers are kept as the instruction may be the one being executed.
+static void insn_reset(iss_insn_t *insn)
+{
+  insn->handler = iss_decode_pc;
+  insn->fast_handler = iss_decode_pc;
+  insn->decoded = NULL;
+  insn->jit_block = NULL;
+  insn->jit_count = 0;
+  if (insn->cold)
+  {
+    // The execution count is kept as the instruction is still the one at
+    // this address for the histogram
+    uint64_t exec_count = insn->cold->exec_count;
+    memset(insn->cold, 0, sizeof(iss_insn_cold_t));
+    insn->cold->exec_count = exec_count;
+  }
+}
+
+static iss_insn_block_t *insn_cache_find_block(iss_insn_cache_t *cache, iss_addr_t pc_base)
 {
-  iss_addr_t pc_base = pc & ~((1 << (ISS_INSN_BLOCK_SIZE_LOG2 + ISS_INSN_PC_BITS)) - 1);
-  unsigned insn_id = (pc >> ISS_INSN_PC_BITS) & (ISS_INSN_BLOCK_SIZE - 1);
   unsigned int block_id = pc_base & (ISS_INSN_NB_BLOCKS - 1);
+  for (iss_insn_block_t *block = cache->blocks[block_id]; block; block = block->next)
+  {
+    if (block->pc == pc_base) return block;
+  }
+  return NULL;
+}
+
+iss_insn_t *insn_cache_find(iss_t *iss, iss_addr_t pc)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  iss_addr_t block_size = 1 << (ISS_INSN_BLOCK_SIZE_LOG2 + cache->pc_bits);
+  iss_insn_block_t *b = insn_cache_find_block(cache, pc & ~(block_size - 1));
+  return b ? &b->insns[(pc >> cache->pc_bits) & (ISS_INSN_BLOCK_SIZE - 1)] : NULL;
+}
+
+// Tell if the handler of the specified hardware loop is installed on the last
+// instruction of the loop
+static bool insn_cache_hwloop_end(iss_t *iss, int index)
+{
+  iss_insn_t *insn = insn_cache_find(iss, iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND(index)]);
+  return insn && insn->cold && insn->cold->hwloop_handler;
+}
+
+void iss_cache_invalidate(iss_t *iss, iss_addr_t addr, iss_addr_t size)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  iss_addr_t block_size = 1 << (ISS_INSN_BLOCK_SIZE_LOG2 + cache->pc_bits);
+
+  // Instructions are discarded by whole blocks. The ones just around are also
+  // discarded as they can overlap the blocks, or may have installed a stall
+  // handler on their first instruction.
+  iss_addr_t start = addr & ~(block_size - 1);
+  iss_addr_t end = (addr + size + block_size - 1) & ~(block_size - 1);
+  start = start >= ISS_OPCODE_MAX_SIZE ? start - ISS_OPCODE_MAX_SIZE : 0;
+  end += ISS_OPCODE_MAX_SIZE;
+
+  // Hardware loops install their handler on the last instruction of the
+  // loop, which must be done again if it is discarded, including when it is
+  // one of the neighbours discarded below
+  bool hwloop_end[2] = { false, false };
+  for (int i=0; i<2; i++)
+  {
+    iss_addr_t lpend = iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND(i)];
+    if (lpend + ISS_OPCODE_MAX_SIZE >= start && lpend < end + ISS_OPCODE_MAX_SIZE)
+      hwloop_end[i] = insn_cache_hwloop_end(iss, i);
+  }
+
+  prefetcher_flush(iss);
+
+  int nb_blocks = 0;
+  for (iss_addr_t pc_base = start & ~(block_size - 1); pc_base < end; pc_base += block_size)
+  {
+    iss_insn_block_t *b = insn_cache_find_block(cache, pc_base);
+    if (b == NULL) continue;
+
+    nb_blocks++;
+    for (int i=0; i<ISS_INSN_BLOCK_SIZE; i++)
+    {
+      iss_insn_t *insn = &b->insns[i];
+      if (insn->addr >= start && insn->addr < end)
+      {
+        // The stall handler this instruction installed on the next one
+        // must be computed again as the instruction may have changed
+        if (insn->handler != iss_decode_pc && insn->next && insn->next->addr >= end)
+          insn_reset(insn->next);
+
+        insn_reset(insn);
+      }
+    }
+  }
+
+  if (nb_blocks == 0)
+    return;
+
+  // The stall handler the previous instructions installed on the first
+  // ones is lost with their state, so they are also discarded to install it
+  // again. Their own stall is installed again when they are decoded.
+  for (iss_addr_t pc = start - ISS_OPCODE_MAX_SIZE; pc < start; pc += 2)
+  {
+    iss_insn_t *insn = insn_cache_find(iss, pc);
+    if (insn && insn->handler != iss_decode_pc && insn->addr + insn->size >= start)
+      insn_reset(insn);
+  }
+
+  cache->nb_invalidations++;
+
+  iss_decoder_msg(iss, "Invalidating instructions (addr: 0x%lx, size: 0x%lx, nb_blocks: %d, nb_invalidations: %ld)\n",
+    start, end - start, nb_blocks, cache->nb_invalidations);
+
+  iss_jit_invalidate(iss);
+
+  for (int i=0; i<2; i++)
+  {
+    if (hwloop_end[i])
+      hwloop_set_end(iss, NULL, i, iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND(i)]);
+  }
+}
+
+
+void iss_cache_reset(iss_t *iss)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+
+  bool hwloop_end[2];
+  for (int i=0; i<2; i++)
+  {
+    hwloop_end[i] = insn_cache_hwloop_end(iss, i);
+  }
+
+  prefetcher_flush(iss);
+
+  for (int i=0; i<ISS_INSN_NB_BLOCKS; i++)
+  {
+    for (iss_insn_block_t *b = cache->blocks[i]; b; b = b->next)
+    {
+      for (int j=0; j<ISS_INSN_BLOCK_SIZE; j++)
+      {
+        insn_reset(&b->insns[j]);
+      }
+    }
+  }
+
+  iss_decoder_msg(iss, "Resetting all instructions\n");
+
+  iss_jit_invalidate(iss);
+
+  for (int i=0; i<2; i++)
+  {
+    if (hwloop_end[i])
+      hwloop_set_end(iss, NULL, i, iss->cpu.pulpv2.hwloop_regs[PULPV2_HWLOOP_LPEND(i)]);
+  }
+}
+
+
+// Breakpoints are checked when instructions are decoded, so the
+// instruction is just discarded to be decoded again with the breakpoint
+// handler, or without it when the breakpoint is removed.
+bool iss_breakpoint_is_set(iss_t *iss, iss_addr_t addr)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  for (int i=0; i<cache->nb_breakpoints; i++)
+  {
+    if (cache->breakpoints[i] == addr)
+      return true;
+  }
+  return false;
+}
+
+void iss_breakpoint_insert(iss_t *iss, iss_addr_t addr)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+
+  if (iss_breakpoint_is_set(iss, addr))
+    return;
+
+  cache->breakpoints = (iss_addr_t *)realloc(cache->breakpoints, (cache->nb_breakpoints + 1) * sizeof(iss_addr_t));
+  cache->breakpoints[cache->nb_breakpoints++] = addr;
+
+  iss_cache_invalidate(iss, addr, 1);
+}
+
+void iss_breakpoint_remove(iss_t *iss, iss_addr_t addr)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  for (int i=0; i<cache->nb_breakpoints; i++)
+  {
+    if (cache->breakpoints[i] == addr)
+    {
+      cache->breakpoints[i] = cache->breakpoints[--cache->nb_breakpoints];
+      iss_cache_invalidate(iss, addr, 1);
+      return;
+    }
+  }
+}
+
+
+// The instruction cache is modeled by installing a handler in front of the
+// instructions whose cache line is not held by the core. The first one
+// executed in the line accesses the cache, and once the line is held, each
+// instruction removes its handler the first time it is executed, so that the
+// instructions of the held lines are then executed at no cost. The handlers
+// are installed again when the cache evicts the line.
+void iss_icache_wrap(iss_t *iss, iss_insn_t *insn)
+{
+  iss_insn_cold_t *cold = insn_cold_get(iss, insn);
+
+  // Already in the chain of handlers
+  if (cold->icache_handler)
+    return;
+
+  cold->icache_handler = insn->handler;
+  cold->icache_fast_handler = insn->fast_handler;
+  insn->handler = iss_exec_insn_with_icache;
+  insn->fast_handler = iss_exec_insn_with_icache_fast;
+}
+
+void iss_icache_unwrap(iss_t *iss, iss_insn_t *insn)
+{
+  iss_insn_cold_t *cold = insn->cold;
+  iss_insn_t *(*handler)(iss_t *, iss_insn_t*) = cold->icache_handler;
+  iss_insn_t *(*fast_handler)(iss_t *, iss_insn_t*) = cold->icache_fast_handler;
+
+  // Other handlers may have been installed after ours, e.g. the hardware
+  // loop one, in which case ours must be removed from their saved handlers
+  if (insn->handler == iss_exec_insn_with_icache)
+    insn->handler = handler;
+  if (insn->fast_handler == iss_exec_insn_with_icache_fast)
+    insn->fast_handler = fast_handler;
+  if (cold->hwloop_handler == iss_exec_insn_with_icache)
+    cold->hwloop_handler = handler;
+  if (cold->stall_handler == iss_exec_insn_with_icache)
+    cold->stall_handler = handler;
+  if (cold->stall_fast_handler == iss_exec_insn_with_icache_fast)
+    cold->stall_fast_handler = fast_handler;
+  if (cold->saved_handler == iss_exec_insn_with_icache)
+    cold->saved_handler = handler;
+  if (cold->histogram_handler == iss_exec_insn_with_icache)
+    cold->histogram_handler = handler;
+  if (cold->histogram_fast_handler == iss_exec_insn_with_icache_fast)
+    cold->histogram_fast_handler = fast_handler;
+
+  cold->icache_handler = NULL;
+  cold->icache_fast_handler = NULL;
+}
+
+void iss_icache_evict(iss_t *iss, iss_addr_t addr, iss_addr_t size)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  iss_addr_t block_size = 1 << (ISS_INSN_BLOCK_SIZE_LOG2 + cache->pc_bits);
+  iss_insn_block_t *b = NULL;
+
+  iss_decoder_msg(iss, "Evicting instruction cache line (addr: 0x%lx, size: 0x%lx)\n", addr, size);
+
+  for (iss_addr_t pc = addr & ~((1 << cache->pc_bits) - 1); pc < addr + size; pc += 1 << cache->pc_bits)
+  {
+    if (b == NULL || b->pc != (pc & ~(block_size - 1)))
+    {
+      b = insn_cache_find_block(cache, pc & ~(block_size - 1));
+      if (b == NULL)
+      {
+        pc = (pc | (block_size - 1)) + 1 - (1 << cache->pc_bits);
+        continue;
+      }
+    }
+
+    // Instructions not decoded yet get the handler when they are decoded
+    iss_insn_t *insn = &b->insns[(pc >> cache->pc_bits) & (ISS_INSN_BLOCK_SIZE - 1)];
+    if (insn->handler != iss_decode_pc)
+      iss_icache_wrap(iss, insn);
+  }
+}
+
+
+iss_insn_t *insn_cache_get(iss_t *iss, iss_addr_t pc)
+{
   iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  iss_addr_t pc_base = pc & ~((1 << (ISS_INSN_BLOCK_SIZE_LOG2 + cache->pc_bits)) - 1);
+  unsigned insn_id = (pc >> cache->pc_bits) & (ISS_INSN_BLOCK_SIZE - 1);
+  unsigned int block_id = pc_base & (ISS_INSN_NB_BLOCKS - 1);
   iss_insn_block_t *block = cache->blocks[block_id];
 
   while (block)
@@ -101,14 +416,76 @@ iss_insn_t *insn_cache_get(iss_t *iss, iss_addr_t pc)
   b->next = cache->blocks[block_id];
   cache->blocks[block_id] = b;
 
-  insn_block_init(b, pc_base);
+  insn_block_init(b, pc_base, cache->pc_bits);
 
   return &b->insns[insn_id];
 }
 
+iss_insn_cold_t *insn_cold_alloc(iss_t *iss, iss_insn_t *insn)
+{
+  return (iss_insn_cold_t *)calloc(1, sizeof(iss_insn_cold_t));
+}
+
 iss_insn_t *insn_cache_get_decoded(iss_t *iss, iss_addr_t pc)
 {
   iss_insn_t *insn = insn_cache_get(iss, pc);
   if (insn->handler != iss_decode_pc) return insn;
   return iss_decode_pc_noexec(iss, insn);
 }
+
+
+
+static bool histogram_compare(const iss_insn_count_t &a, const iss_insn_count_t &b)
+{
+  return a.addr < b.addr;
+}
+
+// The histogram file starts with the magic string "ISSHIST1" and three 32
+// bits numbers: the size in bytes of the addresses, the size of the counts
+// and the number of entries. The entries follow, sorted by address, each one
+// being the address of an executed instruction and its execution count.
+// Numbers are stored in the byte order of the host, i.e. little endian.
+int iss_histogram_dump(iss_t *iss, const char *path)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+  std::vector<iss_insn_count_t> counts(cache->flushed_counts, cache->flushed_counts + cache->nb_flushed_counts);
+
+  for (int i=0; i<ISS_INSN_NB_BLOCKS; i++)
+  {
+    for (iss_insn_block_t *b = cache->blocks[i]; b; b = b->next)
+    {
+      for (int j=0; j<ISS_INSN_BLOCK_SIZE; j++)
+      {
+        iss_insn_cold_t *cold = b->insns[j].cold;
+        if (cold && cold->exec_count)
+          counts.push_back({ b->insns[j].addr, cold->exec_count });
+      }
+    }
+  }
+
+  // Instructions executed before and after a flush appear several times
+  std::sort(counts.begin(), counts.end(), histogram_compare);
+  int nb_counts = 0;
+  for (unsigned int i=0; i<counts.size(); i++)
+  {
+    if (nb_counts && counts[nb_counts-1].addr == counts[i].addr)
+      counts[nb_counts-1].count += counts[i].count;
+    else
+      counts[nb_counts++] = counts[i];
+  }
+
+  FILE *file = fopen(path, "wb");
+  if (file == NULL)
+    return -1;
+
+  uint32_t header[3] = { sizeof(iss_addr_t), sizeof(uint64_t), (uint32_t)nb_counts };
+  bool error = fwrite("ISSHIST1", 1, 8, file) != 8 || fwrite(header, sizeof(header), 1, file) != 1;
+
+  for (int i=0; i<nb_counts && !error; i++)
+  {
+    error = fwrite(&counts[i].addr, sizeof(iss_addr_t), 1, file) != 1 ||
+      fwrite(&counts[i].count, sizeof(uint64_t), 1, file) != 1;
+  }
+
+  return fclose(file) != 0 || error ? -1 : 0;
+}
@@ -131,6 +131,8 @@ static int iss_parse_isa(iss_t *iss)
     }
   }
 
+  iss->cpu.insn_cache.pc_bits = has_c ? 1 : 2;
+
   //
   // Activate inter-dependent ISA extension subsets
   //
@@ -261,7 +263,10 @@ void iss_reset(iss_t *iss)
   iss_cache_flush(iss);
   
   iss->cpu.prev_insn = NULL;
-  iss->cpu.state.hw_counter_en = 0;
+  iss->cpu.state.nb_insns = 0;
+  iss->cpu.state.nb_cycles = 0;
+  iss->cpu.state.pccr_nb_insns = 0;
+  iss->cpu.state.pccr_nb_cycles = 0;
   iss->cpu.state.elw_insn = NULL;
 
   iss_irq_init(iss);
@@ -278,6 +283,12 @@ int iss_open(iss_t *iss)
   insn_cache_init(iss);
   prefetcher_init(iss);
 
+  iss->cpu.jit.code = NULL;
+  if (iss->cpu.jit.enabled && iss_jit_init(iss))
+  {
+    iss->cpu.jit.enabled = false;
+  }
+
   iss->cpu.regfile.regs[0] = 0;
   iss->cpu.current_insn = NULL;
 
@@ -0,0 +1,592 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+/*
+ * Translation of hot blocks into host code.
+ *
+ * A block is the chain of decoded instructions following the next pointers
+ * from a hot block head, so it goes through not-taken branches and direct
+ * jumps. Simple integer instructions are translated into host instructions
+ * working directly on the register file, while all other ones are executed
+ * by calling their handler, which keeps the exact same behavior for memory
+ * accesses, CSRs and exceptions.
+ *
+ * Timing is kept identical to the interpreter. Before executing a group of
+ * translated instructions, the clock engine is advanced to the cycle of the
+ * last one, which is only possible if nothing else happens in between. The
+ * block returns to the interpreter as soon as the engine can not advance,
+ * an instruction does not continue with its next one, or the core leaves
+ * the fast execution mode. Each translated instruction also checks that its
+ * fast handler is still the one it was translated from, so that stalls,
+ * hardware loops and traces installed later on fall back to the handler.
+ *
+ * The returned value is the number of cycles of the last executed
+ * instruction, exactly as for iss_exec_step_nofetch, and the running totals
+ * of instructions and cycles are updated the same way, so that the
+ * performance counters computed from them stay exact.
+ */
+
+#include "iss.hpp"
+#include <string.h>
+
+#if defined(__x86_64__) && !defined(ISS_WORD_64)
+
+#include <sys/mman.h>
+
+typedef enum {
+  JIT_OP_NONE,
+  JIT_OP_NOP,
+  JIT_OP_RR,
+  JIT_OP_RR_SHIFT,
+  JIT_OP_RR_SET,
+  JIT_OP_RI,
+  JIT_OP_RI_SHIFT,
+  JIT_OP_RI_SET,
+  JIT_OP_LI,
+} jit_op_e;
+
+typedef struct {
+  const char *label;
+  jit_op_e op;
+  uint8_t opcode;
+} jit_insn_desc_t;
+
+// Instructions which are translated inline. The opcode is the x86 ALU
+// opcode for register operands, the immediate form for immediates, the
+// /reg extension for shifts and the setcc condition for comparisons.
+static jit_insn_desc_t jit_insns[] = {
+  { "nop",        JIT_OP_NOP,      0    },
+  { "c.nop",      JIT_OP_NOP,      0    },
+  { "add",        JIT_OP_RR,       0x03 },
+  { "c.add",      JIT_OP_RR,       0x03 },
+  { "c.mv",       JIT_OP_RR,       0x03 },
+  { "sub",        JIT_OP_RR,       0x2B },
+  { "c.sub",      JIT_OP_RR,       0x2B },
+  { "xor",        JIT_OP_RR,       0x33 },
+  { "c.xor",      JIT_OP_RR,       0x33 },
+  { "or",         JIT_OP_RR,       0x0B },
+  { "c.or",       JIT_OP_RR,       0x0B },
+  { "and",        JIT_OP_RR,       0x23 },
+  { "c.and",      JIT_OP_RR,       0x23 },
+  { "sll",        JIT_OP_RR_SHIFT, 0xE0 },
+  { "srl",        JIT_OP_RR_SHIFT, 0xE8 },
+  { "sra",        JIT_OP_RR_SHIFT, 0xF8 },
+  { "slt",        JIT_OP_RR_SET,   0x9C },
+  { "sltu",       JIT_OP_RR_SET,   0x92 },
+  { "addi",       JIT_OP_RI,       0x05 },
+  { "c.addi",     JIT_OP_RI,       0x05 },
+  { "c.li",       JIT_OP_RI,       0x05 },
+  { "c.addi16sp", JIT_OP_RI,       0x05 },
+  { "c.addi4spn", JIT_OP_RI,       0x05 },
+  { "xori",       JIT_OP_RI,       0x35 },
+  { "ori",        JIT_OP_RI,       0x0D },
+  { "andi",       JIT_OP_RI,       0x25 },
+  { "c.andi",     JIT_OP_RI,       0x25 },
+  { "slli",       JIT_OP_RI_SHIFT, 0xE0 },
+  { "c.slli",     JIT_OP_RI_SHIFT, 0xE0 },
+  { "srli",       JIT_OP_RI_SHIFT, 0xE8 },
+  { "c.srli",     JIT_OP_RI_SHIFT, 0xE8 },
+  { "srai",       JIT_OP_RI_SHIFT, 0xF8 },
+  { "c.srai",     JIT_OP_RI_SHIFT, 0xF8 },
+  { "slti",       JIT_OP_RI_SET,   0x9C },
+  { "sltiu",      JIT_OP_RI_SET,   0x92 },
+  { "lui",        JIT_OP_LI,       0    },
+  { "c.lui",      JIT_OP_LI,       0    },
+  { "auipc",      JIT_OP_LI,       0    },
+  { NULL,         JIT_OP_NONE,     0    },
+};
+
+// Maximum size of the host code generated for one instruction, including
+// its exit stub
+#define JIT_MAX_INSN_CODE 192
+
+typedef struct {
+  iss_insn_t *head;
+  uint8_t *code;
+  uint8_t *current;
+  int nb_exits;
+  struct {
+    uint8_t *patch;
+    iss_insn_t *insn;
+    bool none;
+    bool helper;
+    bool invalidate;
+  } exits[ISS_JIT_MAX_INSNS * 2];
+} jit_emitter_t;
+
+
+
+static bool jit_advance(iss_t *iss, int64_t cycles)
+{
+  return cycles == 0 || iss_exec_advance(iss, cycles);
+}
+
+// Executes an instruction which is not translated. Returns its number of
+// cycles if the block can continue with the specified instruction, or -1 if
+// the block must exit, in which case the value to be returned by the block
+// is stored in the JIT state.
+static int jit_exec_insn(iss_t *iss, iss_insn_t *insn, int64_t pending, iss_insn_t *next)
+{
+  if (pending && !iss_exec_advance(iss, pending))
+  {
+    iss->cpu.jit.exit_cycles = pending;
+    return -1;
+  }
+
+  int cycles = iss_exec_step_nofetch(iss);
+
+  // The successor is the one seen during the translation, as the instruction
+  // may have been invalidated and decoded again
+  if (cycles < 0 || iss->cpu.current_insn != next || !iss_exec_can_continue(iss))
+  {
+    iss->cpu.jit.exit_cycles = cycles;
+    return -1;
+  }
+
+  return cycles;
+}
+
+
+
+static inline void emit8(jit_emitter_t *e, uint8_t value)
+{
+  *e->current++ = value;
+}
+
+static inline void emit32(jit_emitter_t *e, uint32_t value)
+{
+  memcpy(e->current, &value, 4);
+  e->current += 4;
+}
+
+static inline void emit64(jit_emitter_t *e, uint64_t value)
+{
+  memcpy(e->current, &value, 8);
+  e->current += 8;
+}
+
+static inline void emit_bytes(jit_emitter_t *e, int nb, const uint8_t *bytes)
+{
+  memcpy(e->current, bytes, nb);
+  e->current += nb;
+}
+
+// movabs reg, imm64 with reg being rax (0), rcx (1), rdx (2) or rsi (6)
+static inline void emit_mov_imm64(jit_emitter_t *e, int reg, uint64_t value)
+{
+  emit8(e, 0x48);
+  emit8(e, 0xB8 + reg);
+  emit64(e, value);
+}
+
+// <opcode> reg, [r13 + disp32] with reg being eax (0) or ecx (1)
+static inline void emit_regfile_op(jit_emitter_t *e, uint8_t opcode, int reg, int index)
+{
+  emit8(e, 0x41);
+  emit8(e, opcode);
+  emit8(e, 0x85 | (reg << 3));
+  emit32(e, index * sizeof(iss_reg_t));
+}
+
+// Conditional jump to an exit stub, patched once the stubs are emitted
+static inline void emit_exit_jcc(jit_emitter_t *e, uint8_t cond, iss_insn_t *insn, bool none, bool helper, bool invalidate)
+{
+  emit8(e, 0x0F);
+  emit8(e, cond);
+  e->exits[e->nb_exits].patch = e->current;
+  e->exits[e->nb_exits].insn = insn;
+  e->exits[e->nb_exits].none = none;
+  e->exits[e->nb_exits].helper = helper;
+  e->exits[e->nb_exits].invalidate = invalidate;
+  e->nb_exits++;
+  emit32(e, 0);
+}
+
+static inline void emit_call(jit_emitter_t *e, void *func)
+{
+  emit_mov_imm64(e, 0, (uint64_t)func);
+  emit8(e, 0xFF); emit8(e, 0xD0);     // call rax
+}
+
+static inline void emit_set_current_insn(iss_t *iss, jit_emitter_t *e, iss_insn_t *insn)
+{
+  emit_mov_imm64(e, 0, (uint64_t)insn);
+  emit_mov_imm64(e, 1, (uint64_t)&iss->cpu.current_insn);
+  emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0x01);   // mov [rcx], rax
+}
+
+
+
+static jit_insn_desc_t *jit_get_desc(iss_insn_t *insn)
+{
+  if (insn->fast_handler == iss_decode_pc || insn->decoded == NULL)
+    return NULL;
+
+  // Instructions whose handler was replaced (stalls, hardware loops, traces)
+  // must go through their handler
+  if (insn->fast_handler != insn->decoded->decoder_item->u.insn.fast_handler || (insn->cold && insn->cold->hwloop_handler))
+    return NULL;
+
+  const char *label = insn->decoded->decoder_item->u.insn.label;
+  for (jit_insn_desc_t *desc = jit_insns; desc->label; desc++)
+  {
+    if (strcmp(desc->label, label) == 0)
+    {
+      if (desc->op == JIT_OP_NOP || desc->op == JIT_OP_LI)
+        return desc;
+
+      if (insn->out_regs[0] < 0 || insn->out_regs[0] >= ISS_NB_REGS ||
+        insn->in_regs[0] < 0 || insn->in_regs[0] >= ISS_NB_REGS)
+        return NULL;
+
+      if ((desc->op == JIT_OP_RR || desc->op == JIT_OP_RR_SHIFT || desc->op == JIT_OP_RR_SET) &&
+        (insn->in_regs[1] < 0 || insn->in_regs[1] >= ISS_NB_REGS))
+        return NULL;
+
+      if (desc->op == JIT_OP_RI_SHIFT && insn->uim[0] >= 32)
+        return NULL;
+
+      return desc;
+    }
+  }
+
+  return NULL;
+}
+
+static void jit_emit_insn(jit_emitter_t *e, iss_insn_t *insn, jit_insn_desc_t *desc)
+{
+  int rd = insn->out_regs[0];
+
+  // Writes to x0 are dropped by the handlers
+  if (desc->op == JIT_OP_NOP || rd == 0)
+    return;
+
+  switch (desc->op)
+  {
+    case JIT_OP_RR:
+      emit_regfile_op(e, 0x8B, 0, insn->in_regs[0]);
+      emit_regfile_op(e, desc->opcode, 0, insn->in_regs[1]);
+      break;
+
+    case JIT_OP_RR_SHIFT:
+      emit_regfile_op(e, 0x8B, 0, insn->in_regs[0]);
+      emit_regfile_op(e, 0x8B, 1, insn->in_regs[1]);
+      emit8(e, 0xD3); emit8(e, desc->opcode);             // shift eax, cl
+      break;
+
+    case JIT_OP_RR_SET:
+      emit_regfile_op(e, 0x8B, 0, insn->in_regs[0]);
+      emit_regfile_op(e, 0x3B, 0, insn->in_regs[1]);      // cmp eax, [reg]
+      emit8(e, 0x0F); emit8(e, desc->opcode); emit8(e, 0xC0);   // setcc al
+      emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0xC0);     // movzx eax, al
+      break;
+
+    case JIT_OP_RI:
+      emit_regfile_op(e, 0x8B, 0, insn->in_regs[0]);
+      emit8(e, desc->opcode); emit32(e, insn->sim[0]);
+      break;
+
+    case JIT_OP_RI_SHIFT:
+      emit_regfile_op(e, 0x8B, 0, insn->in_regs[0]);
+      emit8(e, 0xC1); emit8(e, desc->opcode); emit8(e, insn->uim[0]);
+      break;
+
+    case JIT_OP_RI_SET:
+      emit_regfile_op(e, 0x8B, 0, insn->in_regs[0]);
+      emit8(e, 0x3D); emit32(e, insn->sim[0]);           // cmp eax, imm32
+      emit8(e, 0x0F); emit8(e, desc->opcode); emit8(e, 0xC0);
+      emit8(e, 0x0F); emit8(e, 0xB6); emit8(e, 0xC0);
+      break;
+
+    case JIT_OP_LI:
+      emit8(e, 0x41); emit8(e, 0xC7); emit8(e, 0x85);     // mov dword [r13 + disp32], imm32
+      emit32(e, rd * sizeof(iss_reg_t));
+      emit32(e, insn->uim[0]);
+      return;
+
+    default:
+      return;
+  }
+
+  emit_regfile_op(e, 0x89, 0, rd);                        // mov [r13 + disp32], eax
+}
+
+// Emits a group of instructions translated inline. They are all executed
+// after advancing the clock engine to the cycle of the last one.
+static void jit_emit_run(iss_t *iss, jit_emitter_t *e, iss_insn_t **insns, jit_insn_desc_t **descs, int nb_insns, bool first)
+{
+  iss_insn_t *head = insns[0];
+
+  // Check first that no handler was replaced since the translation, as the
+  // time is advanced for the whole group
+  for (int i=0; i<nb_insns; i++)
+  {
+    emit_mov_imm64(e, 0, (uint64_t)&insns[i]->fast_handler);
+    emit8(e, 0x48); emit8(e, 0x8B); emit8(e, 0x00);       // mov rax, [rax]
+    emit_mov_imm64(e, 1, (uint64_t)insns[i]->fast_handler);
+    emit8(e, 0x48); emit8(e, 0x39); emit8(e, 0xC8);       // cmp rax, rcx
+    emit_exit_jcc(e, 0x85, head, first, false, true);     // jne exit
+  }
+
+  // The first group of the block is executed at the current cycle, while
+  // the next ones must wait for the cycles of the previous instruction
+  if (!first || nb_insns > 1)
+  {
+    emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0xDF);       // mov rdi, rbx
+    emit8(e, 0x49); emit8(e, 0x8D); emit8(e, 0xB4); emit8(e, 0x24);  // lea rsi, [r12 + disp32]
+    emit32(e, nb_insns - 1);
+    emit_call(e, (void *)jit_advance);
+    emit8(e, 0x84); emit8(e, 0xC0);                       // test al, al
+    emit_exit_jcc(e, 0x84, head, first, false, false);    // jz exit
+  }
+
+  // Update the running totals of the interpreter for the whole group, each
+  // inline instruction takes one cycle
+  emit_mov_imm64(e, 0, (uint64_t)&iss->cpu.state.nb_insns);
+  emit8(e, 0x48); emit8(e, 0x83); emit8(e, 0x00); emit8(e, nb_insns);  // add qword [rax], imm8
+  emit_mov_imm64(e, 0, (uint64_t)&iss->cpu.state.nb_cycles);
+  emit8(e, 0x48); emit8(e, 0x83); emit8(e, 0x00); emit8(e, nb_insns);  // add qword [rax], imm8
+
+  for (int i=0; i<nb_insns; i++)
+  {
+    jit_emit_insn(e, insns[i], descs[i]);
+  }
+
+  emit8(e, 0x41); emit8(e, 0xBC); emit32(e, 1);           // mov r12d, 1
+}
+
+static void jit_emit_helper(iss_t *iss, jit_emitter_t *e, iss_insn_t *insn)
+{
+  emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0xDF);         // mov rdi, rbx
+  emit_mov_imm64(e, 6, (uint64_t)insn);                   // movabs rsi, insn
+  emit8(e, 0x4C); emit8(e, 0x89); emit8(e, 0xE2);         // mov rdx, r12
+  emit_set_current_insn(iss, e, insn);
+  emit_mov_imm64(e, 1, (uint64_t)insn->next);             // movabs rcx, next
+  emit_call(e, (void *)jit_exec_insn);
+  emit8(e, 0x85); emit8(e, 0xC0);                         // test eax, eax
+  emit_exit_jcc(e, 0x88, insn, false, true, false);       // js exit
+  emit8(e, 0x41); emit8(e, 0x89); emit8(e, 0xC4);         // mov r12d, eax
+}
+
+static void jit_emit_epilogue(jit_emitter_t *e)
+{
+  static const uint8_t epilogue[] = {
+    0x41, 0x5D,         // pop r13
+    0x41, 0x5C,         // pop r12
+    0x5B,               // pop rbx
+    0xC3                // ret
+  };
+  emit_bytes(e, sizeof(epilogue), epilogue);
+}
+
+
+
+static void jit_reset(iss_t *iss)
+{
+  iss_insn_cache_t *cache = &iss->cpu.insn_cache;
+
+  for (int i=0; i<ISS_INSN_NB_BLOCKS; i++)
+  {
+    for (iss_insn_block_t *b = cache->blocks[i]; b; b = b->next)
+    {
+      for (int j=0; j<ISS_INSN_BLOCK_SIZE; j++)
+      {
+        b->insns[j].jit_block = NULL;
+      }
+    }
+  }
+
+  iss->cpu.jit.code_pos = 0;
+}
+
+void iss_jit_invalidate(iss_t *iss)
+{
+  if (iss->cpu.jit.code)
+  {
+    jit_reset(iss);
+  }
+}
+
+void iss_jit_translate(iss_t *iss, iss_insn_t *head)
+{
+  iss_jit_t *jit = &iss->cpu.jit;
+  iss_insn_t *insns[ISS_JIT_MAX_INSNS];
+  jit_insn_desc_t *descs[ISS_JIT_MAX_INSNS];
+  int nb_insns = 0;
+  int nb_inline = 0;
+
+  if (head->jit_block)
+    return;
+
+  iss_insn_t *insn = head;
+  while (nb_insns < ISS_JIT_MAX_INSNS && insn && insn->fast_handler != iss_decode_pc &&
+    (nb_insns == 0 || insn != head))
+  {
+    descs[nb_insns] = jit_get_desc(insn);
+    if (descs[nb_insns]) nb_inline++;
+    insns[nb_insns++] = insn;
+    insn = insn->next;
+  }
+
+  // Blocks without any inline instruction would just call the handlers
+  if (nb_inline == 0)
+    return;
+
+  int max_size = 128 + nb_insns * JIT_MAX_INSN_CODE;
+  if (jit->code_pos + max_size > jit->code_size)
+  {
+    jit_reset(iss);
+  }
+
+  jit_emitter_t emitter;
+  jit_emitter_t *e = &emitter;
+  e->head = head;
+  e->code = jit->code + jit->code_pos;
+  e->current = e->code;
+  e->nb_exits = 0;
+
+  static const uint8_t prologue[] = {
+    0x53,               // push rbx
+    0x41, 0x54,         // push r12
+    0x41, 0x55,         // push r13
+    0x48, 0x89, 0xFB,   // mov rbx, rdi
+    0x45, 0x31, 0xE4,   // xor r12d, r12d
+  };
+  emit_bytes(e, sizeof(prologue), prologue);
+  emit8(e, 0x49); emit8(e, 0xBD);                         // movabs r13, regfile
+  emit64(e, (uint64_t)&iss->cpu.regfile.regs[0]);
+
+  int index = 0;
+  while (index < nb_insns)
+  {
+    if (descs[index])
+    {
+      int nb_run = 1;
+      while (index + nb_run < nb_insns && descs[index + nb_run] && nb_run < ISS_JIT_MAX_RUN)
+        nb_run++;
+
+      jit_emit_run(iss, e, &insns[index], &descs[index], nb_run, index == 0);
+      index += nb_run;
+    }
+    else
+    {
+      jit_emit_helper(iss, e, insns[index]);
+      index++;
+    }
+  }
+
+  // End of block, update the current instruction if the last one was
+  // executed inline, helpers already did it
+  iss_insn_t *last = insns[nb_insns - 1];
+  if (descs[nb_insns - 1])
+  {
+    emit_set_current_insn(iss, e, last->next);
+    emit_mov_imm64(e, 0, (uint64_t)last);
+    emit_mov_imm64(e, 1, (uint64_t)&iss->cpu.prev_insn);
+    emit8(e, 0x48); emit8(e, 0x89); emit8(e, 0x01);       // mov [rcx], rax
+  }
+  emit8(e, 0x44); emit8(e, 0x89); emit8(e, 0xE0);         // mov eax, r12d
+  jit_emit_epilogue(e);
+
+  // Exit stubs
+  for (int i=0; i<e->nb_exits; i++)
+  {
+    uint8_t *stub = e->current;
+    int32_t offset = stub - (e->exits[i].patch + 4);
+    memcpy(e->exits[i].patch, &offset, 4);
+
+    if (e->exits[i].helper)
+    {
+      emit_mov_imm64(e, 0, (uint64_t)&jit->exit_cycles);
+      emit8(e, 0x8B); emit8(e, 0x00);                     // mov eax, [rax]
+    }
+    else
+    {
+      // A handler was replaced after the translation, drop the block so
+      // that it is translated again with the new handlers
+      if (e->exits[i].invalidate)
+      {
+        emit_mov_imm64(e, 0, (uint64_t)&e->head->jit_block);
+        emit8(e, 0x48); emit8(e, 0xC7); emit8(e, 0x00); emit32(e, 0);  // mov qword [rax], 0
+      }
+      emit_set_current_insn(iss, e, e->exits[i].insn);
+      if (e->exits[i].none)
+      {
+        emit8(e, 0xB8); emit32(e, ISS_JIT_NONE);          // mov eax, ISS_JIT_NONE
+      }
+      else
+      {
+        emit8(e, 0x44); emit8(e, 0x89); emit8(e, 0xE0);   // mov eax, r12d
+      }
+    }
+    jit_emit_epilogue(e);
+  }
+
+  jit->code_pos += e->current - e->code;
+  head->jit_block = (int (*)(iss_t *))e->code;
+}
+
+int iss_jit_init(iss_t *iss)
+{
+  iss_jit_t *jit = &iss->cpu.jit;
+
+  jit->code_size = ISS_JIT_CODE_SIZE;
+  jit->code_pos = 0;
+  jit->code = (uint8_t *)mmap(NULL, jit->code_size, PROT_READ | PROT_WRITE | PROT_EXEC,
+    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (jit->code == MAP_FAILED)
+  {
+    jit->code = NULL;
+    iss_warning(iss, "Could not allocate JIT code buffer, JIT is disabled\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+void iss_jit_flush(iss_t *iss)
+{
+  // Translated blocks are attached to the instructions, which are freed
+  // by the flush, so only the code buffer must be reset
+  iss->cpu.jit.code_pos = 0;
+}
+
+#else
+
+int iss_jit_init(iss_t *iss)
+{
+  iss_warning(iss, "JIT is not supported on this host, JIT is disabled\n");
+  return -1;
+}
+
+void iss_jit_flush(iss_t *iss)
+{
+}
+
+void iss_jit_invalidate(iss_t *iss)
+{
+}
+
+void iss_jit_translate(iss_t *iss, iss_insn_t *insn)
+{
+}
+
+#endif
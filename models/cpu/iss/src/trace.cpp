@@ -20,97 +20,9 @@
 
 #include "iss.hpp"
 #include <string.h>
-#include <algorithm>
-
-#define PC_INFO_ARRAY_SIZE (64*1024)
 
 #define MAX_DEBUG_INFO_WIDTH 32
 
-class iss_pc_info {
-public:
-  unsigned int base;
-  char *func;
-  char *inline_func;
-  char *file;
-  int line;
-  iss_pc_info *next;
-};
-
-static bool pc_infos_is_init = false;
-static iss_pc_info *pc_infos[PC_INFO_ARRAY_SIZE];
-static std::vector<std::string> binaries;
-
-static void add_pc_info(unsigned int base, char *func, char *inline_func, char *file, int line)
-{
-  iss_pc_info *pc_info = new iss_pc_info();
-
-  int index = base & (PC_INFO_ARRAY_SIZE - 1);
-  pc_info->next = pc_infos[index];
-  pc_infos[index] = pc_info;
-
-  pc_info->base = base;
-  pc_info->func = strdup(func);
-  pc_info->inline_func = strdup(inline_func);
-  pc_info->file = strdup(file);
-  pc_info->line = line;
-}
-
-static iss_pc_info *get_pc_info(unsigned int base)
-{
-  int index = base & (PC_INFO_ARRAY_SIZE - 1);
-
-  iss_pc_info *pc_info = pc_infos[index];
-
-  while (pc_info && pc_info->base != base)
-  {
-    pc_info = pc_info->next;
-  }
-
-  return pc_info;
-}
-
-int iss_trace_pc_info(iss_addr_t addr, const char **func, const char **inline_func, const char **file, int *line)
-{
-  iss_pc_info *info = get_pc_info(addr);
-  if (info == NULL)
-    return -1;
-
-  *func = info->func;
-  *inline_func = info->inline_func;
-  *file = info->file;
-  *line = info->line;
-
-  return 0;
-}
-
-void iss_register_debug_info(iss_t *iss, const char *binary)
-{
-  if (std::find(binaries.begin(), binaries.end(), std::string(binary)) != binaries.end())
-    return;
-
-  binaries.push_back(std::string(binary));
-
-  FILE *file = fopen(binary, "r");
-  if (file != NULL)
-  {
-    char * line = NULL;
-    size_t len = 0;
-    ssize_t read;
-    while ((read = getline(&line, &len, file)) != -1)
-    {
-      char *token = strtok(line, " ");
-      char *tokens[5];
-      int index = 0;
-      while (token)
-      {
-        tokens[index++] = token;
-        token = strtok(NULL, " ");
-      }
-      if (index == 5) add_pc_info(strtol(tokens[0], NULL, 16), tokens[1], tokens[2], tokens[3], atoi(tokens[4]));
-    }
-  }
-}
-
 static inline char iss_trace_get_mode(int mode) {
   switch (mode) {
     case 0: return 'U';
@@ -265,18 +177,11 @@ static char *iss_trace_dump_arg(iss_t *iss, iss_insn_t *insn, char *buff, iss_in
 
 static char *trace_dump_debug(iss_t *iss, iss_insn_t *insn, char *buff)
 {
-  char *name = (char *)"-";
-  char *file = (char *)"-";
-  uint32_t line = 0;
-  char *inline_func = (char *)"-";
-  iss_pc_info *pc_info = get_pc_info(insn->addr);
-  if (pc_info)
-  {
-    name = pc_info->func;
-    file = pc_info->file;
-    line = pc_info->line;
-    inline_func = pc_info->inline_func;
-  }
+  const char *name = "-";
+  const char *file = "-";
+  int line = 0;
+  const char *inline_func = "-";
+  iss_trace_pc_info(insn->addr, &name, &inline_func, &file, &line);
 
   int len = snprintf(buff, MAX_DEBUG_INFO_WIDTH+1, "%s:%d", inline_func, line) - 1;
 
@@ -300,7 +205,7 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
   int len;
 
   if (is_long) {
-    if (binaries.size())
+    if (iss_has_debug_info())
       buff = trace_dump_debug(iss, insn, buff);
   }
 
@@ -310,7 +215,7 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
 
   char *start_buff = buff;
 
-  buff += sprintf(buff,  "%s ", insn->decoder_item->u.insn.label);
+  buff += sprintf(buff,  "%s ", insn->decoded->decoder_item->u.insn.label);
 
   if (is_long) {
     len = buff - start_buff;
@@ -325,9 +230,9 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
 
   iss_decoder_arg_t *prev_arg = NULL;
   start_buff = buff;
-  int nb_args = insn->decoder_item->u.insn.nb_args;
+  int nb_args = insn->decoded->decoder_item->u.insn.nb_args;
   for (int i=0; i<nb_args; i++) {
-    buff = iss_trace_dump_arg(iss, insn, buff, &insn->args[i], &insn->decoder_item->u.insn.args[i], &prev_arg, is_long);
+    buff = iss_trace_dump_arg(iss, insn, buff, &insn->decoded->args[i], &insn->decoded->decoder_item->u.insn.args[i], &prev_arg, is_long);
   }
   if (nb_args != 0) buff += sprintf(buff,  " ");
 
@@ -346,10 +251,10 @@ static void iss_trace_dump_insn(iss_t *iss, iss_insn_t *insn, char *buff, int bu
   {
     prev_arg = NULL;
     for (int i=0; i<nb_args; i++) {
-      buff = iss_trace_dump_arg_value(iss, insn, buff, &insn->args[i], &insn->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 1, is_long);
+      buff = iss_trace_dump_arg_value(iss, insn, buff, &insn->decoded->args[i], &insn->decoded->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 1, is_long);
     }
     for (int i=0; i<nb_args; i++) {
-      buff = iss_trace_dump_arg_value(iss, insn, buff, &insn->args[i], &insn->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 0, is_long);
+      buff = iss_trace_dump_arg_value(iss, insn, buff, &insn->decoded->args[i], &insn->decoded->decoder_item->u.insn.args[i], &saved_args[i], &prev_arg, 0, is_long);
     }
 
     buff += sprintf(buff,  "\n");
@@ -391,9 +296,9 @@ static void iss_trace_save_arg(iss_t *iss, iss_insn_t *insn, iss_insn_arg_t *ins
 
 static void iss_trace_save_args(iss_t *iss, iss_insn_t *insn, iss_insn_arg_t saved_args[], bool save_out)
 {
-  for (int i=0; i<insn->decoder_item->u.insn.nb_args; i++) {
-    iss_decoder_arg_t *arg = &insn->decoder_item->u.insn.args[i];
-    iss_trace_save_arg(iss, insn, &insn->args[i], arg, &saved_args[i], save_out);
+  for (int i=0; i<insn->decoded->decoder_item->u.insn.nb_args; i++) {
+    iss_decoder_arg_t *arg = &insn->decoded->decoder_item->u.insn.args[i];
+    iss_trace_save_arg(iss, insn, &insn->decoded->args[i], arg, &saved_args[i], save_out);
   }
 }
 
@@ -439,14 +344,14 @@ iss_insn_t *iss_exec_insn_with_trace(iss_t *iss, iss_insn_t *insn)
   {
     iss_trace_save_args(iss, insn, iss->cpu.state.saved_args, false);
     
-    next_insn = iss_exec_insn_handler(iss, insn, insn->saved_handler);
+    next_insn = iss_exec_insn_handler(iss, insn, insn->cold->saved_handler);
 
     if (!iss_exec_is_stalled(iss))
       iss_trace_dump(iss, insn);
   }
   else
   {
-    next_insn = iss_exec_insn_handler(iss, insn, insn->saved_handler);
+    next_insn = iss_exec_insn_handler(iss, insn, insn->cold->saved_handler);
   }
 
 
@@ -455,9 +360,4 @@ iss_insn_t *iss_exec_insn_with_trace(iss_t *iss, iss_insn_t *insn)
 
 void iss_trace_init(iss_t *iss)
 {
-  if (!pc_infos_is_init)
-  {
-    pc_infos_is_init = true;
-    memset(pc_infos, 0, sizeof(pc_infos));
-  }
 }
\ No newline at end of file
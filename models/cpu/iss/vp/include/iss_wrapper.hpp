@@ -24,13 +24,62 @@
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include <vp/itf/wire.hpp>
+#include <vp/gdbserver/gdbserver_engine.hpp>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Default maximum number of instructions executed by a single clock event
+#define ISS_INSN_BATCH_SIZE 64
+
+// Number of pages, and their size, for which the refused direct accesses are
+// remembered on each port
+#define ISS_DMI_REFUSED_SIZE 16
+#define ISS_DMI_REFUSED_PAGE_BITS 12
+
+// Phases of sampled simulation, see iss_wrapper::sampling_update
+typedef enum {
+  ISS_SAMPLING_FUNCTIONAL,   // Fast-forward, instruction and memory timings are ignored
+  ISS_SAMPLING_WARMUP,       // Detailed timing, not measured
+  ISS_SAMPLING_DETAILED      // Detailed timing, measured
+} iss_sampling_phase_e;
+
+// Maximum depth of the call stack followed by the profiler, deeper calls
+// replace the innermost function
+#define ISS_PROFILER_MAX_DEPTH 256
+
+// Node of the call tree built by the profiler, i.e. a function called
+// through a given stack of functions
+struct iss_profiler_node
+{
+  iss_profiler_node(const char *name, iss_profiler_node *parent) : name(name), parent(parent) {}
+
+  const char *name;
+  iss_profiler_node *parent;
+  std::unordered_map<const char *, iss_profiler_node *> children;
+  iss_addr_t start = 0;   // Address range of the function, empty if it is unknown
+  iss_addr_t end = 0;
+  iss_addr_t last_target = 0;   // Last called address and its node, to skip the lookups for loops of calls
+  iss_profiler_node *last_child = NULL;
+  uint64_t cycles = 0;    // Spent in the function itself, not in its callees
+  uint64_t insns = 0;
+  uint64_t calls = 0;
+};
+
+typedef struct {
+  const char *name;
+  iss_addr_t start;
+  iss_addr_t end;
+} iss_profiler_func_t;
+
 
 #ifdef USE_TRDB
 #define HAVE_DECL_BASENAME 1
 #include "trace_debugger.h"
 #endif
 
-class iss_wrapper : public vp::component
+class iss_wrapper : public vp::component, public vp::gdbserver_core
 {
 
 public:
@@ -39,6 +88,7 @@ public:
 
   int build();
   void start();
+  void stop();
   void pre_reset();
   void reset(bool active);
 
@@ -48,10 +98,18 @@ public:
   static void fetch_grant(void *_this, vp::io_req *req);
   static void fetch_response(void *_this, vp::io_req *req);
 
+  static void data_dmi_invalidate(void *_this);
+  static void fetch_dmi_invalidate(void *_this);
+  static void fetch_code_write(void *_this, uint64_t addr, uint64_t size);
+  static vp::io_req_status_e icache_evict_req(void *_this, vp::io_req *req);
+  bool data_dmi_req(iss_addr_t addr, int size);
+  bool fetch_dmi_req(iss_addr_t addr, int size);
+
   static void exec_instr(void *__this, vp::clock_event *event);
   static void exec_first_instr(void *__this, vp::clock_event *event);
   void exec_first_instr(vp::clock_event *event);
   static void exec_instr_check_all(void *__this, vp::clock_event *event);
+  static void exec_instr_functional(void *__this, vp::clock_event *event);
   static inline void exec_misaligned(void *__this, vp::clock_event *event);
 
   static void irq_req_sync(void *__this, int irq);
@@ -71,11 +129,43 @@ public:
   void check_state();
 
   void handle_ebreak();
+  void handle_breakpoint();
+
+  int gdbserver_get_id();
+  std::string gdbserver_get_name();
+  int gdbserver_get_nb_regs();
+  int gdbserver_get_reg_size();
+  int gdbserver_reg_get(int reg, uint8_t *value);
+  int gdbserver_reg_set(int reg, uint8_t *value);
+  int gdbserver_mem_access(uint64_t addr, int size, uint8_t *data, bool is_write);
+  int gdbserver_stop();
+  int gdbserver_cont();
+  int gdbserver_stepi();
+  bool gdbserver_is_halted();
+  int gdbserver_breakpoint_insert(uint64_t addr);
+  int gdbserver_breakpoint_remove(uint64_t addr);
 
   void dump_debug_traces();
 
   inline void trigger_check_all() { current_event = check_all_event; }
 
+  inline bool exec_fast_active();
+
+  inline vp::clock_event *fast_event();
+  void sampling_update();
+  void sampling_report();
+  void functional_report();
+
+  void profiler_jump(iss_insn_t *insn, iss_addr_t target, int rs1);
+  void profiler_account();
+  void profiler_push(iss_addr_t addr, bool is_call);
+  void profiler_return(iss_addr_t target);
+  const char *profiler_func(iss_addr_t addr, iss_addr_t *start, iss_addr_t *end);
+  uint64_t profiler_dump(FILE *file, iss_profiler_node *node, std::string stack);
+  void profiler_report();
+
+  std::string get_output_file(std::string extension);
+
   vp::io_master data;
   vp::io_master fetch;
   vp::io_slave  dbg_unit;
@@ -88,6 +178,76 @@ public:
   vp::io_req     io_req;
   vp::io_req     fetch_req;
 
+  // Instruction cache model. The core accesses it when it executes an
+  // instruction whose line it does not hold, and the cache tells it through
+  // the evict port when a line it holds is evicted.
+  vp::io_master  icache;
+  vp::io_slave   icache_evict_itf;
+  vp::io_req     icache_req;
+
+  // Direct accesses granted on the data and fetch ports, which are used
+  // instead of IO requests when the access falls into them.
+  vp::io_dmi     data_dmi;
+  vp::io_dmi     fetch_dmi;
+  bool           dmi_enabled;
+
+  // Pages for which the direct access was refused, indexed by the low bits
+  // of the page number. They are not asked again until the slave invalidates
+  // its accesses, so that the accesses to peripherals do not go through the
+  // interconnect twice.
+  uint64_t       data_dmi_refused[ISS_DMI_REFUSED_SIZE];
+  uint64_t       fetch_dmi_refused[ISS_DMI_REFUSED_SIZE];
+
+  // Maximum number of instructions executed back to back by one event
+  int            insn_batch_size;
+
+  // Sampled simulation. When enabled, the core repeatedly executes a
+  // functional fast-forward phase, a warmup phase and a measured detailed
+  // window, each one for a fixed number of instructions, and the cycles of
+  // the whole execution are extrapolated from the CPI of the windows.
+  bool           sampling_enabled;
+  iss_sampling_phase_e sampling_phase;
+  uint64_t       sampling_phase_end;         // Instruction count at which the current phase ends
+  uint64_t       sampling_functional_insns;
+  uint64_t       sampling_warmup_insns;
+  uint64_t       sampling_window_insns;
+  uint64_t       sampling_window_start_insns;
+  int64_t        sampling_window_start_cycles;
+  int            sampling_nb_windows;
+  double         sampling_cpi_sum;
+  double         sampling_cpi_sq_sum;
+
+  // Host time at which the core was started, to report the simulation speed
+  // at the end of a run in functional mode
+  double         functional_start_time;
+
+  // Function-level profiler. It follows the call stack from the jumps
+  // which, according to the calling convention, are calls and returns, and
+  // only accounts the cycles and instructions when the stack changes.
+  bool           profiler_enabled;
+  std::string    profiler_folded;            // File where the folded stacks are dumped
+  int            profiler_table_size;        // Number of functions in the table dumped at the end
+  iss_profiler_node profiler_root = iss_profiler_node(NULL, NULL);
+  std::vector<iss_profiler_node *> profiler_stack;
+  int64_t        profiler_cycles;            // Cycles and instructions at the last stack change
+  uint64_t       profiler_insns;
+  std::unordered_set<std::string> profiler_names;
+  std::unordered_map<iss_addr_t, iss_profiler_func_t> profiler_funcs;   // Functions of the call targets
+
+  // File where the execution histogram is dumped at the end of the simulation
+  std::string    histogram_path;
+
+  // GDB server the core is registered to, if any. It drives the core
+  // through the debug unit and accesses the memory with debug requests.
+  vp::gdbserver_engine *gdbserver;
+  vp::io_req     gdbserver_req;
+
+  // True if any trace or event which needs the instruction handlers checking
+  // everything is active. This is recomputed each time one of them is enabled
+  // or disabled, so that the core can run with the fast handlers when tracing
+  // is off, even in builds where traces are compiled in.
+  bool           traces_active;
+
   iss_cpu_t cpu;
 
   vp::trace     trace;
@@ -142,6 +302,7 @@ private:
   vp::clock_event *current_event;
   vp::clock_event *instr_event;
   vp::clock_event *check_all_event;
+  vp::clock_event *functional_event;
   vp::clock_event *misaligned_event;
 
   int irq_req;
@@ -173,8 +334,34 @@ private:
   static void fetchen_sync(void *_this, bool active);
   static void halt_sync(void *_this, bool active);
   inline void enqueue_next_instr(int64_t cycles);
+  inline bool insn_traces_active();
+  bool check_traces_active();
+  void traces_update();
   void halt_core();
+  int dbg_unit_access(uint64_t offset, iss_reg_t *value, bool is_write);
+
+  // Tells if instructions were decoded with the instruction traces
+  bool insn_traces_decoded;
 };
+
+inline bool iss_wrapper::insn_traces_active()
+{
+  return this->trace.get_active() || this->pc_trace_event.get_event_active() ||
+    this->func_trace_event.get_event_active() || this->inline_trace_event.get_event_active() ||
+    this->file_trace_event.get_event_active() || this->line_trace_event.get_event_active() ||
+    this->ipc_stat_event.get_event_active() || this->power_trace.get_active();
+}
+inline bool iss_wrapper::exec_fast_active()
+{
+  return (current_event == instr_event || current_event == functional_event) && is_active_reg.get();
+}
+
+// Event executing instructions when nothing special needs to be checked,
+// which depends on the sampling phase.
+inline vp::clock_event *iss_wrapper::fast_event()
+{
+  return this->sampling_phase == ISS_SAMPLING_FUNCTIONAL ? this->functional_event : this->instr_event;
+}
 \
 inline void iss_wrapper::enqueue_next_instr(int64_t cycles)
 {
@@ -212,6 +399,24 @@ void iss_wrapper::exec_misaligned(void *__this, vp::clock_event *event)
 inline int iss_wrapper::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, int size, bool is_write)
 {
   decode_trace.msg("Data request (addr: 0x%lx, size: 0x%x, is_write: %d)\n", addr, size, is_write);
+
+  if (likely(this->data_dmi.contains(addr, size)) || this->data_dmi_req(addr, size))
+  {
+    if (is_write)
+    {
+      memcpy(this->data_dmi.get_ptr(addr), data_ptr, size);
+      this->data_dmi.write_notify(addr, size);
+    }
+    else
+      memcpy(data_ptr, this->data_dmi.get_ptr(addr), size);
+
+    // The latency is also reported through the request as it is read back
+    // for misaligned accesses.
+    this->io_req.set_latency(this->data_dmi.latency);
+    this->cpu.state.insn_cycles += this->data_dmi.latency;
+    return vp::IO_REQ_OK;
+  }
+
   vp::io_req *req = &io_req;
   req->init();
   req->set_addr(addr);
@@ -221,6 +426,10 @@ inline int iss_wrapper::data_req_aligned(iss_addr_t addr, uint8_t *data_ptr, int
   int err = data.req(req);
   if (err == vp::IO_REQ_OK) 
   {
+    // Latencies are not modeled in functional mode, the ones which may still
+    // be reported are dropped so that misaligned accesses ignore them too
+    if (unlikely(this->get_functional()))
+      req->set_latency(0);
     this->cpu.state.insn_cycles += req->get_latency();
   }
   else if (err == vp::IO_REQ_INVALID) 
@@ -25,9 +25,9 @@
 #include "iss_wrapper.hpp"
 #include <string.h>
 
-static inline void iss_handle_ecall(iss_t *iss, iss_insn_t *insn)
+static inline bool iss_handle_ecall(iss_t *iss, iss_insn_t *insn)
 {
-
+  return false;
 }
 
 static inline void iss_handle_ebreak(iss_t *iss, iss_insn_t *insn)
@@ -35,6 +35,11 @@ static inline void iss_handle_ebreak(iss_t *iss, iss_insn_t *insn)
   iss->handle_ebreak();
 }
 
+static inline void iss_handle_breakpoint(iss_t *iss, iss_insn_t *insn)
+{
+  iss->handle_breakpoint();
+}
+
 static inline void iss_pccr_incr(iss_t *iss, unsigned int event, int incr)
 {
   static uint64_t zero = 0;
@@ -81,6 +86,41 @@ static inline bool iss_insn_trace_active(iss_t *iss)
   return iss->insn_trace.get_active();
 }
 
+static inline bool iss_traces_active(iss_t *iss)
+{
+  return iss->traces_active;
+}
+
+// Tells if the platform is simulated in functional mode, where the
+// instruction latencies are not modeled
+static inline bool iss_functional_mode(iss_t *iss)
+{
+  return iss->get_functional();
+}
+
+// Called on jumps so that the profiler can follow calls and returns. The
+// source register is -1 for direct jumps.
+static inline void iss_profiler_jump(iss_t *iss, iss_insn_t *insn, iss_addr_t target, int rs1)
+{
+  if (unlikely(iss->profiler_enabled))
+  {
+    iss->profiler_jump(insn, target, rs1);
+  }
+}
+
+// Advance the time to the next instruction, returns false if something else
+// must be executed before it
+static inline bool iss_exec_advance(iss_t *iss, int64_t cycles)
+{
+  return iss->get_clock()->try_advance(cycles);
+}
+
+// Tell if the core can keep executing instructions with the fast handler
+static inline bool iss_exec_can_continue(iss_t *iss)
+{
+  return iss->exec_fast_active();
+}
+
 static bool iss_csr_ext_counter_is_bound(iss_t *iss, int id)
 {
   return iss->ext_counter[id].is_bound();
@@ -141,8 +181,20 @@ static inline int iss_io_req(iss_t *_this, uint64_t addr, uint8_t *data, uint64_
   return _this->data.req(&_this->io_req);
 }
 
+static inline void iss_fetch_watch(iss_t *_this, uint64_t addr)
+{
+  if (_this->fetch_dmi.contains(addr, 2))
+    _this->fetch_dmi.watch(addr);
+}
+
 static inline int iss_fetch_req(iss_t *_this, uint64_t addr, uint8_t *data, uint64_t size, bool is_write)
 {
+  if (likely(_this->fetch_dmi.contains(addr, size)) || _this->fetch_dmi_req(addr, size))
+  {
+    memcpy(data, _this->fetch_dmi.get_ptr(addr), size);
+    return 0;
+  }
+
   vp::io_req *req = &_this->fetch_req;
   req->init();
   req->set_addr(addr);
@@ -161,6 +213,37 @@ static inline int iss_fetch_req(iss_t *_this, uint64_t addr, uint8_t *data, uint
   return 0;
 }
 
+// Access the instruction cache for the line of the instruction. A miss
+// stalls the core for the refill latency. The cache reports through the
+// actual size of the request whether the core now holds the line, which is
+// returned so that the instruction is then executed without accessing the
+// cache until the line is evicted.
+static inline bool iss_icache_fetch(iss_t *iss, iss_insn_t *insn)
+{
+  vp::io_req *req = &iss->icache_req;
+  req->init();
+  req->set_addr(insn->addr);
+  req->set_size(insn->size);
+  req->set_is_write(false);
+  req->set_data(NULL);
+  req->set_actual_size(0);
+
+  if (iss->icache.req(req) != vp::IO_REQ_OK)
+  {
+    iss->trace.force_warning("Unimplemented failed instruction cache request (addr: 0x%x)\n", insn->addr);
+    return false;
+  }
+
+  int64_t latency = req->get_latency();
+  if (latency)
+  {
+    iss->cpu.state.insn_cycles += latency;
+    iss_pccr_account_event(iss, CSR_PCER_IMISS, latency);
+  }
+
+  return req->get_actual_size() != 0;
+}
+
 static inline int iss_irq_ack(iss_t *iss, int irq)
 {
   iss->decode_trace.msg("Acknowledging interrupt (irq: %d)\n", irq);
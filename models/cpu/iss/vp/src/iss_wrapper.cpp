@@ -23,6 +23,9 @@
 #include "archi/gvsoc/gvsoc.h"
 #include "iss.hpp"
 #include <algorithm>
+#include <climits>
+#include <math.h>
+#include <sys/time.h>
 
 #define HALT_CAUSE_EBREAK    0
 #define HALT_CAUSE_ECALL     1
@@ -44,7 +47,7 @@ static inline void trdb_record_instruction(iss_wrapper *_this, iss_insn_t *insn)
   instr.valid = true;
   instr.exception = false;
   instr.iaddr = insn->addr;
-  instr.instr = insn->opcode;
+  instr.instr = insn->decoded ? insn->decoded->opcode : 0;
   instr.compressed = insn->size == 2;
   
   if (trdb_compress_trace_step(_this->trdb, &_this->trdb_packet_list, &instr))
@@ -66,7 +69,7 @@ static inline void trdb_record_instruction(iss_wrapper *_this, iss_insn_t *insn)
 #endif
 
 
-#define EXEC_INSTR_COMMON(_this, event, func) \
+#define EXEC_INSTR_TRACE(_this) \
 do { \
   \
   _this->trace.msg("Executing instruction\n"); \
@@ -86,28 +89,50 @@ do { \
   { \
   _this->insn_power.account_event(); \
  } \
- \
+} while(0)
+
+#define EXEC_INSTR_BODY(_this, cycles, func) \
+do { \
   iss_insn_t *insn = _this->cpu.current_insn; \
-  int cycles = func(_this); \
+  cycles = func(_this); \
   trdb_record_instruction(_this, insn); \
+} while(0)
+
+#define EXEC_INSTR_STALL(_this) \
+do { \
+  if (_this->misaligned_access.get()) \
+  { \
+    _this->event_enqueue(_this->misaligned_event, _this->misaligned_latency); \
+  } \
+  else \
+  { \
+    _this->is_active_reg.set(false); \
+    _this->stalled.set(true);     \
+  } \
+} while(0)
+
+#define EXEC_INSTR_COMMON(_this, event, func) \
+do { \
+  int cycles; \
+  EXEC_INSTR_TRACE(_this); \
+  EXEC_INSTR_BODY(_this, cycles, func); \
   if (cycles >= 0) \
   { \
     _this->enqueue_next_instr(cycles); \
   } \
   else \
   { \
-    if (_this->misaligned_access.get()) \
-    { \
-      _this->event_enqueue(_this->misaligned_event, _this->misaligned_latency); \
-    } \
-    else \
-    { \
-      _this->is_active_reg.set(false); \
-      _this->stalled.set(true);     \
-    } \
+    EXEC_INSTR_STALL(_this); \
   } \
 } while(0)
 
+static double get_host_time()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec + tv.tv_usec / 1000000.0;
+}
+
 void iss_wrapper::dump_debug_traces()
 {
   const char *func, *inline_func, *file;
@@ -125,8 +150,95 @@ void iss_wrapper::dump_debug_traces()
 void iss_wrapper::exec_instr(void *__this, vp::clock_event *event)
 {
   iss_t *_this = (iss_t *)__this;
+  int batch = _this->insn_batch_size;
+  int cycles;
+
+  // Per-instruction traces can only be enabled from another event, so they
+  // are checked once for the whole batch, and then instructions are chained
+  // directly through their handlers.
+  bool traces = _this->insn_traces_active();
+
+  // Translated blocks do not go through the per-instruction traces
+#ifdef USE_TRDB
+  bool jit = false;
+#else
+  bool jit = _this->cpu.jit.enabled && !traces;
+#endif
+
+  // Instructions are executed back to back, by advancing the clock engine
+  // directly to the next instruction, as long as nothing else is due before
+  // it and the core is still executing with the fast handler.
+  // This keeps the same timing while saving an event per instruction.
+  while (1)
+  {
+    if (unlikely(traces))
+    {
+      EXEC_INSTR_TRACE(_this);
+    }
+
+    if (jit)
+    {
+      EXEC_INSTR_BODY(_this, cycles, iss_exec_step_nofetch_jit);
+    }
+    else
+    {
+      EXEC_INSTR_BODY(_this, cycles, iss_exec_step_nofetch);
+    }
+
+    if (cycles < 0)
+    {
+      EXEC_INSTR_STALL(_this);
+      return;
+    }
+
+    if (--batch <= 0 || _this->current_event != event ||
+      !_this->is_active_reg.get() || !_this->get_clock()->try_advance(cycles))
+    {
+      break;
+    }
+  }
+
+  if (unlikely(_this->cpu.state.nb_insns >= _this->sampling_phase_end))
+  {
+    _this->sampling_update();
+  }
+
+  _this->enqueue_next_instr(cycles);
+}
+
+void iss_wrapper::exec_instr_functional(void *__this, vp::clock_event *event)
+{
+  iss_t *_this = (iss_t *)__this;
+  int batch = _this->insn_batch_size;
+  int cycles;
+
+  // Functional fast-forward of sampled simulation, also used for the whole
+  // execution in functional mode. Instructions are executed like in
+  // exec_instr but the cycles they report, which include the memory
+  // latencies, are ignored and each of them takes exactly one cycle.
+  while (1)
+  {
+    EXEC_INSTR_BODY(_this, cycles, iss_exec_step_nofetch);
+
+    if (cycles < 0)
+    {
+      EXEC_INSTR_STALL(_this);
+      return;
+    }
+
+    if (--batch <= 0 || _this->current_event != event ||
+      !_this->is_active_reg.get() || !_this->get_clock()->try_advance(1))
+    {
+      break;
+    }
+  }
+
+  if (_this->cpu.state.nb_insns >= _this->sampling_phase_end)
+  {
+    _this->sampling_update();
+  }
 
-  EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch);
+  _this->enqueue_next_instr(1);
 }
 
 void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
@@ -137,10 +249,16 @@ void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
   // if HW counters are disabled as they are checked with the slow handler
   if (iss_exec_switch_to_fast(_this))
   {
-    _this->current_event = _this->instr_event;
+    _this->current_event = _this->fast_event();
   }
 
   EXEC_INSTR_COMMON(_this, event, iss_exec_step_nofetch_perf);
+
+  if (unlikely(_this->cpu.state.nb_insns >= _this->sampling_phase_end))
+  {
+    _this->sampling_update();
+  }
+
   if (_this->step_mode.get())
   {
     _this->do_step.set(false);
@@ -152,7 +270,9 @@ void iss_wrapper::exec_instr_check_all(void *__this, vp::clock_event *event)
 
 void iss_wrapper::exec_first_instr(vp::clock_event *event)
 {
-  current_event = event_new(iss_wrapper::exec_instr);
+  current_event = this->fast_event();
+  if (this->traces_active)
+    this->trigger_check_all();
   iss_start(this);
   exec_instr((void *)this, event);
 }
@@ -171,7 +291,8 @@ void iss_wrapper::data_response(void *__this, vp::io_req *req)
 {
   iss_t *_this = (iss_t *)__this;
   _this->stalled.set(false);
-  _this->wakeup_latency = req->get_latency();
+  // Memory latencies are ignored during functional fast-forward
+  _this->wakeup_latency = _this->sampling_phase == ISS_SAMPLING_FUNCTIONAL ? 0 : req->get_latency();
   if (_this->misaligned_access.get())
   {
     _this->misaligned_access.set(false);
@@ -196,6 +317,86 @@ void iss_wrapper::fetch_response(void *_this, vp::io_req *req)
 
 }
 
+static void dmi_refused_clear(uint64_t *refused)
+{
+  for (int i=0; i<ISS_DMI_REFUSED_SIZE; i++)
+    refused[i] = (uint64_t)-1;
+}
+
+// Tell if the direct access to the page of the address was already refused
+static bool dmi_refused(uint64_t *refused, iss_addr_t addr)
+{
+  uint64_t page = addr >> ISS_DMI_REFUSED_PAGE_BITS;
+  return refused[page & (ISS_DMI_REFUSED_SIZE - 1)] == page;
+}
+
+static void dmi_refused_set(uint64_t *refused, iss_addr_t addr)
+{
+  uint64_t page = addr >> ISS_DMI_REFUSED_PAGE_BITS;
+  refused[page & (ISS_DMI_REFUSED_SIZE - 1)] = page;
+}
+
+void iss_wrapper::data_dmi_invalidate(void *__this)
+{
+  iss_t *_this = (iss_t *)__this;
+  _this->data_dmi.invalidate();
+  dmi_refused_clear(_this->data_dmi_refused);
+}
+
+void iss_wrapper::fetch_dmi_invalidate(void *__this)
+{
+  iss_t *_this = (iss_t *)__this;
+  _this->fetch_dmi.invalidate();
+  dmi_refused_clear(_this->fetch_dmi_refused);
+}
+
+void iss_wrapper::fetch_code_write(void *__this, uint64_t addr, uint64_t size)
+{
+  iss_t *_this = (iss_t *)__this;
+  iss_cache_invalidate(_this, addr, size);
+}
+
+vp::io_req_status_e iss_wrapper::icache_evict_req(void *__this, vp::io_req *req)
+{
+  iss_t *_this = (iss_t *)__this;
+  iss_icache_evict(_this, req->get_addr(), req->get_size());
+  return vp::IO_REQ_OK;
+}
+
+bool iss_wrapper::data_dmi_req(iss_addr_t addr, int size)
+{
+  if (!this->dmi_enabled || dmi_refused(this->data_dmi_refused, addr))
+    return false;
+
+  if (!this->data.dmi_req(addr, &this->data_dmi))
+  {
+    dmi_refused_set(this->data_dmi_refused, addr);
+    return false;
+  }
+
+  if (!this->data_dmi.contains(addr, size))
+    return false;
+
+  if (this->get_functional())
+    this->data_dmi.latency = 0;
+
+  return true;
+}
+
+bool iss_wrapper::fetch_dmi_req(iss_addr_t addr, int size)
+{
+  if (!this->dmi_enabled || dmi_refused(this->fetch_dmi_refused, addr))
+    return false;
+
+  if (!this->fetch.dmi_req(addr, &this->fetch_dmi))
+  {
+    dmi_refused_set(this->fetch_dmi_refused, addr);
+    return false;
+  }
+
+  return this->fetch_dmi.contains(addr, size);
+}
+
 void iss_wrapper::bootaddr_sync(void *__this, uint32_t value)
 {
   iss_t *_this = (iss_t *)__this;
@@ -323,6 +524,9 @@ void iss_wrapper::halt_core()
   else
     this->ppc = this->cpu.prev_insn->addr;
   this->npc = this->cpu.current_insn->addr;
+
+  if (this->gdbserver)
+    this->gdbserver->signal(this);
 }
 
 
@@ -358,10 +562,7 @@ void iss_wrapper::check_state()
         do_step.set(true);
       enqueue_next_instr(1 + this->wakeup_latency);
 
-      if (this->cpu.csr.pcmr & CSR_PCMR_ACTIVE && this->cpu.csr.pcer & (1<<CSR_PCER_CYCLES))
-      {
-        this->cpu.csr.pccr[CSR_PCER_CYCLES] += 1 + this->wakeup_latency;
-      }
+      this->cpu.state.nb_cycles += 1 + this->wakeup_latency;
 
       this->wakeup_latency = 0;
     }
@@ -717,6 +918,145 @@ vp::io_req_status_e iss_wrapper::dbg_unit_req(void *__this, vp::io_req *req)
 }
 
 
+
+void iss_wrapper::handle_breakpoint()
+{
+  this->trace.msg("Reached breakpoint (pc: 0x%x)\n", this->cpu.current_insn->addr);
+  this->set_halt_mode(true, HALT_CAUSE_EBREAK);
+  this->check_state();
+}
+
+
+
+// The GDB server drives the core through the same registers as an external
+// debugger would do through the debug unit
+int iss_wrapper::dbg_unit_access(uint64_t offset, iss_reg_t *value, bool is_write)
+{
+  vp::io_req req;
+  req.init();
+  req.set_addr(offset);
+  req.set_size(sizeof(iss_reg_t));
+  req.set_is_write(is_write);
+  req.set_data((uint8_t *)value);
+  return iss_wrapper::dbg_unit_req((void *)this, &req) != vp::IO_REQ_OK;
+}
+
+int iss_wrapper::gdbserver_get_id()
+{
+  return this->cpu.config.mhartid;
+}
+
+std::string iss_wrapper::gdbserver_get_name()
+{
+  return this->get_path();
+}
+
+int iss_wrapper::gdbserver_get_nb_regs()
+{
+  // General purpose registers and PC
+  return ISS_NB_REGS + 1;
+}
+
+int iss_wrapper::gdbserver_get_reg_size()
+{
+  return sizeof(iss_reg_t);
+}
+
+int iss_wrapper::gdbserver_reg_get(int reg, uint8_t *value)
+{
+  if (reg == ISS_NB_REGS)
+    return this->dbg_unit_access(0x2000, (iss_reg_t *)value, false);
+  else if (reg >= 0 && reg < ISS_NB_REGS)
+    return this->dbg_unit_access(0x400 + reg * 4, (iss_reg_t *)value, false);
+  return -1;
+}
+
+int iss_wrapper::gdbserver_reg_set(int reg, uint8_t *value)
+{
+  if (reg == ISS_NB_REGS)
+    return this->dbg_unit_access(0x2000, (iss_reg_t *)value, true);
+  else if (reg >= 0 && reg < ISS_NB_REGS)
+    return this->dbg_unit_access(0x400 + reg * 4, (iss_reg_t *)value, true);
+  return -1;
+}
+
+int iss_wrapper::gdbserver_mem_access(uint64_t addr, int size, uint8_t *data, bool is_write)
+{
+  uint64_t start = addr;
+  int total = size;
+
+  // Accesses are split into aligned words as this is what the targets
+  // accept from the core
+  while (size > 0)
+  {
+    int word_size = ISS_REG_WIDTH/8;
+    int chunk = word_size - (addr & (word_size - 1));
+    if (chunk > size)
+      chunk = size;
+
+    vp::io_req *req = &this->gdbserver_req;
+    req->init();
+    req->set_debug(true);
+    req->set_addr(addr);
+    req->set_size(chunk);
+    req->set_is_write(is_write);
+    req->set_data(data);
+
+    if (this->data.req(req) != vp::IO_REQ_OK)
+      return -1;
+
+    addr += chunk;
+    data += chunk;
+    size -= chunk;
+  }
+
+  // The debugger may write code, e.g. when loading a binary
+  if (is_write)
+    iss_cache_invalidate(this, start, total);
+
+  return 0;
+}
+
+int iss_wrapper::gdbserver_stop()
+{
+  iss_reg_t value = 1 << 16;
+  return this->dbg_unit_access(0x0, &value, true);
+}
+
+int iss_wrapper::gdbserver_cont()
+{
+  iss_reg_t value = 0;
+  this->get_clock()->sync();
+  return this->dbg_unit_access(0x0, &value, true);
+}
+
+int iss_wrapper::gdbserver_stepi()
+{
+  iss_reg_t value = 1;
+  this->get_clock()->sync();
+  return this->dbg_unit_access(0x0, &value, true);
+}
+
+bool iss_wrapper::gdbserver_is_halted()
+{
+  return this->halted.get();
+}
+
+int iss_wrapper::gdbserver_breakpoint_insert(uint64_t addr)
+{
+  this->trace.msg("Inserting breakpoint (addr: 0x%lx)\n", addr);
+  iss_breakpoint_insert(this, addr);
+  return 0;
+}
+
+int iss_wrapper::gdbserver_breakpoint_remove(uint64_t addr)
+{
+  this->trace.msg("Removing breakpoint (addr: 0x%lx)\n", addr);
+  iss_breakpoint_remove(this, addr);
+  return 0;
+}
+
+
 int iss_wrapper::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
@@ -773,12 +1113,107 @@ int iss_wrapper::build()
 
   data.set_resp_meth(&iss_wrapper::data_response);
   data.set_grant_meth(&iss_wrapper::data_grant);
+  data.set_dmi_invalidate_meth(&iss_wrapper::data_dmi_invalidate);
   new_master_port("data", &data);
 
   fetch.set_resp_meth(&iss_wrapper::fetch_response);
   fetch.set_grant_meth(&iss_wrapper::fetch_grant);
+  fetch.set_dmi_invalidate_meth(&iss_wrapper::fetch_dmi_invalidate);
+  fetch_dmi.set_write_meth(&iss_wrapper::fetch_code_write, (void *)this);
   new_master_port("fetch", &fetch);
 
+  new_master_port("icache", &icache);
+  icache_evict_itf.set_req_meth(&iss_wrapper::icache_evict_req);
+  new_slave_port("icache_evict", &icache_evict_itf);
+
+  js::config *dmi_conf = get_js_config()->get("dmi");
+  this->dmi_enabled = dmi_conf == NULL || dmi_conf->get_bool();
+  dmi_refused_clear(this->data_dmi_refused);
+  dmi_refused_clear(this->fetch_dmi_refused);
+
+  js::config *batch_conf = get_js_config()->get("insn_batch_size");
+  this->insn_batch_size = batch_conf ? batch_conf->get_int() : ISS_INSN_BATCH_SIZE;
+
+  js::config *jit_conf = get_js_config()->get("jit");
+  this->cpu.jit.enabled = jit_conf != NULL && jit_conf->get_bool();
+  js::config *jit_threshold_conf = get_js_config()->get("jit_threshold");
+  this->cpu.jit.threshold = jit_threshold_conf ? jit_threshold_conf->get_int() : ISS_JIT_THRESHOLD;
+
+  // Sampled simulation, e.g. "sampling": {"period": 1000000, "warmup": 2000, "window": 10000}
+  // executes in each period of 1000000 instructions the last 12000 ones with
+  // detailed timing, and measures the last 10000 ones.
+  js::config *sampling_conf = get_js_config()->get("sampling");
+  int sampling_period = sampling_conf ? sampling_conf->get_child_int("period") : 0;
+  this->sampling_enabled = sampling_period > 0;
+  if (this->sampling_enabled)
+  {
+    this->sampling_warmup_insns = sampling_conf->get_child_int("warmup");
+    this->sampling_window_insns = sampling_conf->get_child_int("window");
+
+    if (this->sampling_window_insns == 0 || (uint64_t)sampling_period < this->sampling_warmup_insns + this->sampling_window_insns)
+    {
+      this->warning.fatal("Invalid sampling configuration, the window must be non-empty and fit in the period with the warmup (period: %d, warmup: %ld, window: %ld)\n",
+        sampling_period, this->sampling_warmup_insns, this->sampling_window_insns);
+    }
+
+    this->sampling_functional_insns = sampling_period - this->sampling_warmup_insns - this->sampling_window_insns;
+
+    // Translated blocks don't report how many instructions they executed,
+    // which is needed to switch phases
+    this->cpu.jit.enabled = false;
+  }
+  this->sampling_phase = ISS_SAMPLING_DETAILED;
+  this->sampling_phase_end = UINT64_MAX;
+
+  // In functional mode, the core stays in the functional phase for the whole
+  // execution, which makes sampling meaningless, and instructions are
+  // executed back to back until the core blocks or another event is due.
+  if (this->get_functional())
+  {
+    this->sampling_enabled = false;
+    this->sampling_phase = ISS_SAMPLING_FUNCTIONAL;
+    if (batch_conf == NULL)
+      this->insn_batch_size = INT_MAX;
+
+    // The speed is reported from the number of executed instructions, which
+    // translated blocks don't report
+    this->cpu.jit.enabled = false;
+  }
+
+  // Function-level profiler, e.g. "profiler": {"enabled": true, "folded": "pe0.folded", "table_size": 20}
+  // dumps the cycles of each call stack into pe0.folded, which can be given
+  // to flamegraph.pl, and a table of the 20 functions with the most cycles.
+  js::config *profiler_conf = get_js_config()->get("profiler");
+  this->profiler_enabled = profiler_conf != NULL && profiler_conf->get_child_bool("enabled");
+  if (this->profiler_enabled)
+  {
+    js::config *folded_conf = profiler_conf->get("folded");
+    this->profiler_folded = folded_conf ? folded_conf->get_str() : this->get_output_file(".folded");
+
+    js::config *table_conf = profiler_conf->get("table_size");
+    this->profiler_table_size = table_conf ? table_conf->get_int() : 20;
+
+    // Translated blocks don't report how many instructions they executed
+    this->cpu.jit.enabled = false;
+  }
+
+  // Execution histogram, e.g. "histogram": {"enabled": true, "path": "pe0.hist"}
+  // dumps the execution count of each instruction into pe0.hist, which can
+  // be turned into coverage and hot loop reports with pulp-insn-histogram.
+  js::config *histogram_conf = get_js_config()->get("histogram");
+  this->cpu.insn_cache.histogram = histogram_conf != NULL && histogram_conf->get_child_bool("enabled");
+  if (this->cpu.insn_cache.histogram)
+  {
+    js::config *path_conf = histogram_conf->get("path");
+    this->histogram_path = path_conf ? path_conf->get_str() : this->get_output_file(".hist");
+
+    // Instructions executed inline by translated blocks are not counted
+    this->cpu.jit.enabled = false;
+  }
+
+  // Only known once all components are built, see start
+  this->gdbserver = NULL;
+
   dbg_unit.set_req_meth(&iss_wrapper::dbg_unit_req);
   new_slave_port("dbg_unit", &dbg_unit);
 
@@ -808,6 +1243,7 @@ int iss_wrapper::build()
   current_event = event_new(iss_wrapper::exec_first_instr);
   instr_event = event_new(iss_wrapper::exec_instr);
   check_all_event = event_new(iss_wrapper::exec_instr_check_all);
+  functional_event = event_new(iss_wrapper::exec_instr_functional);
   misaligned_event = event_new(iss_wrapper::exec_misaligned);
 
   this->bootaddr_offset = get_config_int("bootaddr_offset");
@@ -832,13 +1268,47 @@ void iss_wrapper::start()
 
 
 
+  // The instruction cache is only modeled when it is connected, and not in
+  // functional mode where fetches take no time
+  bool icache = this->icache.is_bound() && !this->get_functional();
+  if (icache)
+  {
+    // Translated blocks execute the instructions without their handlers
+    this->cpu.jit.enabled = false;
+  }
+
   if (iss_open(this)) throw logic_error("Error while instantiating the ISS");
 
+  this->cpu.insn_cache.icache = icache;
+
   for (auto x:this->get_js_config()->get("**/debug_binaries")->get_elems())
   {
     iss_register_debug_info(this, x->get_str().c_str());
   }
 
+  this->gdbserver = (vp::gdbserver_engine *)this->get_service("gdbserver");
+  if (this->gdbserver)
+  {
+    this->gdbserver->register_core(this);
+  }
+
+
+  // Traces are now registered, the ones already enabled are taken into
+  // account here, and the other ones when they are enabled
+  this->insn_traces_decoded = iss_insn_trace_active(this) || iss_insn_event_active(this);
+  this->traces_active = this->check_traces_active();
+
+  std::vector<vp::trace *> core_traces = { &this->trace, &this->insn_trace, &this->insn_trace_event,
+    &this->pc_trace_event, &this->func_trace_event, &this->inline_trace_event, &this->file_trace_event,
+    &this->line_trace_event, &this->ipc_stat_event, &this->power_trace.trace };
+  for (int i=0; i<CSR_PCER_NB_EVENTS; i++)
+  {
+    core_traces.push_back(&this->pcer_trace_event[i]);
+  }
+  for (auto x: core_traces)
+  {
+    x->reg_callback([this]() { this->traces_update(); });
+  }
 
   trace.msg("ISS start (fetch: %d, is_active: %d, boot_addr: 0x%lx)\n", fetch_enable_reg.get(), is_active_reg.get(), get_config_int("boot_addr"));
 
@@ -848,6 +1318,432 @@ void iss_wrapper::start()
 #endif
 
   this->leakage_power.power_on();
+
+  this->functional_start_time = get_host_time();
+}
+
+bool iss_wrapper::check_traces_active()
+{
+  if (this->insn_traces_active() || iss_insn_trace_active(this) || iss_insn_event_active(this))
+    return true;
+
+  // Internal events are only traced by the handlers checking everything
+  for (int i=0; i<CSR_PCER_NB_EVENTS; i++)
+  {
+    if (this->pcer_trace_event[i].get_event_active())
+      return true;
+  }
+
+  return false;
+}
+
+void iss_wrapper::traces_update()
+{
+  // The instruction traces are installed on the instructions when they are
+  // decoded, so they must all be decoded again when these traces change
+  bool insn_traces = iss_insn_trace_active(this) || iss_insn_event_active(this);
+  if (insn_traces != this->insn_traces_decoded)
+  {
+    this->insn_traces_decoded = insn_traces;
+    iss_cache_reset(this);
+  }
+
+  this->traces_active = this->check_traces_active();
+
+  trace.msg("Updated traces (active: %d)\n", this->traces_active);
+
+  // Go through the handler checking everything, which switches back to the
+  // fast handlers only if nothing is active anymore
+  this->trigger_check_all();
+}
+
+// Called when the current sampling phase is over, to go to the next one.
+// Phases are delimited by instruction counts so that the same instructions
+// are measured whatever their timing, and the cycles spent in each window,
+// including stalls and sleep periods, give one CPI sample.
+void iss_wrapper::sampling_update()
+{
+  uint64_t insns = this->cpu.state.nb_insns;
+
+  switch (this->sampling_phase)
+  {
+    case ISS_SAMPLING_FUNCTIONAL:
+      this->sampling_phase = ISS_SAMPLING_WARMUP;
+      this->sampling_phase_end = insns + this->sampling_warmup_insns;
+      break;
+
+    case ISS_SAMPLING_WARMUP:
+      this->sampling_phase = ISS_SAMPLING_DETAILED;
+      this->sampling_phase_end = insns + this->sampling_window_insns;
+      this->sampling_window_start_insns = insns;
+      this->sampling_window_start_cycles = this->get_cycles();
+      break;
+
+    case ISS_SAMPLING_DETAILED:
+      // Nothing to measure when sampling starts from reset
+      if (insns > this->sampling_window_start_insns)
+      {
+        double cpi = (double)(this->get_cycles() - this->sampling_window_start_cycles) /
+          (insns - this->sampling_window_start_insns);
+        this->sampling_nb_windows++;
+        this->sampling_cpi_sum += cpi;
+        this->sampling_cpi_sq_sum += cpi * cpi;
+        this->trace.msg("Sampling window done (insns: %ld, cpi: %f)\n", insns - this->sampling_window_start_insns, cpi);
+      }
+      this->sampling_phase = ISS_SAMPLING_FUNCTIONAL;
+      this->sampling_phase_end = insns + this->sampling_functional_insns;
+      break;
+  }
+
+  trace.msg("Switching sampling phase (phase: %d, insns: %ld, end: %ld)\n", this->sampling_phase, insns, this->sampling_phase_end);
+
+  // Empty phases are skipped directly
+  if (insns >= this->sampling_phase_end)
+  {
+    this->sampling_update();
+    return;
+  }
+
+  // Only switch the handler if the core is executing with the fast one, the
+  // handler checking everything will switch to the right one
+  if (this->current_event == this->instr_event || this->current_event == this->functional_event)
+  {
+    this->current_event = this->fast_event();
+  }
+}
+
+// Dumps the cycles extrapolated from the sampled windows. The estimation is
+// the mean CPI of the windows applied to all the executed instructions, and
+// the interval is the 95% confidence interval of this mean.
+void iss_wrapper::sampling_report()
+{
+  uint64_t insns = this->cpu.state.nb_insns;
+  int n = this->sampling_nb_windows;
+
+  if (n == 0)
+  {
+    fprintf(stdout, "%s: sampling: no complete window (instructions: %ld)\n", this->get_path().c_str(), insns);
+    return;
+  }
+
+  double cpi = this->sampling_cpi_sum / n;
+  double interval = 0;
+  if (n > 1)
+  {
+    double variance = (this->sampling_cpi_sq_sum - n * cpi * cpi) / (n - 1);
+    interval = 1.96 * sqrt(std::max(variance, 0.0) / n);
+  }
+
+  fprintf(stdout, "%s: sampling: windows: %d, instructions: %ld, CPI: %.4f +/- %.4f, estimated cycles: %.0f +/- %.0f (95%% confidence)%s\n",
+    this->get_path().c_str(), n, insns, cpi, interval, cpi * insns, interval * insns,
+    n > 1 ? "" : ", single window, no interval");
+}
+
+// Dumps the simulation speed in functional mode, which is what matters
+// there as the timing is not modeled.
+void iss_wrapper::functional_report()
+{
+  uint64_t insns = this->cpu.state.nb_insns;
+  double duration = get_host_time() - this->functional_start_time;
+
+  fprintf(stdout, "%s: functional: instructions: %ld, time: %.3f s, speed: %.2f MIPS\n",
+    this->get_path().c_str(), insns, duration, duration > 0 ? insns / duration / 1000000 : 0.0);
+}
+
+static inline bool profiler_is_link_reg(int reg)
+{
+  return reg == 1 || reg == 5;
+}
+
+// Classifies jumps with the hints of the calling convention: a jump writing
+// the link register is a call, a jump through the link register which does
+// not write it is a return, and both at the same time is a return followed
+// by a call. Other jumps leaving the current function are tail calls.
+// Traps are not followed, so interrupt handlers are accounted to the
+// interrupted function.
+void iss_wrapper::profiler_jump(iss_insn_t *insn, iss_addr_t target, int rs1)
+{
+  // The function executed before the first jump is only known now
+  if (this->profiler_stack.size() == 0)
+  {
+    this->profiler_push(insn->addr, false);
+  }
+
+  int rd = insn->out_regs[0];
+  bool rd_link = profiler_is_link_reg(rd);
+  bool rs1_link = profiler_is_link_reg(rs1);
+
+  if (!rd_link && !rs1_link)
+  {
+    iss_profiler_node *node = this->profiler_stack.back();
+    if (node->start == node->end || (target >= node->start && target < node->end))
+      return;
+  }
+
+  this->profiler_account();
+
+  if (rs1_link && rd != rs1)
+  {
+    this->profiler_return(target);
+    if (rd_link)
+    {
+      this->profiler_push(target, true);
+    }
+  }
+  else if (rd_link)
+  {
+    this->profiler_push(target, true);
+  }
+  else
+  {
+    this->profiler_stack.pop_back();
+    this->profiler_push(target, true);
+  }
+}
+
+// Accounts the cycles and instructions executed since the last stack change
+// to the function on top of the stack
+void iss_wrapper::profiler_account()
+{
+  int64_t cycles = this->get_clock()->get_cycles();
+  uint64_t insns = this->cpu.state.nb_insns;
+  iss_profiler_node *node = this->profiler_stack.size() ? this->profiler_stack.back() : &this->profiler_root;
+
+  node->cycles += cycles - this->profiler_cycles;
+  node->insns += insns - this->profiler_insns;
+
+  this->profiler_cycles = cycles;
+  this->profiler_insns = insns;
+}
+
+void iss_wrapper::profiler_push(iss_addr_t addr, bool is_call)
+{
+  // Calls which never return, e.g. because the function returns through
+  // another register, would otherwise make the stack grow forever
+  if (this->profiler_stack.size() >= ISS_PROFILER_MAX_DEPTH)
+  {
+    this->profiler_stack.pop_back();
+  }
+
+  iss_profiler_node *parent = this->profiler_stack.size() ? this->profiler_stack.back() : &this->profiler_root;
+  iss_profiler_node *node = parent->last_child;
+
+  if (node == NULL || parent->last_target != addr)
+  {
+    iss_addr_t start, end;
+    const char *name = this->profiler_func(addr, &start, &end);
+
+    auto it = parent->children.find(name);
+    if (it != parent->children.end())
+    {
+      node = it->second;
+    }
+    else
+    {
+      node = new iss_profiler_node(name, parent);
+      node->start = start;
+      node->end = end;
+      parent->children[name] = node;
+    }
+
+    parent->last_target = addr;
+    parent->last_child = node;
+  }
+
+  if (is_call)
+  {
+    node->calls++;
+  }
+
+  this->profiler_stack.push_back(node);
+}
+
+void iss_wrapper::profiler_return(iss_addr_t target)
+{
+  // The caller is usually the previous function of the stack, but going
+  // back further is also possible, e.g. with longjmp
+  for (int i=this->profiler_stack.size()-2; i>=0; i--)
+  {
+    iss_profiler_node *node = this->profiler_stack[i];
+    if (target >= node->start && target < node->end)
+    {
+      this->profiler_stack.resize(i + 1);
+      return;
+    }
+  }
+
+  // The caller was not seen, e.g. when returning from the entry function
+  this->profiler_stack.pop_back();
+  if (this->profiler_stack.size() == 0)
+  {
+    this->profiler_push(target, false);
+  }
+}
+
+// Functions without debug information are named after their first seen
+// address, and have an empty address range. The result is kept for each
+// address as the same functions are called again and again.
+const char *iss_wrapper::profiler_func(iss_addr_t addr, iss_addr_t *start, iss_addr_t *end)
+{
+  auto it = this->profiler_funcs.find(addr);
+  if (it == this->profiler_funcs.end())
+  {
+    iss_profiler_func_t func;
+    func.name = iss_debug_func(addr, &func.start, &func.end);
+    if (func.name == NULL)
+    {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "0x%" PRIxFULLREG, (iss_reg_t)addr);
+      func.name = this->profiler_names.insert(std::string(buffer)).first->c_str();
+      func.start = func.end = addr;
+    }
+    it = this->profiler_funcs.insert(std::make_pair(addr, func)).first;
+  }
+
+  *start = it->second.start;
+  *end = it->second.end;
+  return it->second.name;
+}
+
+// Dumps the folded stacks of the node and of its callees, and returns the
+// cycles spent in all of them
+uint64_t iss_wrapper::profiler_dump(FILE *file, iss_profiler_node *node, std::string stack)
+{
+  if (node->name)
+  {
+    stack = stack.size() ? stack + ";" + node->name : node->name;
+    if (node->cycles)
+    {
+      fprintf(file, "%s %" PRIu64 "\n", stack.c_str(), node->cycles);
+    }
+  }
+
+  uint64_t cycles = node->cycles;
+  for (auto &x: node->children)
+  {
+    cycles += this->profiler_dump(file, x.second, stack);
+  }
+
+  return cycles;
+}
+
+typedef struct {
+  const char *name;
+  uint64_t self_cycles;
+  uint64_t total_cycles;
+  uint64_t insns;
+  uint64_t calls;
+} profiler_func_stats_t;
+
+// Gathers the statistics of each function from the call tree. The total
+// cycles of a function only count its outermost occurrence in a stack, so
+// that recursive calls are not counted several times.
+static uint64_t profiler_func_stats(iss_profiler_node *node, std::unordered_map<const char *, profiler_func_stats_t> &stats,
+  std::unordered_map<const char *, int> &active)
+{
+  if (node->name)
+  {
+    active[node->name]++;
+  }
+
+  uint64_t cycles = node->cycles;
+  for (auto &x: node->children)
+  {
+    cycles += profiler_func_stats(x.second, stats, active);
+  }
+
+  if (node->name)
+  {
+    profiler_func_stats_t *func = &stats[node->name];
+    func->name = node->name;
+    func->self_cycles += node->cycles;
+    func->insns += node->insns;
+    func->calls += node->calls;
+    if (--active[node->name] == 0)
+    {
+      func->total_cycles += cycles;
+    }
+  }
+
+  return cycles;
+}
+
+void iss_wrapper::profiler_report()
+{
+  if (this->profiler_stack.size() == 0 && this->cpu.current_insn)
+  {
+    this->profiler_push(this->cpu.current_insn->addr, false);
+  }
+  this->profiler_account();
+
+  uint64_t cycles;
+  FILE *file = fopen(this->profiler_folded.c_str(), "w");
+  if (file == NULL)
+  {
+    this->warning.force_warning("Unable to open profiler output (path: %s)\n", this->profiler_folded.c_str());
+    return;
+  }
+  cycles = this->profiler_dump(file, &this->profiler_root, "");
+  fclose(file);
+
+  std::unordered_map<const char *, profiler_func_stats_t> stats;
+  std::unordered_map<const char *, int> active;
+  profiler_func_stats(&this->profiler_root, stats, active);
+
+  std::vector<profiler_func_stats_t> funcs;
+  for (auto &x: stats)
+  {
+    funcs.push_back(x.second);
+  }
+  std::sort(funcs.begin(), funcs.end(), [](const profiler_func_stats_t &a, const profiler_func_stats_t &b) {
+    return a.self_cycles > b.self_cycles || (a.self_cycles == b.self_cycles && strcmp(a.name, b.name) < 0);
+  });
+
+  double total = cycles ? cycles : 1;
+  fprintf(stdout, "%s: profiler: cycles: %" PRIu64 ", folded stacks: %s\n", this->get_path().c_str(), cycles,
+    this->profiler_folded.c_str());
+  fprintf(stdout, "%14s %7s %14s %7s %14s %10s  %s\n", "self cycles", "%", "total cycles", "%", "instructions", "calls", "function");
+  for (int i=0; i<(int)funcs.size() && i<this->profiler_table_size; i++)
+  {
+    profiler_func_stats_t *func = &funcs[i];
+    fprintf(stdout, "%14" PRIu64 " %6.2f%% %14" PRIu64 " %6.2f%% %14" PRIu64 " %10" PRIu64 "  %s\n",
+      func->self_cycles, func->self_cycles * 100 / total, func->total_cycles, func->total_cycles * 100 / total,
+      func->insns, func->calls, func->name);
+  }
+}
+
+// Default name of the files dumped by the core, made from its path
+std::string iss_wrapper::get_output_file(std::string extension)
+{
+  std::string path = this->get_path().substr(1) + extension;
+  std::replace(path.begin(), path.end(), '/', '.');
+  return path;
+}
+
+void iss_wrapper::stop()
+{
+  if (this->cpu.insn_cache.histogram)
+  {
+    if (iss_histogram_dump(this, this->histogram_path.c_str()))
+    {
+      this->warning.force_warning("Unable to dump execution histogram (path: %s)\n", this->histogram_path.c_str());
+    }
+  }
+
+  if (this->profiler_enabled)
+  {
+    this->profiler_report();
+  }
+
+  if (this->sampling_enabled)
+  {
+    this->sampling_report();
+  }
+
+  if (this->get_functional())
+  {
+    this->functional_report();
+  }
 }
 
 void iss_wrapper::pre_reset()
@@ -875,12 +1771,36 @@ void iss_wrapper::reset(bool active)
     this->ipc_stat_delay = 10;
 
     iss_reset(this);
+
+    // The stack is not known anymore, but what was accounted is kept
+    this->profiler_stack.clear();
+    this->profiler_cycles = this->get_clock()->get_cycles();
+    this->profiler_insns = 0;
+
+    if (this->sampling_enabled)
+    {
+      // Instruction counts start again from 0, so does the sampling
+      this->sampling_nb_windows = 0;
+      this->sampling_cpi_sum = 0;
+      this->sampling_cpi_sq_sum = 0;
+      this->sampling_window_start_insns = 0;
+      this->sampling_phase = ISS_SAMPLING_DETAILED;
+      this->sampling_update();
+    }
   }
   else
   {
     iss_pc_set(this, this->bootaddr_reg.get() + 0x80);
     iss_irq_set_vector_table(this, this->bootaddr_reg.get());
 
+    // When there is a GDB server, the core waits for the debugger before
+    // executing its first instruction
+    if (this->gdbserver)
+    {
+      this->set_halt_mode(true, HALT_CAUSE_HALT);
+      this->halt_core();
+    }
+
     check_state();
   }
 }
@@ -93,6 +93,7 @@ void converter::event_handler(void *__this, vp::clock_event *event)
   {
     _this->ready_cycle = _this->get_cycles() + req->get_latency() + 1;
     _this->ongoing_size -= req->get_size();
+    _this->out.req_del(req);
     if (_this->ongoing_size == 0)
     {
       vp::io_req *req = _this->ongoing_req;
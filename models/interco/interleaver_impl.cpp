@@ -39,6 +39,8 @@ public:
 
   static void response(void *_this, vp::io_req *req);
 
+  static void dmi_invalidate(void *_this);
+
 private:
   vp::trace     trace;
 
@@ -124,6 +126,20 @@ void interleaver::response(void *_this, vp::io_req *req)
 {
 }
 
+// Direct accesses cannot be granted as consecutive addresses are on
+// different slaves, but the invalidations must still be propagated to the
+// masters in case a slave invalidates.
+void interleaver::dmi_invalidate(void *__this)
+{
+  interleaver *_this = (interleaver *)__this;
+
+  _this->in.dmi_invalidate();
+  for (int i=0; i<_this->nb_masters; i++)
+  {
+    _this->masters_in[i]->dmi_invalidate();
+  }
+}
+
 int interleaver::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
@@ -146,6 +162,7 @@ int interleaver::build()
     out[i] = new vp::io_master();
     out[i]->set_resp_meth(&interleaver::response);
     out[i]->set_grant_meth(&interleaver::grant);
+    out[i]->set_dmi_invalidate_meth(&interleaver::dmi_invalidate);
     new_master_port("out_" + std::to_string(i), out[i]);
   }
 
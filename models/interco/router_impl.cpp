@@ -94,14 +94,20 @@ public:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, vp::io_dmi *dmi, uint64_t addr);
+
 
   static void grant(void *_this, vp::io_req *req);
 
   static void response(void *_this, vp::io_req *req);
 
+  static void dmi_invalidate(void *_this);
+
 private:
   vp::trace     trace;
 
+  MapEntry *get_entry(uint64_t offset, uint64_t size);
+
   io_master_map out;
   vp::io_slave in;
   bool init = false;
@@ -157,22 +163,15 @@ void MapEntry::insert(router *router)
   }
 }
 
-vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+MapEntry *router::get_entry(uint64_t offset, uint64_t size)
 {
-  router *_this = (router *)__this;
-  
-  if (!_this->init)
+  if (!this->init)
   {
-    _this->init = true;
-    _this->init_entries();
+    this->init = true;
+    this->init_entries();
   }
 
-  MapEntry *entry = _this->topMapEntry;
-  uint64_t offset = req->get_addr();
-  bool isRead = !req->get_is_write();
-  uint64_t size = req->get_size();  
-
-  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+  MapEntry *entry = this->topMapEntry;
 
   if (entry)
   {
@@ -190,12 +189,27 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
   }
 
   if (!entry) {
-    if (_this->errorMapEntry && offset >= _this->errorMapEntry->base && offset + size - 1 <= _this->errorMapEntry->base + _this->errorMapEntry->size - 1) {
+    if (this->errorMapEntry && offset >= this->errorMapEntry->base && offset + size - 1 <= this->errorMapEntry->base + this->errorMapEntry->size - 1) {
     } else {
-      entry = _this->defaultMapEntry;
+      entry = this->defaultMapEntry;
     }
   }
 
+  return entry;
+}
+
+vp::io_req_status_e router::req(void *__this, vp::io_req *req)
+{
+  router *_this = (router *)__this;
+  
+  uint64_t offset = req->get_addr();
+  bool isRead = !req->get_is_write();
+  uint64_t size = req->get_size();  
+
+  _this->trace.msg("Received IO req (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
+
+  MapEntry *entry = _this->get_entry(offset, size);
+
   if (!entry) {
     //_this->trace.msg(&warning, "Invalid access (offset: 0x%llx, size: 0x%llx, isRead: %d)\n", offset, size, isRead);
     return vp::IO_REQ_INVALID;
@@ -232,7 +246,7 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
     entry->nextPacketTime = routerTime + req->getLength();
 
 #endif
-  } else {
+  } else if (!_this->get_functional()) {
     req->inc_latency(entry->latency + _this->latency);
   }
 
@@ -260,7 +274,8 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
       req->arg_pop();
   }
 
-  if (entry->id != -1) 
+  // Performance counters are not updated in functional mode
+  if (entry->id != -1 && !_this->get_functional())
   {
     int64_t latency = req->get_latency();
     int64_t duration = req->get_duration();
@@ -283,6 +298,60 @@ vp::io_req_status_e router::req(void *__this, vp::io_req *req)
   return result;
 }
 
+bool router::dmi_req(void *__this, vp::io_dmi *dmi, uint64_t addr)
+{
+  router *_this = (router *)__this;
+
+  MapEntry *entry = _this->get_entry(addr, 1);
+
+  // The default entry is not granted as its range is overlapping the other
+  // entries, as well as the ones with performance counters unless they are
+  // not updated in functional mode, or when the router is traced, as direct
+  // accesses are not seen by the router.
+  if (!entry || entry == _this->defaultMapEntry || (entry->id != -1 && !_this->get_functional()) ||
+    _this->trace.get_active())
+    return false;
+
+  uint64_t offset = addr;
+  if (entry->remove_offset) offset = addr - entry->remove_offset;
+  if (entry->add_offset) offset = addr + entry->add_offset;
+
+  bool granted = false;
+  if (entry->port)
+  {
+    granted = _this->out.dmi_req(offset, dmi, entry->port);
+  }
+  else if (entry->itf && entry->itf->is_bound())
+  {
+    granted = entry->itf->dmi_req(offset, dmi);
+  }
+
+  if (!granted)
+    return false;
+
+  // The range is given in the target address space, move it back to ours and
+  // restrict it to the entry.
+  uint64_t start = dmi->base + addr - offset;
+  uint64_t end = start + dmi->size;
+
+  if (start < entry->base) start = entry->base;
+  if (end > entry->base + entry->size) end = entry->base + entry->size;
+
+  dmi->data += start - (dmi->base + addr - offset);
+  dmi->base = start;
+  dmi->size = end - start;
+  if (!_this->get_functional())
+    dmi->latency += entry->latency + _this->latency;
+
+  return true;
+}
+
+void router::dmi_invalidate(void *__this)
+{
+  router *_this = (router *)__this;
+  _this->in.dmi_invalidate();
+}
+
 void router::grant(void *__this, vp::io_req *req)
 {
   router *_this = (router *)__this;
@@ -307,11 +376,17 @@ int router::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
 
+  // Direct accesses are not granted while the router is traced, the ones
+  // already granted are revoked when this changes
+  trace.reg_callback([this]() { this->in.dmi_invalidate(); });
+
   in.set_req_meth(&router::req);
+  in.set_dmi_meth(&router::dmi_req);
   new_slave_port("input", &in);
 
   out.set_resp_meth(&router::response);
   out.set_grant_meth(&router::grant);
+  out.set_dmi_invalidate_meth(&router::dmi_invalidate);
   new_master_port("out", &out);
 
   bandwidth = get_config_int("bandwidth");
@@ -332,6 +407,7 @@ int router::build()
 
       itf->set_resp_meth(&router::response);
       itf->set_grant_meth(&router::grant);
+      itf->set_dmi_invalidate_meth(&router::dmi_invalidate);
       new_master_port(mapping.first, itf);
 
       if (mapping.first == "error")
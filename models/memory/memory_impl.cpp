@@ -36,6 +36,8 @@ public:
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
 
+  static bool dmi_req(void *__this, vp::io_dmi *dmi, uint64_t addr);
+
 private:
 
   static void power_callback(void *__this, vp::clock_event *event);
@@ -50,6 +52,9 @@ private:
   uint8_t *mem_data;
   uint8_t *check_mem;
 
+  // Notifies the masters caching the content of the memory when it is written
+  vp::io_dmi_watch *dmi_watch = NULL;
+
   int64_t next_packet_start;
 
   bool power_trigger; 
@@ -93,8 +98,9 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
 
   _this->trace.msg("Memory access (offset: 0x%x, size: 0x%x, is_write: %d)\n", offset, size, req->get_is_write());
 
-  // Impact the memory bandwith on the packet
-  if (_this->width_bits != 0) {
+  // Impact the memory bandwith on the packet. Debug accesses, e.g. from the
+  // GDB server, are not seen by the simulated platform.
+  if (_this->width_bits != 0 && !req->is_debug()) {
 #define MAX(a,b) (((a)>(b))?(a):(b))
     int duration = MAX(size >> _this->width_bits, 1);
     req->set_duration(duration);
@@ -112,7 +118,7 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
     return vp::IO_REQ_INVALID;
   }
 
-  if (_this->power_trace.get_active())
+  if (_this->power_trace.get_active() && !req->is_debug())
   {
     _this->last_access_timestamp = _this->get_time();
 
@@ -164,6 +170,8 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
       }
     }
     memcpy((void *)&_this->mem_data[offset], (void *)data, size);
+    if (_this->dmi_watch)
+      _this->dmi_watch->write(&_this->mem_data[offset], size);
   } else {
     if (_this->check_mem) {
       for (unsigned int i=0; i<size; i++) {
@@ -180,6 +188,34 @@ vp::io_req_status_e memory::req(void *__this, vp::io_req *req)
   return vp::IO_REQ_OK;
 }
 
+bool memory::dmi_req(void *__this, vp::io_dmi *dmi, uint64_t addr)
+{
+  memory *_this = (memory *)__this;
+
+  // Direct accesses are not seen by the memory, so they can only be granted
+  // if the bandwidth, the power and the uninitialized accesses are not
+  // modeled, and if the accesses are not traced.
+  if (_this->width_bits != 0 || _this->check_mem || _this->power_trigger ||
+    _this->power_trace.get_active() || _this->trace.get_active() || addr >= _this->size)
+  {
+    return false;
+  }
+
+  dmi->base = 0;
+  dmi->size = _this->size;
+  dmi->data = _this->mem_data;
+  dmi->latency = 0;
+
+  if (_this->dmi_watch == NULL)
+  {
+    _this->dmi_watch = new vp::io_dmi_watch(_this->mem_data, _this->size);
+    _this->in.set_dmi_watch(_this->dmi_watch);
+  }
+  dmi->watch_desc = _this->dmi_watch;
+
+  return true;
+}
+
 void memory::reset(bool active)
 {
   if (active)
@@ -192,6 +228,7 @@ int memory::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
   in.set_req_meth(&memory::req);
+  in.set_dmi_meth(&memory::dmi_req);
   new_slave_port("input", &in);
 
   js::config *config = get_js_config()->get("power_trigger");
@@ -210,6 +247,12 @@ int memory::build()
 
   power_event = this->event_new(memory::power_callback);
 
+  // Direct accesses already granted would bypass the traces and the power
+  // model once they are enabled, and can be granted again once they are
+  // disabled, so they are revoked in both cases
+  this->trace.reg_callback([this]() { this->in.dmi_invalidate(); });
+  this->power_trace.trace.reg_callback([this]() { this->in.dmi_invalidate(); });
+
   return 0;
 }
 
@@ -219,6 +262,13 @@ void memory::start()
   check = get_config_bool("check");
   width_bits = get_config_int("width_bits");
 
+  // The bandwidth is not modeled in functional mode, which also allows
+  // direct accesses
+  if (this->get_functional())
+  {
+    width_bits = 0;
+  }
+
   trace.msg("Building memory (size: 0x%x, check: %d)\n", size, check);
 
   mem_data = new uint8_t[size];
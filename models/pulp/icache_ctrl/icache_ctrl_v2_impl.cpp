@@ -14,15 +14,48 @@
  * limitations under the License.
  */
 
-/* 
+/*
  * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
  */
 
+// Instruction cache and its controller. The cache is set-associative and
+// either shared by all the cores or private to each of them. Only the tags
+// are modeled, the instructions are still fetched by the cores through
+// their fetch port, and this model only gives the timing of the fetches.
+//
+// A core accesses the cache through its fetch_<id> port when it executes an
+// instruction whose line it does not hold. On a miss, the line is refilled
+// through the refill port and the core is stalled for the latency of the
+// refill. The core then holds the line and executes its instructions
+// without accessing the cache, which makes the hits free, until the line is
+// evicted, which is notified to the core through its evict_<id> port.
+// As the hits are not seen, the replacement is pseudo-random like in the
+// hardware, so that it does not depend on them, and the hit counter only
+// counts the first access of a core to a line already in the cache.
+//
+// The input port gives access to the registers of the controller.
+
 #include <vp/vp.hpp>
 #include <vp/itf/io.hpp>
 #include <stdio.h>
 #include <string.h>
 
+#define ICACHE_CTRL_ENABLE        0x00    // Enable (1) or disable (0) the cache
+#define ICACHE_CTRL_FLUSH         0x04    // Write to invalidate all the lines
+#define ICACHE_CTRL_SEL_FLUSH     0x08    // Write an address to invalidate its line
+#define ICACHE_CTRL_CNT_CLEAR     0x0C    // Write to clear the counters
+#define ICACHE_CTRL_HIT_COUNT     0x10    // Number of hits
+#define ICACHE_CTRL_MISS_COUNT    0x14    // Number of misses
+
+#define ICACHE_MAX_CORES 64
+
+typedef struct
+{
+  uint64_t tag;       // Line address, i.e. address shifted by the line size
+  bool valid;
+  uint64_t holders;   // Cores holding the line, which must be notified when it is evicted
+} icache_line_t;
+
 class icache_ctrl : public vp::component
 {
 
@@ -32,13 +65,49 @@ public:
 
   int build();
   void start();
+  void reset(bool active);
 
   static vp::io_req_status_e req(void *__this, vp::io_req *req);
+  static vp::io_req_status_e fetch_req(void *__this, vp::io_req *req, int id);
 
 private:
 
+  int64_t refill(uint64_t addr);
+  void evict(icache_line_t *line);
+  void flush();
+  void flush_line(uint64_t addr);
+  void set_enable(bool enabled);
+  void update_counters();
+
   vp::trace     trace;
-  vp::io_slave in;
+  vp::trace     hits_event;
+  vp::trace     misses_event;
+
+  vp::io_slave  in;
+  vp::io_slave  *fetch_itf;
+  vp::io_master *evict_itf;
+  vp::io_master refill_itf;
+
+  vp::io_req    refill_req;
+  uint8_t       *refill_data;
+  vp::io_req    evict_req;
+
+  int nb_cores;
+  bool shared;
+  int nb_sets;
+  int nb_ways;
+  int line_size_bits;
+  int64_t refill_latency;    // Added to the latency of the refill requests
+
+  // One array of nb_sets*nb_ways lines if the cache is shared, one per core
+  // otherwise
+  icache_line_t **caches;
+  int nb_caches;
+
+  bool enabled;
+  uint32_t lfsr;
+  uint32_t hits;
+  uint32_t misses;
 };
 
 icache_ctrl::icache_ctrl(const char *config)
@@ -47,6 +116,186 @@ icache_ctrl::icache_ctrl(const char *config)
 
 }
 
+void icache_ctrl::update_counters()
+{
+  this->hits_event.event((uint8_t *)&this->hits);
+  this->misses_event.event((uint8_t *)&this->misses);
+}
+
+// Returns the latency of the refill of the line containing the address
+int64_t icache_ctrl::refill(uint64_t addr)
+{
+  int64_t latency = this->refill_latency;
+
+  if (this->refill_itf.is_bound())
+  {
+    vp::io_req *req = &this->refill_req;
+    req->init();
+    req->set_addr(addr);
+    req->set_size(1 << this->line_size_bits);
+    req->set_is_write(false);
+    req->set_data(this->refill_data);
+
+    if (this->refill_itf.req(req) != vp::IO_REQ_OK)
+    {
+      this->warning.force_warning("Unimplemented failed refill request (addr: 0x%lx)\n", addr);
+    }
+    else
+    {
+      latency += req->get_latency();
+    }
+  }
+
+  return latency;
+}
+
+// Tell the cores holding the line that they must go through the cache again
+// to execute its instructions
+void icache_ctrl::evict(icache_line_t *line)
+{
+  uint64_t addr = line->tag << this->line_size_bits;
+
+  this->trace.msg("Evicting line (addr: 0x%lx, holders: 0x%lx)\n", addr, line->holders);
+
+  for (int i=0; line->holders; i++)
+  {
+    if (line->holders & (1ULL << i))
+    {
+      line->holders &= ~(1ULL << i);
+
+      if (!this->evict_itf[i].is_bound())
+        continue;
+
+      vp::io_req *req = &this->evict_req;
+      req->init();
+      req->set_addr(addr);
+      req->set_size(1 << this->line_size_bits);
+      req->set_is_write(false);
+      req->set_data(NULL);
+      this->evict_itf[i].req(req);
+    }
+  }
+
+  line->valid = false;
+}
+
+void icache_ctrl::flush()
+{
+  this->trace.msg("Flushing cache\n");
+
+  for (int i=0; i<this->nb_caches; i++)
+  {
+    for (int j=0; j<this->nb_sets * this->nb_ways; j++)
+    {
+      icache_line_t *line = &this->caches[i][j];
+      if (line->valid)
+        this->evict(line);
+    }
+  }
+}
+
+void icache_ctrl::flush_line(uint64_t addr)
+{
+  uint64_t tag = addr >> this->line_size_bits;
+  int set = tag & (this->nb_sets - 1);
+
+  this->trace.msg("Flushing line (addr: 0x%lx)\n", addr);
+
+  for (int i=0; i<this->nb_caches; i++)
+  {
+    icache_line_t *lines = &this->caches[i][set * this->nb_ways];
+    for (int j=0; j<this->nb_ways; j++)
+    {
+      if (lines[j].valid && lines[j].tag == tag)
+        this->evict(&lines[j]);
+    }
+  }
+}
+
+void icache_ctrl::set_enable(bool enabled)
+{
+  this->trace.msg("Setting enable (value: %d)\n", enabled);
+
+  // The cores must not keep any line while the cache is disabled, as all
+  // their fetches then go to the refill port
+  if (!enabled)
+    this->flush();
+
+  this->enabled = enabled;
+}
+
+vp::io_req_status_e icache_ctrl::fetch_req(void *__this, vp::io_req *req, int id)
+{
+  icache_ctrl *_this = (icache_ctrl *)__this;
+  uint64_t addr = req->get_addr();
+  uint64_t tag = addr >> _this->line_size_bits;
+  uint64_t line_end = (tag + 1) << _this->line_size_bits;
+
+  // The core does not hold anything when the cache is disabled, so that it
+  // comes back for each instruction
+  if (!_this->enabled)
+  {
+    req->inc_latency(_this->refill(addr));
+    return vp::IO_REQ_OK;
+  }
+
+  icache_line_t *lines = &_this->caches[_this->shared ? 0 : id][(tag & (_this->nb_sets - 1)) * _this->nb_ways];
+
+  for (int i=0; i<_this->nb_ways; i++)
+  {
+    icache_line_t *line = &lines[i];
+    if (line->valid && line->tag == tag)
+    {
+      // Only the first access of a core is counted, the next ones are the
+      // other instructions of the line which this core already holds
+      if ((line->holders & (1ULL << id)) == 0)
+      {
+        _this->trace.msg("Hit (core: %d, addr: 0x%lx)\n", id, addr);
+        line->holders |= 1ULL << id;
+        _this->hits++;
+        _this->update_counters();
+      }
+
+      req->set_actual_size(line_end - addr);
+      return vp::IO_REQ_OK;
+    }
+  }
+
+  _this->trace.msg("Miss (core: %d, addr: 0x%lx)\n", id, addr);
+
+  // Take an invalid way if any, otherwise a random one with a 16 bits LFSR
+  int way = -1;
+  for (int i=0; i<_this->nb_ways; i++)
+  {
+    if (!lines[i].valid)
+    {
+      way = i;
+      break;
+    }
+  }
+
+  if (way == -1)
+  {
+    uint32_t bit = ((_this->lfsr >> 0) ^ (_this->lfsr >> 2) ^ (_this->lfsr >> 3) ^ (_this->lfsr >> 5)) & 1;
+    _this->lfsr = (_this->lfsr >> 1) | (bit << 15);
+    way = _this->lfsr % _this->nb_ways;
+    _this->evict(&lines[way]);
+  }
+
+  icache_line_t *line = &lines[way];
+  line->valid = true;
+  line->tag = tag;
+  line->holders = 1ULL << id;
+
+  _this->misses++;
+  _this->update_counters();
+
+  req->inc_latency(_this->refill(tag << _this->line_size_bits));
+  req->set_actual_size(line_end - addr);
+
+  return vp::IO_REQ_OK;
+}
+
 vp::io_req_status_e icache_ctrl::req(void *__this, vp::io_req *req)
 {
   icache_ctrl *_this = (icache_ctrl *)__this;
@@ -58,15 +307,119 @@ vp::io_req_status_e icache_ctrl::req(void *__this, vp::io_req *req)
 
   _this->trace.msg("icache_ctrl access (offset: 0x%x, size: 0x%x, is_write: %d)\n", offset, size, is_write);
 
+  if (size != 4)
+  {
+    _this->warning.force_warning("Invalid access size (offset: 0x%x, size: 0x%x)\n", offset, size);
+    return vp::IO_REQ_INVALID;
+  }
+
+  uint32_t *value = (uint32_t *)data;
+
+  switch (offset)
+  {
+    case ICACHE_CTRL_ENABLE:
+      if (is_write)
+        _this->set_enable(*value & 1);
+      else
+        *value = _this->enabled;
+      break;
+
+    case ICACHE_CTRL_FLUSH:
+      if (is_write)
+        _this->flush();
+      else
+        *value = 0;
+      break;
+
+    case ICACHE_CTRL_SEL_FLUSH:
+      if (is_write)
+        _this->flush_line(*value);
+      else
+        *value = 0;
+      break;
+
+    case ICACHE_CTRL_CNT_CLEAR:
+      if (is_write)
+      {
+        _this->hits = 0;
+        _this->misses = 0;
+        _this->update_counters();
+      }
+      else
+        *value = 0;
+      break;
+
+    case ICACHE_CTRL_HIT_COUNT:
+      if (!is_write)
+        *value = _this->hits;
+      break;
+
+    case ICACHE_CTRL_MISS_COUNT:
+      if (!is_write)
+        *value = _this->misses;
+      break;
+
+    default:
+      _this->warning.force_warning("Invalid access (offset: 0x%x, size: 0x%x, is_write: %d)\n", offset, size, is_write);
+      return vp::IO_REQ_INVALID;
+  }
+
   return vp::IO_REQ_OK;
 }
 
 int icache_ctrl::build()
 {
   traces.new_trace("trace", &trace, vp::DEBUG);
+  traces.new_trace_event("hits", &hits_event, 32);
+  traces.new_trace_event("misses", &misses_event, 32);
+
   in.set_req_meth(&icache_ctrl::req);
   new_slave_port("input", &in);
 
+  new_master_port("refill", &refill_itf);
+
+  js::config *conf = this->get_js_config();
+
+  this->nb_cores = conf->get("nb_cores") ? conf->get("nb_cores")->get_int() : 1;
+  this->shared = conf->get("shared") == NULL || conf->get("shared")->get_bool();
+  int size = conf->get("size") ? conf->get("size")->get_int() : 4096;
+  this->nb_ways = conf->get("nb_ways") ? conf->get("nb_ways")->get_int() : 4;
+  int line_size = conf->get("line_size") ? conf->get("line_size")->get_int() : 16;
+  this->refill_latency = conf->get("refill_latency") ? conf->get("refill_latency")->get_int() : 0;
+  this->enabled = conf->get("enabled") == NULL || conf->get("enabled")->get_bool();
+
+  this->line_size_bits = 0;
+  while ((1 << this->line_size_bits) < line_size)
+    this->line_size_bits++;
+
+  this->nb_sets = this->nb_ways > 0 ? size / line_size / this->nb_ways : 0;
+
+  if (this->nb_cores < 1 || this->nb_cores > ICACHE_MAX_CORES || this->nb_ways < 1 ||
+    (1 << this->line_size_bits) != line_size || this->nb_sets < 1 || (this->nb_sets & (this->nb_sets - 1)))
+  {
+    snprintf(vp_error, VP_ERROR_SIZE, "Invalid icache configuration (nb_cores: %d, size: %d, nb_ways: %d, line_size: %d)",
+      this->nb_cores, size, this->nb_ways, line_size);
+    return -1;
+  }
+
+  this->fetch_itf = new vp::io_slave[this->nb_cores];
+  this->evict_itf = new vp::io_master[this->nb_cores];
+  for (int i=0; i<this->nb_cores; i++)
+  {
+    this->fetch_itf[i].set_req_meth_muxed(&icache_ctrl::fetch_req, i);
+    new_slave_port("fetch_" + std::to_string(i), &this->fetch_itf[i]);
+    new_master_port("evict_" + std::to_string(i), &this->evict_itf[i]);
+  }
+
+  this->nb_caches = this->shared ? 1 : this->nb_cores;
+  this->caches = new icache_line_t *[this->nb_caches];
+  for (int i=0; i<this->nb_caches; i++)
+  {
+    this->caches[i] = new icache_line_t[this->nb_sets * this->nb_ways];
+  }
+
+  this->refill_data = new uint8_t[line_size];
+
   return 0;
 }
 
@@ -74,6 +427,22 @@ void icache_ctrl::start()
 {
 }
 
+void icache_ctrl::reset(bool active)
+{
+  if (active)
+  {
+    for (int i=0; i<this->nb_caches; i++)
+    {
+      memset(this->caches[i], 0, sizeof(icache_line_t) * this->nb_sets * this->nb_ways);
+    }
+
+    this->enabled = this->get_js_config()->get("enabled") == NULL || this->get_js_config()->get("enabled")->get_bool();
+    this->lfsr = 0xACE1;
+    this->hits = 0;
+    this->misses = 0;
+  }
+}
+
 extern "C" void *vp_constructor(const char *config)
 {
   return (void *)new icache_ctrl(config);
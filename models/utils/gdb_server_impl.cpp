@@ -0,0 +1,1009 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// GDB remote serial protocol server. Cores register themselves through the
+// "gdbserver" service and are then seen by GDB as threads. The server runs
+// in its own thread and accesses the cores with the time engine locked, so
+// that GDB directly talks to the simulated cores instead of going through
+// the JTAG debug unit.
+// The server works in all-stop mode: when a core stops, all the other ones
+// are stopped too, and continuing resumes all of them. Single-stepping only
+// steps the selected core while the other ones stay stopped.
+
+#include <vp/vp.hpp>
+#include <vp/gdbserver/gdbserver_engine.hpp>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define GDB_SERVER_PACKET_SIZE 0x4000
+
+#define GDB_SIGNAL_INT  2
+#define GDB_SIGNAL_TRAP 5
+
+class gdb_server : public vp::component, public vp::gdbserver_engine
+{
+
+public:
+
+  gdb_server(const char *config);
+
+  int build();
+  void start();
+  void stop();
+
+  int register_core(vp::gdbserver_core *core);
+  void signal(vp::gdbserver_core *core);
+
+private:
+
+  int open_socket();
+  void server_routine();
+  void client_routine();
+
+  int get_char(int timeout=-1);
+  bool get_packet(std::string &packet);
+  bool send_packet(std::string packet);
+  bool send_stop_reply(int signal, vp::gdbserver_core *core);
+  bool send_exit_reply();
+
+  bool handle_packet(std::string &packet);
+  bool handle_query(std::string &packet);
+  bool handle_vcont(std::string &packet);
+  bool handle_regs_read();
+  bool handle_regs_write(std::string &packet);
+  bool handle_reg_read(std::string &packet);
+  bool handle_reg_write(std::string &packet);
+  bool handle_mem_read(std::string &packet);
+  bool handle_mem_write(std::string &packet, bool binary);
+  bool handle_breakpoint(std::string &packet, bool insert);
+  bool handle_thread_select(std::string &packet);
+
+  bool resume(vp::gdbserver_core *step_core);
+  void stop_all();
+
+  vp::gdbserver_core *get_core(int tid);
+  int get_tid(vp::gdbserver_core *core);
+
+  vp::trace trace;
+
+  int port;
+  std::string socket_path;
+  int socket_fd;
+  int client_fd;
+  bool no_ack;
+
+  // Pipe used by the cores to wake up the server when one of them stops, or
+  // when the simulation is over
+  int wakeup_fds[2];
+
+  std::mutex mutex;
+  bool waiting_stop;
+  vp::gdbserver_core *stopped_core;
+
+  // Set when the simulation is over, GDB is then sent the exit status and
+  // the simulation waits until it is sent before exiting
+  bool connected;
+  bool finished;
+  bool exit_sent;
+  int exit_status;
+  std::condition_variable exit_cond;
+
+  std::vector<vp::gdbserver_core *> cores;
+  vp::gdbserver_core *current_core;    // Selected by GDB for register and memory accesses
+
+  char in_buffer[4096];
+  int in_buffer_index;
+  int in_buffer_size;
+};
+
+
+
+static int hex_to_int(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+static std::string bytes_to_hex(uint8_t *data, int size)
+{
+  static const char *digits = "0123456789abcdef";
+  std::string result;
+  for (int i=0; i<size; i++)
+  {
+    result += digits[data[i] >> 4];
+    result += digits[data[i] & 0xf];
+  }
+  return result;
+}
+
+static bool hex_to_bytes(const char *hex, int size, uint8_t *data)
+{
+  for (int i=0; i<size; i++)
+  {
+    int high = hex_to_int(hex[2*i]);
+    int low = high < 0 ? -1 : hex_to_int(hex[2*i+1]);
+    if (low < 0)
+      return false;
+    data[i] = (high << 4) | low;
+  }
+  return true;
+}
+
+
+
+gdb_server::gdb_server(const char *config)
+: vp::component(config)
+{
+}
+
+int gdb_server::register_core(vp::gdbserver_core *core)
+{
+  this->trace.msg("Registering core (id: %d, name: %s)\n", core->gdbserver_get_id(), core->gdbserver_get_name().c_str());
+
+  // Threads are numbered from the core IDs, whatever the order the cores
+  // are started in
+  this->cores.push_back(core);
+  std::sort(this->cores.begin(), this->cores.end(), [](vp::gdbserver_core *a, vp::gdbserver_core *b) {
+    return a->gdbserver_get_id() < b->gdbserver_get_id();
+  });
+
+  return 0;
+}
+
+void gdb_server::signal(vp::gdbserver_core *core)
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  // Only the first core which stops is reported, the other ones are then
+  // stopped by the server
+  if (this->waiting_stop && this->stopped_core == NULL)
+  {
+    this->trace.msg("Core stopped (id: %d)\n", core->gdbserver_get_id());
+    this->stopped_core = core;
+    char c = 0;
+    if (write(this->wakeup_fds[1], &c, 1) != 1) {}
+  }
+}
+
+vp::gdbserver_core *gdb_server::get_core(int tid)
+{
+  if (tid <= 0 || tid > (int)this->cores.size())
+    return NULL;
+  return this->cores[tid - 1];
+}
+
+int gdb_server::get_tid(vp::gdbserver_core *core)
+{
+  for (unsigned int i=0; i<this->cores.size(); i++)
+  {
+    if (this->cores[i] == core)
+      return i + 1;
+  }
+  return 0;
+}
+
+
+
+int gdb_server::get_char(int timeout)
+{
+  if (this->in_buffer_index == this->in_buffer_size)
+  {
+    // The wait is also interrupted when the simulation is over
+    while (1)
+    {
+      struct pollfd fds[2] = {
+        { .fd=this->client_fd, .events=POLLIN, .revents=0 },
+        { .fd=this->wakeup_fds[0], .events=POLLIN, .revents=0 },
+      };
+      int result = poll(fds, 2, timeout);
+      if (result == 0 || (result < 0 && errno != EINTR))
+        return -1;
+
+      std::unique_lock<std::mutex> lock(this->mutex);
+      if (this->finished)
+        return -1;
+
+      // A core may have stopped just after GDB interrupted the execution
+      if (fds[1].revents & POLLIN)
+      {
+        char c;
+        if (read(this->wakeup_fds[0], &c, 1) != 1) {}
+      }
+
+      if (fds[0].revents)
+        break;
+    }
+
+    int size = read(this->client_fd, this->in_buffer, sizeof(this->in_buffer));
+    if (size <= 0)
+      return -1;
+
+    this->in_buffer_index = 0;
+    this->in_buffer_size = size;
+  }
+
+  return (uint8_t)this->in_buffer[this->in_buffer_index++];
+}
+
+// Wait for the next packet. Interrupts received outside a packet are
+// returned as a packet made of the interrupt character.
+bool gdb_server::get_packet(std::string &packet)
+{
+  while (1)
+  {
+    int c = this->get_char();
+    if (c < 0)
+      return false;
+
+    if (c == 0x03)
+    {
+      packet = "\x03";
+      return true;
+    }
+
+    if (c != '$')
+      continue;
+
+    packet.clear();
+    uint8_t checksum = 0;
+    while (1)
+    {
+      c = this->get_char();
+      if (c < 0)
+        return false;
+      if (c == '#')
+        break;
+      packet += (char)c;
+      checksum += c;
+    }
+
+    int high = hex_to_int(this->get_char());
+    int low = hex_to_int(this->get_char());
+
+    if (this->no_ack)
+      return true;
+
+    if (high < 0 || low < 0 || ((high << 4) | low) != checksum)
+    {
+      this->trace.msg("Received packet with wrong checksum\n");
+      if (write(this->client_fd, "-", 1) != 1)
+        return false;
+      continue;
+    }
+
+    if (write(this->client_fd, "+", 1) != 1)
+      return false;
+
+    return true;
+  }
+}
+
+bool gdb_server::send_packet(std::string packet)
+{
+  uint8_t checksum = 0;
+  for (char c: packet)
+  {
+    checksum += c;
+  }
+
+  char suffix[4];
+  snprintf(suffix, 4, "#%2.2x", checksum);
+  std::string data = "$" + packet + suffix;
+
+  this->trace.msg("Sending packet (packet: %s)\n", packet.c_str());
+
+  while (1)
+  {
+    if (write(this->client_fd, data.c_str(), data.size()) != (ssize_t)data.size())
+      return false;
+
+    if (this->no_ack)
+      return true;
+
+    int c = this->get_char();
+    if (c < 0)
+      return false;
+    if (c == '+')
+      return true;
+  }
+}
+
+bool gdb_server::send_stop_reply(int signal, vp::gdbserver_core *core)
+{
+  char reply[64];
+  snprintf(reply, 64, "T%2.2xthread:%x;", signal, this->get_tid(core));
+  return this->send_packet(reply);
+}
+
+// Tell GDB that the simulation is over, which also ends the connection
+bool gdb_server::send_exit_reply()
+{
+  char reply[16];
+  snprintf(reply, 16, "W%2.2x", this->exit_status & 0xff);
+
+  // The acknowledge can not be received anymore as the simulation is over
+  this->no_ack = true;
+  this->send_packet(reply);
+
+  std::unique_lock<std::mutex> lock(this->mutex);
+  this->exit_sent = true;
+  this->exit_cond.notify_all();
+
+  return false;
+}
+
+
+
+void gdb_server::stop_all()
+{
+  for (auto core: this->cores)
+  {
+    if (!core->gdbserver_is_halted())
+      core->gdbserver_stop();
+  }
+}
+
+// Resume the cores, or only step the specified one, and wait until a core
+// stops or GDB interrupts the execution
+bool gdb_server::resume(vp::gdbserver_core *step_core)
+{
+  vp::time_engine *engine = this->get_time_engine();
+
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->waiting_stop = true;
+    this->stopped_core = NULL;
+  }
+
+  engine->lock();
+  if (step_core)
+  {
+    step_core->gdbserver_stepi();
+  }
+  else
+  {
+    for (auto core: this->cores)
+    {
+      core->gdbserver_cont();
+    }
+  }
+  engine->unlock();
+
+  int signal = GDB_SIGNAL_TRAP;
+  vp::gdbserver_core *core = NULL;
+
+  while (core == NULL)
+  {
+    struct pollfd fds[2] = {
+      { .fd=this->wakeup_fds[0], .events=POLLIN, .revents=0 },
+      { .fd=this->client_fd, .events=POLLIN, .revents=0 },
+    };
+
+    // Data already received from GDB must be checked before waiting
+    if (this->in_buffer_index == this->in_buffer_size)
+    {
+      if (poll(fds, 2, -1) < 0 && errno != EINTR)
+        return false;
+    }
+    else
+    {
+      fds[1].revents = POLLIN;
+    }
+
+    if (fds[0].revents & POLLIN)
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      if (this->finished)
+      {
+        lock.unlock();
+        return this->send_exit_reply();
+      }
+
+      char c;
+      if (read(this->wakeup_fds[0], &c, 1) != 1) {}
+      core = this->stopped_core;
+    }
+    else if (fds[1].revents & (POLLIN | POLLHUP | POLLERR))
+    {
+      int c = this->get_char();
+      if (c < 0)
+        return false;
+
+      if (c == 0x03)
+      {
+        this->trace.msg("Received interrupt\n");
+        signal = GDB_SIGNAL_INT;
+        core = this->current_core;
+      }
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->waiting_stop = false;
+  }
+
+  engine->lock();
+  this->stop_all();
+  engine->unlock();
+
+  this->current_core = core;
+
+  return this->send_stop_reply(signal, core);
+}
+
+
+
+bool gdb_server::handle_regs_read()
+{
+  vp::gdbserver_core *core = this->current_core;
+  int reg_size = core->gdbserver_get_reg_size();
+  uint8_t value[reg_size];
+  std::string reply;
+
+  this->get_time_engine()->lock();
+  for (int i=0; i<core->gdbserver_get_nb_regs(); i++)
+  {
+    if (core->gdbserver_reg_get(i, value))
+    {
+      // Unavailable register
+      reply += std::string(reg_size * 2, 'x');
+    }
+    else
+    {
+      reply += bytes_to_hex(value, reg_size);
+    }
+  }
+  this->get_time_engine()->unlock();
+
+  return this->send_packet(reply);
+}
+
+bool gdb_server::handle_regs_write(std::string &packet)
+{
+  vp::gdbserver_core *core = this->current_core;
+  int reg_size = core->gdbserver_get_reg_size();
+  int nb_regs = std::min((int)(packet.size() - 1) / (reg_size * 2), core->gdbserver_get_nb_regs());
+  uint8_t value[reg_size];
+  int err = 0;
+
+  this->get_time_engine()->lock();
+  for (int i=0; i<nb_regs; i++)
+  {
+    if (!hex_to_bytes(&packet[1 + i * reg_size * 2], reg_size, value) || core->gdbserver_reg_set(i, value))
+      err = 1;
+  }
+  this->get_time_engine()->unlock();
+
+  return this->send_packet(err ? "E01" : "OK");
+}
+
+bool gdb_server::handle_reg_read(std::string &packet)
+{
+  vp::gdbserver_core *core = this->current_core;
+  int reg_size = core->gdbserver_get_reg_size();
+  uint8_t value[reg_size];
+  int reg = strtol(&packet[1], NULL, 16);
+
+  this->get_time_engine()->lock();
+  int err = core->gdbserver_reg_get(reg, value);
+  this->get_time_engine()->unlock();
+
+  return this->send_packet(err ? "E01" : bytes_to_hex(value, reg_size));
+}
+
+bool gdb_server::handle_reg_write(std::string &packet)
+{
+  vp::gdbserver_core *core = this->current_core;
+  int reg_size = core->gdbserver_get_reg_size();
+  uint8_t value[reg_size];
+  char *end;
+  int reg = strtol(&packet[1], &end, 16);
+
+  if (*end != '=' || strlen(end + 1) < (size_t)reg_size * 2 || !hex_to_bytes(end + 1, reg_size, value))
+    return this->send_packet("E01");
+
+  this->get_time_engine()->lock();
+  int err = core->gdbserver_reg_set(reg, value);
+  this->get_time_engine()->unlock();
+
+  return this->send_packet(err ? "E01" : "OK");
+}
+
+bool gdb_server::handle_mem_read(std::string &packet)
+{
+  char *end;
+  uint64_t addr = strtoull(&packet[1], &end, 16);
+  if (*end != ',')
+    return this->send_packet("E01");
+  int size = std::min(strtol(end + 1, NULL, 16), (long)GDB_SERVER_PACKET_SIZE / 2);
+
+  std::vector<uint8_t> data(size);
+
+  this->get_time_engine()->lock();
+  int err = this->current_core->gdbserver_mem_access(addr, size, data.data(), false);
+  this->get_time_engine()->unlock();
+
+  return this->send_packet(err ? "E01" : bytes_to_hex(data.data(), size));
+}
+
+bool gdb_server::handle_mem_write(std::string &packet, bool binary)
+{
+  char *end;
+  uint64_t addr = strtoull(&packet[1], &end, 16);
+  if (*end != ',')
+    return this->send_packet("E01");
+  int size = strtol(end + 1, &end, 16);
+  if (*end != ':')
+    return this->send_packet("E01");
+
+  const char *payload = end + 1;
+  int payload_size = packet.size() - (payload - packet.c_str());
+  std::vector<uint8_t> data(size);
+
+  if (binary)
+  {
+    int index = 0;
+    for (int i=0; i<payload_size && index < size; i++)
+    {
+      if (payload[i] == 0x7d && i + 1 < payload_size)
+        data[index++] = payload[++i] ^ 0x20;
+      else
+        data[index++] = payload[i];
+    }
+    if (index != size)
+      return this->send_packet("E01");
+  }
+  else
+  {
+    if (payload_size < size * 2 || !hex_to_bytes(payload, size, data.data()))
+      return this->send_packet("E01");
+  }
+
+  int err = 0;
+  if (size > 0)
+  {
+    this->get_time_engine()->lock();
+    err = this->current_core->gdbserver_mem_access(addr, size, data.data(), true);
+    this->get_time_engine()->unlock();
+  }
+
+  return this->send_packet(err ? "E01" : "OK");
+}
+
+// Breakpoints are set on all cores, as they share the code
+bool gdb_server::handle_breakpoint(std::string &packet, bool insert)
+{
+  // Only software and hardware breakpoints are supported, not watchpoints
+  if (packet[1] != '0' && packet[1] != '1')
+    return this->send_packet("");
+
+  uint64_t addr = strtoull(&packet[3], NULL, 16);
+  int err = 0;
+
+  this->get_time_engine()->lock();
+  for (auto core: this->cores)
+  {
+    if (insert)
+      err |= core->gdbserver_breakpoint_insert(addr);
+    else
+      err |= core->gdbserver_breakpoint_remove(addr);
+  }
+  this->get_time_engine()->unlock();
+
+  return this->send_packet(err ? "E01" : "OK");
+}
+
+bool gdb_server::handle_thread_select(std::string &packet)
+{
+  // Only the thread used for register and memory accesses matters, as
+  // continuing always resumes all cores
+  if (packet[1] == 'g')
+  {
+    int tid = strtol(&packet[2], NULL, 16);
+    if (tid > 0)
+    {
+      vp::gdbserver_core *core = this->get_core(tid);
+      if (core == NULL)
+        return this->send_packet("E01");
+      this->current_core = core;
+    }
+  }
+  return this->send_packet("OK");
+}
+
+bool gdb_server::handle_vcont(std::string &packet)
+{
+  if (packet == "vCont?")
+    return this->send_packet("vCont;c;C;s;S");
+
+  // Actions are separated by ';' and are applied to the thread after ':'
+  // or to all the threads if there is none. A step action has priority over
+  // the continue actions as only one core is stepped at a time.
+  vp::gdbserver_core *step_core = NULL;
+  size_t pos = 5;
+  while (pos < packet.size() && packet[pos] == ';')
+  {
+    size_t next = packet.find(';', pos + 1);
+    std::string action = packet.substr(pos + 1, next == std::string::npos ? std::string::npos : next - pos - 1);
+
+    if (action[0] == 's' || action[0] == 'S')
+    {
+      size_t colon = action.find(':');
+      vp::gdbserver_core *core = colon == std::string::npos ? this->current_core :
+        this->get_core(strtol(action.c_str() + colon + 1, NULL, 16));
+      if (core && step_core == NULL)
+        step_core = core;
+    }
+
+    pos = next == std::string::npos ? packet.size() : next;
+  }
+
+  if (step_core)
+    this->current_core = step_core;
+
+  return this->resume(step_core);
+}
+
+bool gdb_server::handle_query(std::string &packet)
+{
+  if (packet.compare(0, 10, "qSupported") == 0)
+  {
+    char reply[128];
+    snprintf(reply, 128, "PacketSize=%x;QStartNoAckMode+;vContSupported+", GDB_SERVER_PACKET_SIZE);
+    return this->send_packet(reply);
+  }
+  else if (packet == "QStartNoAckMode")
+  {
+    bool result = this->send_packet("OK");
+    this->no_ack = true;
+    return result;
+  }
+  else if (packet == "qfThreadInfo")
+  {
+    std::string reply = "m";
+    for (unsigned int i=0; i<this->cores.size(); i++)
+    {
+      char tid[16];
+      snprintf(tid, 16, i == 0 ? "%x" : ",%x", i + 1);
+      reply += tid;
+    }
+    return this->send_packet(reply);
+  }
+  else if (packet == "qsThreadInfo")
+  {
+    return this->send_packet("l");
+  }
+  else if (packet == "qC")
+  {
+    char reply[32];
+    snprintf(reply, 32, "QC%x", this->get_tid(this->current_core));
+    return this->send_packet(reply);
+  }
+  else if (packet.compare(0, 17, "qThreadExtraInfo,") == 0)
+  {
+    vp::gdbserver_core *core = this->get_core(strtol(&packet[17], NULL, 16));
+    if (core == NULL)
+      return this->send_packet("E01");
+    std::string name = core->gdbserver_get_name();
+    return this->send_packet(bytes_to_hex((uint8_t *)name.c_str(), name.size()));
+  }
+  else if (packet == "qAttached")
+  {
+    return this->send_packet("1");
+  }
+  else if (packet.compare(0, 7, "qSymbol") == 0)
+  {
+    return this->send_packet("OK");
+  }
+
+  return this->send_packet("");
+}
+
+// Returns false when the connection with GDB is over
+bool gdb_server::handle_packet(std::string &packet)
+{
+  this->trace.msg("Received packet (packet: %s)\n", packet[0] == 'X' ? "X..." : packet.c_str());
+
+  switch (packet[0])
+  {
+    case 0x03:
+      // Interrupt received while the cores are already stopped
+      return this->send_stop_reply(GDB_SIGNAL_INT, this->current_core);
+
+    case '?':
+      return this->send_stop_reply(GDB_SIGNAL_TRAP, this->current_core);
+
+    case 'q':
+    case 'Q':
+      return this->handle_query(packet);
+
+    case 'H':
+      return this->handle_thread_select(packet);
+
+    case 'T':
+      return this->send_packet(this->get_core(strtol(&packet[1], NULL, 16)) ? "OK" : "E01");
+
+    case 'g':
+      return this->handle_regs_read();
+
+    case 'G':
+      return this->handle_regs_write(packet);
+
+    case 'p':
+      return this->handle_reg_read(packet);
+
+    case 'P':
+      return this->handle_reg_write(packet);
+
+    case 'm':
+      return this->handle_mem_read(packet);
+
+    case 'M':
+      return this->handle_mem_write(packet, false);
+
+    case 'X':
+      return this->handle_mem_write(packet, true);
+
+    case 'Z':
+      return this->handle_breakpoint(packet, true);
+
+    case 'z':
+      return this->handle_breakpoint(packet, false);
+
+    case 'c':
+    case 's': {
+      // Resuming at a specific address is not supported, GDB writes the PC
+      // instead
+      if (packet.size() > 1)
+        return this->send_packet("E01");
+      return this->resume(packet[0] == 's' ? this->current_core : NULL);
+    }
+
+    case 'v':
+      if (packet.compare(0, 5, "vCont") == 0)
+        return this->handle_vcont(packet);
+      return this->send_packet("");
+
+    case 'D': {
+      // Let the cores run without debugger
+      this->send_packet("OK");
+      vp::time_engine *engine = this->get_time_engine();
+      engine->lock();
+      for (auto core: this->cores)
+      {
+        core->gdbserver_cont();
+      }
+      engine->unlock();
+      return false;
+    }
+
+    case 'k':
+      this->get_time_engine()->stop_engine(true);
+      return false;
+
+    default:
+      return this->send_packet("");
+  }
+}
+
+
+
+void gdb_server::client_routine()
+{
+  this->no_ack = false;
+  this->in_buffer_index = 0;
+  this->in_buffer_size = 0;
+
+  // Nothing can be debugged without any core, the connection is closed
+  if (this->cores.size() == 0)
+  {
+    fprintf(stderr, "GDB server: no core registered, closing connection\n");
+    return;
+  }
+
+  // GDB expects the target to be stopped when it connects
+  vp::time_engine *engine = this->get_time_engine();
+  engine->lock();
+  this->stop_all();
+  engine->unlock();
+
+  this->current_core = this->cores[0];
+
+  std::string packet;
+  while (this->get_packet(packet))
+  {
+    if (!this->handle_packet(packet))
+      break;
+  }
+
+  bool finished;
+  {
+    std::unique_lock<std::mutex> lock(this->mutex);
+    finished = this->finished && !this->exit_sent;
+  }
+
+  if (finished)
+    this->send_exit_reply();
+}
+
+int gdb_server::open_socket()
+{
+  if (this->socket_path != "")
+  {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, this->socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(this->socket_path.c_str());
+
+    this->socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (this->socket_fd < 0 || bind(this->socket_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      return -1;
+  }
+  else
+  {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(this->port);
+
+    this->socket_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (this->socket_fd < 0)
+      return -1;
+
+    int one = 1;
+    setsockopt(this->socket_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(this->socket_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+      return -1;
+  }
+
+  if (listen(this->socket_fd, 1) < 0)
+    return -1;
+
+  return 0;
+}
+
+void gdb_server::server_routine()
+{
+  this->get_time_engine()->wait_running();
+
+  while (1)
+  {
+    this->client_fd = accept(this->socket_fd, NULL, NULL);
+    if (this->client_fd < 0)
+    {
+      // The server is not clocked, the component warnings can not be used
+      fprintf(stderr, "GDB server: failed to accept connection: %s\n", strerror(errno));
+      return;
+    }
+
+    if (this->socket_path == "")
+    {
+      int one = 1;
+      setsockopt(this->client_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+
+    this->trace.msg("GDB connected\n");
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->connected = true;
+    }
+
+    this->client_routine();
+
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->connected = false;
+      this->exit_cond.notify_all();
+    }
+
+    close(this->client_fd);
+
+    this->trace.msg("GDB disconnected\n");
+  }
+}
+
+
+
+int gdb_server::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  js::config *port_conf = this->get_js_config()->get("port");
+  this->port = port_conf ? port_conf->get_int() : 1234;
+
+  js::config *socket_conf = this->get_js_config()->get("socket");
+  this->socket_path = socket_conf ? socket_conf->get_str() : "";
+
+  this->waiting_stop = false;
+  this->stopped_core = NULL;
+  this->current_core = NULL;
+  this->connected = false;
+  this->finished = false;
+  this->exit_sent = false;
+  this->exit_status = 0;
+
+  if (pipe(this->wakeup_fds))
+  {
+    snprintf(vp_error, VP_ERROR_SIZE, "Failed to create pipe: %s", strerror(errno));
+    return -1;
+  }
+
+  if (this->open_socket())
+  {
+    snprintf(vp_error, VP_ERROR_SIZE, "Failed to open GDB server socket: %s", strerror(errno));
+    return -1;
+  }
+
+  new_service("gdbserver", static_cast<vp::gdbserver_engine *>(this));
+
+  return 0;
+}
+
+void gdb_server::start()
+{
+  if (this->socket_path != "")
+    printf("GDB server listening on %s\n", this->socket_path.c_str());
+  else
+    printf("GDB server listening on port %d\n", this->port);
+
+  new std::thread(&gdb_server::server_routine, this);
+}
+
+void gdb_server::stop()
+{
+  std::unique_lock<std::mutex> lock(this->mutex);
+
+  this->finished = true;
+  this->exit_status = this->get_time_engine()->run_status();
+
+  char c = 0;
+  if (write(this->wakeup_fds[1], &c, 1) != 1) {}
+
+  // Give some time to the server to send the exit status before the
+  // simulation exits
+  this->exit_cond.wait_for(lock, std::chrono::seconds(1), [this]() { return this->exit_sent || !this->connected; });
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new gdb_server(config);
+}
@@ -25,6 +25,8 @@
 
 #define ENQUEUE_ITER 100000000
 #define CALL_ITER 100000000
+#define FAR_ENQUEUE_ITER 10000000
+#define CANCEL_ITER 10000000
 
 class master : public vp::component
 {
@@ -43,6 +45,9 @@ public:
   static void test_enqueue_10(void *_this, vp::clock_event *event);
   static void test_enqueue_100(void *_this, vp::clock_event *event);
   static void test_enqueue_var(void *_this, vp::clock_event *event);
+  static void test_enqueue_far(void *_this, vp::clock_event *event);
+  static void test_cancel(void *_this, vp::clock_event *event);
+  static void test_cancel_timeout(void *_this, vp::clock_event *event);
   static void test_call(void *_this, vp::clock_event *event);
   static void test_call_sync(void *_this, vp::clock_event *event);
 
@@ -58,6 +63,9 @@ private:
   vp::io_master out;
   int step;
   int delay;
+  int far_nb_events;
+  int far_count;
+  clock_t far_start;
 };
 
 void master::test_enqueue_1(void *__this, vp::clock_event *event)
@@ -224,6 +232,72 @@ void master::test_enqueue_var(void *__this, vp::clock_event *event)
   }
 }
 
+// Several events are reenqueued with a delay which does not fit the circular
+// buffer of the clock engine, so that they go through the upper levels of the
+// timing wheel.
+void master::test_enqueue_far(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  if (_this->far_count == 0)
+  {
+    _this->far_start = ::clock();
+  }
+
+  _this->far_count++;
+
+  if (_this->far_count == FAR_ENQUEUE_ITER)
+  {
+     clock_t end = ::clock();
+     double time_elapsed_in_seconds = (end - _this->far_start)/(double)CLOCKS_PER_SEC;
+     printf("%f\n", FAR_ENQUEUE_ITER / time_elapsed_in_seconds / 1000000);
+    _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+  }
+  else if (_this->far_count <= FAR_ENQUEUE_ITER - _this->far_nb_events)
+  {
+    _this->event_enqueue(event, _this->delay);
+  }
+}
+
+// Each event has a timeout event, which is canceled and reenqueued further
+// every time the event is executed, like a watchdog which never expires.
+void master::test_cancel(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+  vp::clock_event *timeout = (vp::clock_event *)event->get_args()[0];
+
+  if (_this->far_count == 0)
+  {
+    _this->far_start = ::clock();
+  }
+
+  _this->far_count++;
+
+  if (timeout->is_enqueued())
+  {
+    _this->event_cancel(timeout);
+  }
+
+  if (_this->far_count == CANCEL_ITER)
+  {
+     clock_t end = ::clock();
+     double time_elapsed_in_seconds = (end - _this->far_start)/(double)CLOCKS_PER_SEC;
+     printf("%f\n", CANCEL_ITER / time_elapsed_in_seconds / 1000000);
+    _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
+  }
+  else if (_this->far_count <= CANCEL_ITER - _this->far_nb_events)
+  {
+    _this->event_enqueue(timeout, _this->delay * 2);
+    _this->event_enqueue(event, _this->delay);
+  }
+}
+
+void master::test_cancel_timeout(void *__this, vp::clock_event *event)
+{
+  printf("Cancel benchmark timeout event was executed\n");
+  exit(1);
+}
+
 void master::test_call(void *__this, vp::clock_event *event)
 {
   master *_this = (master *)__this;
@@ -259,6 +333,7 @@ void master::test_call_sync(void *__this, vp::clock_event *event)
   clock_t end = ::clock();
   double time_elapsed_in_seconds = (end - start)/(double)CLOCKS_PER_SEC;
   printf("%f\n", CALL_ITER / time_elapsed_in_seconds / 1000000);
+  printf("Request pool hit rate: %f\n", (double)_this->out.get_nb_req_pool_hit() / _this->out.get_nb_req_new());
   _this->event_enqueue(_this->event_new((vp::clock_event_meth_t *)master::test), 1);
 }
 
@@ -313,6 +388,58 @@ void master::test(void *__this, vp::clock_event *event)
       _this->event = _this->event_new(master::test_call_sync);
       _this->event_enqueue(_this->event, 1);
       break;
+    case 8:
+    case 9:
+    case 10:
+    case 11:
+      if (_this->step == 8)
+      {
+        _this->delay = 100;
+        _this->far_nb_events = 1;
+      }
+      else if (_this->step == 9)
+      {
+        _this->delay = 1000;
+        _this->far_nb_events = 16;
+      }
+      else if (_this->step == 10)
+      {
+        _this->delay = 1000;
+        _this->far_nb_events = 64;
+      }
+      else
+      {
+        _this->delay = 100000;
+        _this->far_nb_events = 1024;
+      }
+      printf("Benchmarking event enqueue with %d cycle constant with %d events\n", _this->delay, _this->far_nb_events);
+      _this->far_count = 0;
+      for (int i=0; i<_this->far_nb_events; i++)
+      {
+        _this->event_enqueue(_this->event_new(master::test_enqueue_far), 1 + i * _this->delay / _this->far_nb_events);
+      }
+      break;
+    case 12:
+    case 13:
+      if (_this->step == 12)
+      {
+        _this->delay = 10;
+        _this->far_nb_events = 1;
+      }
+      else
+      {
+        _this->delay = 1000;
+        _this->far_nb_events = 64;
+      }
+      printf("Benchmarking event cancel with %d cycle constant with %d events\n", _this->delay, _this->far_nb_events);
+      _this->far_count = 0;
+      for (int i=0; i<_this->far_nb_events; i++)
+      {
+        vp::clock_event *event = _this->event_new(master::test_cancel);
+        event->get_args()[0] = _this->event_new(master::test_cancel_timeout);
+        _this->event_enqueue(event, 1 + i * _this->delay / _this->far_nb_events);
+      }
+      break;
     default:
       exit(0);
   }
@@ -44,6 +44,7 @@ private:
 vp::io_req_status_e slave::req(void *__this, vp::io_req *req)
 {
   //resp_port->resp(req);
+  return vp::IO_REQ_OK;
 }
 
 int slave::build()
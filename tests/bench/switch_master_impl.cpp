@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+#include <vp/vp.hpp>
+#include <stdio.h>
+#include <time.h>
+
+#define SWITCH_ITER 20000000
+
+// Each instance of this component sits in its own clock domain and executes
+// one event per cycle. As all domains have different frequencies, the time
+// engine has to switch to another clock engine nearly at every event, which
+// gives the cost of a switch when the number of domains grows.
+
+class switch_master : public vp::component
+{
+
+public:
+
+  switch_master(const char *config);
+
+  int build();
+
+  void start();
+
+  static void handler(void *_this, vp::clock_event *event);
+
+private:
+
+  vp::clock_event *event;
+};
+
+static int nb_switches = 0;
+static clock_t start_time;
+
+void switch_master::handler(void *__this, vp::clock_event *event)
+{
+  switch_master *_this = (switch_master *)__this;
+
+  if (nb_switches == 0)
+  {
+    start_time = ::clock();
+  }
+
+  nb_switches++;
+
+  if (nb_switches == SWITCH_ITER)
+  {
+    clock_t end = ::clock();
+    double time_elapsed_in_seconds = (end - start_time)/(double)CLOCKS_PER_SEC;
+    printf("Benchmarking engine switch with %d domains (scheduler: %s)\n",
+      _this->get_config_int("nb_domains"),
+      _this->get_time_engine()->get_scheduler() == vp::TIME_ENGINE_SCHEDULER_HEAP ? "heap" : "list");
+    printf("%f\n", time_elapsed_in_seconds / SWITCH_ITER * 1000000000);
+    exit(0);
+  }
+
+  _this->event_enqueue(_this->event, 1);
+}
+
+int switch_master::build()
+{
+  this->event = this->event_new(switch_master::handler);
+  return 0;
+}
+
+void switch_master::start()
+{
+  this->event_enqueue(this->event, 1);
+}
+
+switch_master::switch_master(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new switch_master(config);
+}
@@ -0,0 +1,37 @@
+#
+# Copyright (C) 2018 ETH Zurich and University of Bologna
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ 
+import vp_core as vp
+import json_tools as js
+
+class component(vp.component):
+
+    def build(self):
+
+        nb_domains = self.get_config().get_int('nb_domains')
+        frequency = self.get_config().get_int('clock_domain/frequency')
+
+        for i in range(0, nb_domains):
+
+            # Use slightly different frequencies so that the domains never
+            # execute at the same time.
+            clock = self.new('clock%d' % i, component='vp/clock_domain', config=js.import_config({'frequency': frequency + i * 1000}))
+
+            master = self.new('master%d' % i, component='switch_master', config=self.get_config())
+
+            clock.get_port('out').bind_to(master.get_port('clock'))
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// This model sends a single request to a slave in another clock domain,
+// at a cycle where the slave engine is idle, waiting for a far event.
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+
+
+class master : public vp::component
+{
+
+public:
+
+  master(const char *config);
+
+  int build();
+  void start();
+
+  static void send_req(void *__this, vp::clock_event *event);
+
+private:
+
+  vp::io_master out;
+  vp::trace     trace;
+
+  int req_cycle = 3000;  // Cycle at which the request is sent
+};
+
+void master::send_req(void *__this, vp::clock_event *event)
+{
+  master *_this = (master *)__this;
+
+  _this->trace.msg("Sending request (cycle: %ld, time: %ld)\n", _this->get_cycles(), _this->get_time());
+
+  vp::io_req *req = _this->out.req_new(0, NULL, 4, 1);
+  _this->out.req(req);
+  _this->out.req_del(req);
+}
+
+int master::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  new_master_port("out", &out);
+
+  req_cycle = get_config_int("req_cycle");
+
+  return 0;
+}
+
+void master::start()
+{
+  event_enqueue(event_new(master::send_req), req_cycle);
+}
+
+master::master(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new master(config);
+}
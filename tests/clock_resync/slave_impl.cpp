@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// This model checks that an event enqueued while its clock engine is idle,
+// from a request coming from another clock domain, is executed at its cycle.
+// The engine is only waiting for a far timeout event when the request is
+// received. The simulation stops with status 0 if the event is executed at
+// the expected time, or 1 otherwise.
+
+#include <vp/vp.hpp>
+#include <vp/itf/io.hpp>
+#include <stdio.h>
+
+
+class slave : public vp::component
+{
+
+public:
+
+  slave(const char *config);
+
+  int build();
+  void start();
+
+  static vp::io_req_status_e req(void *__this, vp::io_req *req);
+
+  static void check(void *__this, vp::clock_event *event);
+
+  static void timeout(void *__this, vp::clock_event *event);
+
+private:
+
+  vp::io_slave in;
+  vp::trace    trace;
+
+  vp::clock_event *check_event;
+  vp::clock_event *timeout_event;
+
+  int timeout_cycles = 1000;  // Cycle of the timeout event
+  int delay = 2;              // Delay of the event enqueued by the request
+
+  int64_t expected_cycle;
+};
+
+vp::io_req_status_e slave::req(void *__this, vp::io_req *req)
+{
+  slave *_this = (slave *)__this;
+
+  // The port synchronized the engine cycle count with the master time
+  _this->expected_cycle = _this->get_cycles() + _this->delay;
+
+  _this->trace.msg("Received request (cycle: %ld, time: %ld)\n", _this->get_cycles(), _this->get_time());
+
+  _this->event_enqueue(_this->check_event, _this->delay);
+
+  return vp::IO_REQ_OK;
+}
+
+void slave::check(void *__this, vp::clock_event *event)
+{
+  slave *_this = (slave *)__this;
+
+  int64_t cycle = _this->get_cycles();
+  int64_t time = _this->get_time();
+
+  _this->trace.msg("Executing event (cycle: %ld, time: %ld)\n", cycle, time);
+
+  _this->event_cancel(_this->timeout_event);
+
+  // The engine started at time 0, the time of each cycle is given by the
+  // period.
+  if (cycle != _this->expected_cycle || time != _this->expected_cycle * _this->get_period())
+  {
+    printf("Event executed at wrong time (cycle: %ld, time: %ld, expected cycle: %ld, expected time: %ld)\n",
+      cycle, time, _this->expected_cycle, _this->expected_cycle * _this->get_period());
+    _this->clock->stop_engine(1);
+    return;
+  }
+
+  _this->clock->stop_engine(0);
+}
+
+void slave::timeout(void *__this, vp::clock_event *event)
+{
+  slave *_this = (slave *)__this;
+
+  printf("No request received before timeout\n");
+  _this->clock->stop_engine(1);
+}
+
+int slave::build()
+{
+  traces.new_trace("trace", &trace, vp::DEBUG);
+
+  in.set_req_meth(&slave::req);
+
+  new_slave_port("in", &in);
+
+  check_event = event_new(slave::check);
+  timeout_event = event_new(slave::timeout);
+
+  timeout_cycles = get_config_int("timeout");
+  delay = get_config_int("delay");
+
+  return 0;
+}
+
+void slave::start()
+{
+  event_enqueue(timeout_event, timeout_cycles);
+}
+
+slave::slave(const char *config)
+: vp::component(config)
+{
+}
+
+extern "C" void *vp_constructor(const char *config)
+{
+  return (void *)new slave(config);
+}
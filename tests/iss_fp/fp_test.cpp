@@ -0,0 +1,506 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Randomized differential test of the native floating-point operations of
+// isa_lib/fp_native.h, checking both the result and the fflags, and
+// measurement of how many operations per second they and flexfloat can
+// execute.
+//
+// The operations are checked against flexfloat, except for the cases where
+// flexfloat is known to differ from IEEE 754:
+//   - subnormal operands and results are encoded as normal numbers, so they
+//     are not generated and such results are not compared.
+//   - underflow is raised for exact tiny results.
+//   - overflow is raised for exact infinite results.
+//   - conversions of signaling NaNs do not raise invalid.
+//   - fused multiply-adds are computed in double and rounded twice, so they
+//     are not compared.
+// All operations are also checked, with all operands, against a reference
+// computed in double and rounded in software.
+
+#include "types.hpp"
+#include "isa_lib/int.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define CHECK_ITER 2000000
+#define BENCH_ITER 20000000
+#define BENCH_SIZE 1024
+
+#define FFLAGS_NX 0x01
+#define FFLAGS_UF 0x02
+#define FFLAGS_OF 0x04
+#define FFLAGS_NV 0x10
+
+static iss_cpu_state_t state;
+static iss_cpu_state_t *s = &state;
+
+typedef uint32_t (*fp_op_t)(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m);
+typedef bool (*fp_enabled_t)(uint8_t e, uint8_t m);
+
+
+
+// flexfloat versions, with the host in round to nearest even mode
+
+#define FF_OP2(name)                                                              \
+static uint32_t ff_##name(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) \
+{                                                                                 \
+  return lib_flexfloat_##name(s, a, b, e, m);                                     \
+}
+
+FF_OP2(add)
+FF_OP2(sub)
+FF_OP2(mul)
+FF_OP2(div)
+FF_OP2(eq)
+FF_OP2(lt)
+FF_OP2(le)
+
+static uint32_t ff_sqrt(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m)
+{
+  FF_INIT_1(a, e, m)
+  feclearexcept(FE_ALL_EXCEPT);
+  ff_init_double(&ff_res, sqrt(ff_get_double(&ff_a)), env);
+  update_fflags_fenv(s);
+  return flexfloat_get_bits(&ff_res);
+}
+
+static uint32_t ff_cvt(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m)
+{
+  uint8_t es = e == 8 ? 5 : 8, ms = e == 8 ? 10 : 23;
+  FF_INIT_1(a, es, ms)
+  feclearexcept(FE_ALL_EXCEPT);
+  ff_cast(&ff_res, &ff_a, (flexfloat_desc_t){e, m});
+  update_fflags_fenv(s);
+  return flexfloat_get_bits(&ff_res);
+}
+
+
+
+// Versions computed in double and rounded in software to the target format.
+// The result of add, sub, mul, div and sqrt in double is close enough to the
+// exact one to be rounded only once. The product of a fused multiply-add is
+// exact in double, and its sum with the addend is rounded to odd, which keeps
+// the information needed to round it again. The empty asm statements keep the
+// operations after the clearing of the host exceptions.
+
+static double exact_decode(uint32_t a, uint8_t e, uint8_t m)
+{
+  int bias = (1 << (e - 1)) - 1;
+  uint32_t exp = (a >> m) & ((1 << e) - 1), frac = a & ((1 << m) - 1);
+  bool sign = (a >> (e + m)) & 1;
+
+  if (exp == (uint32_t)(1 << e) - 1)
+  {
+    if (frac == 0) return sign ? -__builtin_inf() : __builtin_inf();
+    // Keeps the NaN quiet or signaling
+    uint64_t bits = ((uint64_t)sign << 63) | (0x7ffULL << 52) | (frac & (1 << (m - 1)) ? 1ULL << 51 : 1);
+    double result;
+    memcpy(&result, &bits, 8);
+    return result;
+  }
+
+  double result = exp == 0 ? ldexp(frac, 1 - bias - m) : ldexp(frac | (1 << m), exp - bias - m);
+  return sign ? -result : result;
+}
+
+// Rounds to nearest even by scaling the value so that the unit in the last
+// place of the target format is 1
+static uint32_t exact_encode(double value, uint8_t e, uint8_t m, uint32_t *flags)
+{
+  int bias = (1 << (e - 1)) - 1;
+  uint32_t sign = (uint32_t)!!__builtin_signbit(value) << (e + m);
+  uint32_t inf = ((1 << e) - 1) << m;
+
+  if (__builtin_isnan(value)) return inf | (1 << (m - 1));
+  if (__builtin_isinf(value)) return sign | inf;
+  if (value == 0) return sign;
+
+  int exp;
+  frexp(value, &exp);
+  int ulp_exp = exp - m - 1;
+
+  // Tininess is detected after rounding, as if the exponent range was
+  // unbounded
+  bool tiny = ldexp(nearbyint(ldexp(__builtin_fabs(value), -ulp_exp)), ulp_exp) < ldexp(1, 1 - bias);
+
+  if (ulp_exp < 1 - bias - m) ulp_exp = 1 - bias - m;
+
+  double scaled = ldexp(__builtin_fabs(value), -ulp_exp);
+  double rounded = nearbyint(scaled);
+  if (rounded != scaled) *flags |= FFLAGS_NX;
+
+  uint32_t bits = (uint32_t)rounded + ((uint32_t)(ulp_exp - (1 - bias - m)) << m);
+  if (bits >= inf)
+  {
+    *flags |= FFLAGS_OF | FFLAGS_NX;
+    return sign | inf;
+  }
+  if (tiny && (*flags & FFLAGS_NX)) *flags |= FFLAGS_UF;
+
+  return sign | bits;
+}
+
+static uint32_t exact_result(double value, uint8_t e, uint8_t m)
+{
+  uint32_t flags = 0;
+  update_fflags_fenv(s);
+  flags = s->fcsr.fflags.raw;
+  uint32_t result = exact_encode(value, e, m, &flags);
+  s->fcsr.fflags.raw = flags;
+  return result;
+}
+
+#define EXACT_OP2(name, expr)                                                     \
+static uint32_t exact_##name(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) \
+{                                                                                 \
+  double da = exact_decode(a, e, m), db = exact_decode(b, e, m);                  \
+  feclearexcept(FE_ALL_EXCEPT);                                                   \
+  __asm__ volatile("" : "+x"(da), "+x"(db));                                      \
+  double result = expr;                                                           \
+  __asm__ volatile("" : "+x"(result));                                            \
+  return exact_result(result, e, m);                                              \
+}
+
+EXACT_OP2(add, da + db)
+EXACT_OP2(sub, da - db)
+EXACT_OP2(mul, da * db)
+EXACT_OP2(div, da / db)
+EXACT_OP2(sqrt, sqrt(da))
+
+static uint32_t exact_cvt(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m)
+{
+  double da = exact_decode(a, e == 8 ? 5 : 8, e == 8 ? 10 : 23);
+  feclearexcept(FE_ALL_EXCEPT);
+  // Quiets a signaling NaN and raises invalid
+  double one = 1.0;
+  __asm__ volatile("" : "+x"(da), "+x"(one));
+  double result = da * one;
+  __asm__ volatile("" : "+x"(result));
+  return exact_result(result, e, m);
+}
+
+// RISC-V raises invalid for infinity times zero even when the addend is a
+// quiet NaN
+static uint32_t exact_fma(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m, bool neg_prod, bool neg_add)
+{
+  double da = exact_decode(a, e, m), db = exact_decode(b, e, m), dc = exact_decode(c, e, m);
+  if (neg_prod) da = -da;
+  if (neg_add) dc = -dc;
+  feclearexcept(FE_ALL_EXCEPT);
+  __asm__ volatile("" : "+x"(da), "+x"(db), "+x"(dc));
+  double prod = da * db;
+  __asm__ volatile("" : "+x"(prod));
+  fesetround(FE_TOWARDZERO);
+  double result = prod + dc;
+  __asm__ volatile("" : "+x"(result));
+  fesetround(FE_TONEAREST);
+  if (fetestexcept(FE_INEXACT))
+  {
+    uint64_t bits;
+    memcpy(&bits, &result, 8);
+    bits |= 1;
+    memcpy(&result, &bits, 8);
+  }
+  if (__builtin_isnan(dc) && ((__builtin_isinf(da) && db == 0) || (da == 0 && __builtin_isinf(db))))
+    feraiseexcept(FE_INVALID);
+  return exact_result(result, e, m);
+}
+
+static uint32_t exact_madd(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return exact_fma(a, b, c, e, m, false, false); }
+static uint32_t exact_msub(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return exact_fma(a, b, c, e, m, false, true); }
+static uint32_t exact_nmsub(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return exact_fma(a, b, c, e, m, true, false); }
+static uint32_t exact_nmadd(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return exact_fma(a, b, c, e, m, true, true); }
+
+
+
+// Versions executed by the ISS, which are native when fp_native.h allows it
+
+#define NEW_OP1(name)                                                             \
+static uint32_t new_##name(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) \
+{                                                                                 \
+  return lib_flexfloat_##name##_round(s, a, e, m, 0);                             \
+}
+
+#define NEW_OP2(name)                                                             \
+static uint32_t new_##name(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) \
+{                                                                                 \
+  return lib_flexfloat_##name##_round(s, a, b, e, m, 0);                          \
+}
+
+#define NEW_OP3(name)                                                             \
+static uint32_t new_##name(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) \
+{                                                                                 \
+  return lib_flexfloat_##name##_round(s, a, b, c, e, m, 0);                       \
+}
+
+NEW_OP2(add)
+NEW_OP2(sub)
+NEW_OP2(mul)
+NEW_OP2(div)
+NEW_OP1(sqrt)
+NEW_OP3(madd)
+NEW_OP3(msub)
+NEW_OP3(nmsub)
+NEW_OP3(nmadd)
+
+static uint32_t new_eq(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return lib_flexfloat_eq(s, a, b, e, m); }
+static uint32_t new_lt(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return lib_flexfloat_lt(s, a, b, e, m); }
+static uint32_t new_le(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m) { return lib_flexfloat_le(s, a, b, e, m); }
+
+static uint32_t new_cvt(uint32_t a, uint32_t b, uint32_t c, uint8_t e, uint8_t m)
+{
+  return lib_flexfloat_cvt_ff_ff_round(s, a, e == 8 ? 5 : 8, e == 8 ? 10 : 23, e, m, 0);
+}
+
+static bool enabled(uint8_t e, uint8_t m) { return fp_native_enabled(s, e, m, 0); }
+static bool fma_enabled(uint8_t e, uint8_t m) { return fp_native_fma_enabled(s, e, m, 0); }
+static bool cvt_enabled(uint8_t e, uint8_t m) { return fp_native_enabled(s, 8, 23, 0) && fp_native_enabled(s, 5, 10, 0); }
+
+
+
+typedef struct
+{
+  const char *name;
+  fp_op_t ref;
+  fp_op_t op;
+  fp_enabled_t enabled;
+  // Exponent and mantissa width of the operands, or of the result for
+  // conversions, whose operands are in the other format
+  uint8_t e;
+  uint8_t m;
+  bool is_cvt;
+  bool is_flexfloat;
+} test_op_t;
+
+#define FF(name, e, m, enabled) { #name " flexfloat", ff_##name, new_##name, enabled, e, m, false, true }
+#define FFS(name, enabled) FF(name, 8, 23, enabled), FF(name, 5, 10, enabled)
+#define EXACT(name, e, m, enabled) { #name " exact", exact_##name, new_##name, enabled, e, m, false, false }
+#define EXACTS(name, enabled) EXACT(name, 8, 23, enabled), EXACT(name, 5, 10, enabled)
+
+static test_op_t ops[] = {
+  FFS(add, enabled), FFS(sub, enabled), FFS(mul, enabled), FFS(div, enabled), FFS(sqrt, enabled),
+  FFS(eq, enabled), FFS(lt, enabled), FFS(le, enabled),
+  { "cvt flexfloat", ff_cvt, new_cvt, cvt_enabled, 8, 23, true, true },
+  { "cvt flexfloat", ff_cvt, new_cvt, cvt_enabled, 5, 10, true, true },
+  EXACTS(add, enabled), EXACTS(sub, enabled), EXACTS(mul, enabled), EXACTS(div, enabled),
+  EXACTS(sqrt, enabled), EXACT(madd, 8, 23, fma_enabled), EXACT(msub, 8, 23, fma_enabled),
+  EXACT(nmsub, 8, 23, fma_enabled), EXACT(nmadd, 8, 23, fma_enabled),
+  { "cvt exact", exact_cvt, new_cvt, cvt_enabled, 8, 23, true, false },
+  { "cvt exact", exact_cvt, new_cvt, cvt_enabled, 5, 10, true, false },
+};
+
+static uint32_t rand_next(uint32_t *seed)
+{
+  *seed = *seed * 1103515245 + 12345;
+  return *seed ^ (*seed >> 16) * 0x45d9f3b;
+}
+
+// Zeros, infinities, NaNs, subnormals and values at the boundaries of the
+// exponent range are picked more often than uniform random values would do,
+// as well as values close to 1 with few mantissa bits, which give exact
+// results and ties
+static uint32_t rand_value(uint32_t *seed, uint8_t e, uint8_t m, bool subnormals=true)
+{
+  uint32_t sign = (rand_next(seed) & 1) << (e + m);
+  uint32_t exp_max = (1 << e) - 1;
+  uint32_t frac = rand_next(seed) & ((1 << m) - 1);
+  uint32_t exp = rand_next(seed) & exp_max;
+
+  switch (rand_next(seed) % 10)
+  {
+    case 0: exp = 0; frac = 0; break;
+    case 1: exp = exp_max; frac = 0; break;
+    case 2: exp = exp_max; frac |= 1 << (m - 1); break;
+    case 3: exp = exp_max; frac = (frac & ~(1 << (m - 1))) | 1; break;
+    case 4: exp = 0; break;
+    case 5: exp = exp_max - 1 - (rand_next(seed) & 1); break;
+    case 6: exp = 1 + (rand_next(seed) & 1); break;
+    case 7: exp = (exp_max >> 1) + (rand_next(seed) % 9) - 4; frac &= ~((1 << (m - 4)) - 1); break;
+    case 8: exp = (exp_max >> 1) + (rand_next(seed) % 9) - 4; break;
+  }
+
+  if (exp == 0 && !subnormals) frac = 0;
+
+  return sign | (exp << m) | frac;
+}
+
+static bool is_snan(uint32_t a, uint8_t e, uint8_t m)
+{
+  uint32_t exp_max = (1 << e) - 1;
+  return ((a >> m) & exp_max) == exp_max && (a & ((1 << m) - 1)) && !(a & (1 << (m - 1)));
+}
+
+static bool is_inf(uint32_t a, uint8_t e, uint8_t m)
+{
+  return (a & ((1 << (e + m)) - 1)) == ((uint32_t)((1 << e) - 1) << m);
+}
+
+// Removes from the flags given by flexfloat the ones that the native version
+// does not raise because flexfloat differs from IEEE 754
+static uint32_t flexfloat_flags(test_op_t *op, uint32_t a, uint32_t result, uint32_t expected_flags, uint32_t flags)
+{
+  if ((expected_flags & FFLAGS_UF) && !(flags & FFLAGS_NX))
+    expected_flags &= ~FFLAGS_UF;
+
+  if (is_inf(result, op->e, op->m) && !(flags & FFLAGS_OF))
+    expected_flags &= ~(FFLAGS_OF | FFLAGS_NX);
+
+  if (op->is_cvt && is_snan(a, op->e == 8 ? 5 : 8, op->e == 8 ? 10 : 23))
+    expected_flags |= FFLAGS_NV;
+
+  return expected_flags;
+}
+
+static int check()
+{
+  int errors = 0, nb_checked = 0;
+
+  for (unsigned int i=0; i<sizeof(ops)/sizeof(ops[0]); i++)
+  {
+    test_op_t *op = &ops[i];
+    uint8_t e = op->e, m = op->m;
+
+    if (!op->enabled(e, m))
+    {
+      printf("%s (%d, %d): not native in this build, skipped\n", op->name, e, m);
+      continue;
+    }
+
+    nb_checked++;
+
+    uint8_t es = e, ms = m;
+    if (op->is_cvt)
+    {
+      es = e == 8 ? 5 : 8;
+      ms = e == 8 ? 10 : 23;
+    }
+
+    uint32_t seed = i;
+    for (int j=0; j<CHECK_ITER; j++)
+    {
+      bool subnormals = !op->is_flexfloat;
+      uint32_t a = rand_value(&seed, es, ms, subnormals), b = rand_value(&seed, es, ms, subnormals);
+      uint32_t c = rand_value(&seed, es, ms, subnormals);
+
+      s->fcsr.fflags.raw = 0;
+      uint32_t expected = op->ref(a, b, c, e, m);
+      uint32_t expected_flags = s->fcsr.fflags.raw;
+
+      s->fcsr.fflags.raw = 0;
+      uint32_t result = op->op(a, b, c, e, m);
+      uint32_t flags = s->fcsr.fflags.raw;
+
+      if (op->is_flexfloat)
+      {
+        if (((result >> m) & ((1 << e) - 1)) == 0 && (result & ((1 << m) - 1)) || (flags & FFLAGS_UF))
+          continue;
+        expected_flags = flexfloat_flags(op, a, result, expected_flags, flags);
+      }
+
+      if (expected != result || expected_flags != flags)
+      {
+        printf("%s (%d, %d): mismatch (a: 0x%8.8x, b: 0x%8.8x, c: 0x%8.8x, expected: 0x%8.8x/0x%2.2x, got: 0x%8.8x/0x%2.2x)\n",
+          op->name, e, m, a, b, c, expected, expected_flags, result, flags);
+        errors++;
+        break;
+      }
+    }
+  }
+
+  printf("Checked %d operations, %d errors\n", nb_checked, errors);
+
+  return errors;
+}
+
+
+
+// Each instruction reads its operands from the register file and writes its
+// result back, so operations are independent. The flexfloat version sets the
+// host rounding mode around the operation, like the ISS does when the native
+// version cannot be used.
+#define BENCH(name, expr)                                                         \
+static double bench_##name(uint32_t *values)                                      \
+{                                                                                 \
+  uint32_t result = 0;                                                            \
+  clock_t start = clock();                                                        \
+  for (int i=0; i<BENCH_ITER; i++)                                                \
+  {                                                                               \
+    uint32_t a = values[i & (BENCH_SIZE-1)];                                      \
+    uint32_t b = values[(i + 1) & (BENCH_SIZE-1)];                                \
+    uint32_t c = values[(i + 2) & (BENCH_SIZE-1)];                                \
+    __asm__ volatile("" : "+r"(a), "+r"(b), "+r"(c));                             \
+    result ^= expr;                                                               \
+  }                                                                               \
+  double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;                    \
+  values[0] ^= result & 1;                                                        \
+  return BENCH_ITER / elapsed / 1000000;                                          \
+}
+
+#define BENCH_REF(name, call)                                                     \
+BENCH(ref_##name, ({ int old = setFFRoundingMode(s, 0); uint32_t r = call; restoreFFRoundingMode(old); r; }))
+
+BENCH_REF(fadd_s, lib_flexfloat_add(s, a, b, 8, 23))
+BENCH(new_fadd_s, lib_flexfloat_add_round(s, a, b, 8, 23, 0))
+BENCH_REF(fmul_s, lib_flexfloat_mul(s, a, b, 8, 23))
+BENCH(new_fmul_s, lib_flexfloat_mul_round(s, a, b, 8, 23, 0))
+BENCH_REF(fdiv_s, lib_flexfloat_div(s, a, b, 8, 23))
+BENCH(new_fdiv_s, lib_flexfloat_div_round(s, a, b, 8, 23, 0))
+BENCH_REF(fmadd_s, lib_flexfloat_madd(s, a, b, c, 8, 23))
+BENCH(new_fmadd_s, lib_flexfloat_madd_round(s, a, b, c, 8, 23, 0))
+BENCH_REF(fadd_h, lib_flexfloat_add(s, a, b, 5, 10))
+BENCH(new_fadd_h, lib_flexfloat_add_round(s, a, b, 5, 10, 0))
+BENCH_REF(fmul_h, lib_flexfloat_mul(s, a, b, 5, 10))
+BENCH(new_fmul_h, lib_flexfloat_mul_round(s, a, b, 5, 10, 0))
+
+static void bench()
+{
+  static uint32_t values_s[BENCH_SIZE], values_h[BENCH_SIZE];
+  uint32_t seed = 0;
+  for (int i=0; i<BENCH_SIZE; i++)
+  {
+    values_s[i] = rand_value(&seed, 8, 23);
+    values_h[i] = rand_value(&seed, 5, 10);
+  }
+
+  printf("Mega-instructions per second (flexfloat / native)\n");
+  printf("fadd.s        %10.2f %10.2f\n", bench_ref_fadd_s(values_s), bench_new_fadd_s(values_s));
+  printf("fmul.s        %10.2f %10.2f\n", bench_ref_fmul_s(values_s), bench_new_fmul_s(values_s));
+  printf("fdiv.s        %10.2f %10.2f\n", bench_ref_fdiv_s(values_s), bench_new_fdiv_s(values_s));
+  printf("fmadd.s       %10.2f %10.2f\n", bench_ref_fmadd_s(values_s), bench_new_fmadd_s(values_s));
+  printf("fadd.h        %10.2f %10.2f\n", bench_ref_fadd_h(values_h), bench_new_fadd_h(values_h));
+  printf("fmul.h        %10.2f %10.2f\n", bench_ref_fmul_h(values_h), bench_new_fmul_h(values_h));
+}
+
+
+
+int main(int argc, char **argv)
+{
+  memset(&state, 0, sizeof(state));
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0)
+  {
+    bench();
+    return 0;
+  }
+
+  return check() != 0;
+}
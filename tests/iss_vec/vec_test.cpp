@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2018 ETH Zurich and University of Bologna
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Authors: Germain Haugou, ETH (germain.haugou@iis.ee.ethz.ch)
+ */
+
+// Checks that the lane operations of isa_lib/vec.h used by the PULP v2
+// packed-SIMD instructions are bit-exact with the scalar versions of
+// isa_lib/int.h, and measures how many instructions per second both can
+// execute.
+
+#include "types.hpp"
+#include "isa_lib/int.h"
+#include "isa_lib/vec.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define CHECK_ITER 2000000
+#define BENCH_ITER 50000000
+#define BENCH_SIZE 1024
+
+static iss_cpu_state_t state;
+static iss_cpu_state_t *s = &state;
+
+typedef uint32_t (*vec_op2_t)(uint32_t a, uint32_t b);
+typedef uint32_t (*vec_op3_t)(uint32_t a, uint32_t b, uint32_t c);
+
+#define REF_OP(name, type, elemType, scalar)                                      \
+static uint32_t ref_##name(uint32_t a, uint32_t b) {                              \
+  return lib_VEC_##scalar##_##elemType##_to_##type(s, a, b);                      \
+}                                                                                 \
+static uint32_t ref_##name##_sc(uint32_t a, uint32_t b) {                         \
+  return lib_VEC_##scalar##_SC_##elemType##_to_##type(s, a, b);                   \
+}
+
+#define REF_OPS(name, scalar)                                                     \
+REF_OP(name##_8, int32_t, int8_t, scalar)                                         \
+REF_OP(name##_16, int32_t, int16_t, scalar)
+
+#define REF_OPSU(name, scalar)                                                    \
+REF_OP(name##_8, uint32_t, uint8_t, scalar)                                       \
+REF_OP(name##_16, uint32_t, uint16_t, scalar)
+
+#define REF_DOT(name, scalar)                                                     \
+static uint32_t ref_##name##_8(uint32_t a, uint32_t b) { return lib_VEC_##scalar##_8(s, a, b); }         \
+static uint32_t ref_##name##_16(uint32_t a, uint32_t b) { return lib_VEC_##scalar##_16(s, a, b); }       \
+static uint32_t ref_##name##_8_sc(uint32_t a, uint32_t b) { return lib_VEC_##scalar##_SC_8(s, a, b); }   \
+static uint32_t ref_##name##_16_sc(uint32_t a, uint32_t b) { return lib_VEC_##scalar##_SC_16(s, a, b); } \
+static uint32_t ref_s##name##_8(uint32_t c, uint32_t a, uint32_t b) { return lib_VEC_S##scalar##_8(s, c, a, b); }   \
+static uint32_t ref_s##name##_16(uint32_t c, uint32_t a, uint32_t b) { return lib_VEC_S##scalar##_16(s, c, a, b); }
+
+REF_OPS(add, ADD)
+REF_OPS(sub, SUB)
+REF_OPS(avg, AVG)
+REF_OPSU(avgu, AVGU)
+REF_OPS(min, MIN)
+REF_OPSU(minu, MINU)
+REF_OPS(max, MAX)
+REF_OPSU(maxu, MAXU)
+REF_OPSU(srl, SRL)
+REF_OPS(sra, SRA)
+REF_OPSU(sll, SLL)
+REF_OPS(cmpeq, CMPEQ)
+REF_OPS(cmpne, CMPNE)
+REF_OPS(cmpgt, CMPGT)
+REF_OPS(cmpge, CMPGE)
+REF_OPS(cmplt, CMPLT)
+REF_OPS(cmple, CMPLE)
+REF_OPSU(cmpgtu, CMPGTU)
+REF_OPSU(cmpgeu, CMPGEU)
+REF_OPSU(cmpltu, CMPLTU)
+REF_OPSU(cmpleu, CMPLEU)
+
+REF_DOT(dotsp, DOTSP)
+REF_DOT(dotup, DOTUP)
+REF_DOT(dotusp, DOTUSP)
+
+static uint32_t ref_and_8(uint32_t a, uint32_t b) { return lib_VEC_AND_int8_t_to_int32_t(s, a, b); }
+static uint32_t ref_or_16(uint32_t a, uint32_t b) { return lib_VEC_OR_int16_t_to_int32_t(s, a, b); }
+static uint32_t ref_xor_8(uint32_t a, uint32_t b) { return lib_VEC_XOR_int8_t_to_int32_t(s, a, b); }
+static uint32_t ref_abs_8(uint32_t a, uint32_t b) { return lib_VEC_ABS_int8_t_to_int32_t(s, a); }
+static uint32_t ref_abs_16(uint32_t a, uint32_t b) { return lib_VEC_ABS_int16_t_to_int32_t(s, a); }
+static uint32_t ref_avg4_8(uint32_t a, uint32_t b) { return lib_VEC_ADD_int8_t_to_int32_t_div4(s, a, b); }
+static uint32_t ref_avg4_16(uint32_t a, uint32_t b) { return lib_VEC_ADD_int16_t_to_int32_t_div4(s, a, b); }
+static uint32_t ref_subavg_8(uint32_t a, uint32_t b) { return lib_VEC_SUB_int8_t_to_int32_t_div2(s, a, b); }
+static uint32_t ref_subavg_16(uint32_t a, uint32_t b) { return lib_VEC_SUB_int16_t_to_int32_t_div2(s, a, b); }
+static uint32_t ref_subavg4_8(uint32_t a, uint32_t b) { return lib_VEC_SUB_int8_t_to_int32_t_div4(s, a, b); }
+static uint32_t ref_subavg4_16(uint32_t a, uint32_t b) { return lib_VEC_SUB_int16_t_to_int32_t_div4(s, a, b); }
+static uint32_t ref_shuffle_8(uint32_t a, uint32_t b) { return lib_VEC_SHUFFLE_8(s, a, b); }
+static uint32_t ref_shuffle_16(uint32_t a, uint32_t b) { return lib_VEC_SHUFFLE_16(s, a, b); }
+
+// The .sc variants of the ISS are executed as the vector operation on the
+// replicated scalar
+#define NEW_OP(name, size)                                                        \
+static uint32_t new_##name##_##size(uint32_t a, uint32_t b) { return vec_##name##_##size(a, b); }
+
+#define NEW_OP_SC(name, size)                                                     \
+NEW_OP(name, size)                                                                \
+static uint32_t new_##name##_##size##_sc(uint32_t a, uint32_t b) { return vec_##name##_##size(a, vec_splat_##size(b)); }
+
+#define NEW_OPS(name) NEW_OP_SC(name, 8) NEW_OP_SC(name, 16)
+
+NEW_OPS(add) NEW_OPS(sub) NEW_OPS(avg) NEW_OPS(avgu) NEW_OPS(min) NEW_OPS(minu) NEW_OPS(max) NEW_OPS(maxu)
+NEW_OPS(srl) NEW_OPS(sra) NEW_OPS(sll) NEW_OPS(cmpeq) NEW_OPS(cmpne) NEW_OPS(cmpgt) NEW_OPS(cmpge)
+NEW_OPS(cmplt) NEW_OPS(cmple) NEW_OPS(cmpgtu) NEW_OPS(cmpgeu) NEW_OPS(cmpltu) NEW_OPS(cmpleu)
+NEW_OPS(dotsp) NEW_OPS(dotup) NEW_OPS(dotusp)
+NEW_OP(avg4, 8) NEW_OP(avg4, 16) NEW_OP(subavg, 8) NEW_OP(subavg, 16) NEW_OP(subavg4, 8) NEW_OP(subavg4, 16)
+NEW_OP(shuffle, 8) NEW_OP(shuffle, 16) NEW_OP(and, 8) NEW_OP(or, 16) NEW_OP(xor, 8)
+
+static uint32_t new_abs_8(uint32_t a, uint32_t b) { return vec_abs_8(a); }
+static uint32_t new_abs_16(uint32_t a, uint32_t b) { return vec_abs_16(a); }
+static uint32_t new_sdotsp_8(uint32_t c, uint32_t a, uint32_t b) { return vec_sdotsp_8(c, a, b); }
+static uint32_t new_sdotsp_16(uint32_t c, uint32_t a, uint32_t b) { return vec_sdotsp_16(c, a, b); }
+static uint32_t new_sdotup_8(uint32_t c, uint32_t a, uint32_t b) { return vec_sdotup_8(c, a, b); }
+static uint32_t new_sdotup_16(uint32_t c, uint32_t a, uint32_t b) { return vec_sdotup_16(c, a, b); }
+static uint32_t new_sdotusp_8(uint32_t c, uint32_t a, uint32_t b) { return vec_sdotusp_8(c, a, b); }
+static uint32_t new_sdotusp_16(uint32_t c, uint32_t a, uint32_t b) { return vec_sdotusp_16(c, a, b); }
+
+typedef struct
+{
+  const char *name;
+  vec_op2_t ref;
+  vec_op2_t op;
+} test_op2_t;
+
+typedef struct
+{
+  const char *name;
+  vec_op3_t ref;
+  vec_op3_t op;
+} test_op3_t;
+
+#define OP(name) { #name, ref_##name, new_##name }
+#define OP_SC(name) OP(name), { #name ".sc", ref_##name##_sc, new_##name##_sc }
+#define OPS(name) OP_SC(name##_8), OP_SC(name##_16)
+
+static test_op2_t ops2[] = {
+  OPS(add), OPS(sub), OPS(avg), OPS(avgu), OPS(min), OPS(minu), OPS(max), OPS(maxu),
+  OPS(srl), OPS(sra), OPS(sll), OPS(cmpeq), OPS(cmpne), OPS(cmpgt), OPS(cmpge),
+  OPS(cmplt), OPS(cmple), OPS(cmpgtu), OPS(cmpgeu), OPS(cmpltu), OPS(cmpleu),
+  OPS(dotsp), OPS(dotup), OPS(dotusp),
+  OP(and_8), OP(or_16), OP(xor_8), OP(abs_8), OP(abs_16), OP(avg4_8), OP(avg4_16),
+  OP(subavg_8), OP(subavg_16), OP(subavg4_8), OP(subavg4_16), OP(shuffle_8), OP(shuffle_16),
+};
+
+static test_op3_t ops3[] = {
+  OP(sdotsp_8), OP(sdotsp_16), OP(sdotup_8), OP(sdotup_16), OP(sdotusp_8), OP(sdotusp_16),
+};
+
+// Lane values around the sign and overflow boundaries are picked more often
+// than uniform random values would do
+static uint32_t rand_value(uint32_t *seed)
+{
+  static const uint8_t special[] = { 0x00, 0x01, 0x7f, 0x80, 0x81, 0xff, 0xfe, 0x40 };
+
+  *seed = *seed * 1103515245 + 12345;
+  uint32_t value = *seed ^ (*seed >> 16) * 0x45d9f3b;
+  for (int i=0; i<4; i++)
+  {
+    *seed = *seed * 1103515245 + 12345;
+    if (((*seed >> 16) & 3) == 0)
+    {
+      uint32_t byte = special[(*seed >> 20) & 7];
+      value = (value & ~(0xff << (i*8))) | (byte << (i*8));
+    }
+  }
+  return value;
+}
+
+static int check()
+{
+  int errors = 0;
+
+  for (unsigned int i=0; i<sizeof(ops2)/sizeof(ops2[0]); i++)
+  {
+    uint32_t seed = i;
+    for (int j=0; j<CHECK_ITER; j++)
+    {
+      uint32_t a = rand_value(&seed), b = rand_value(&seed);
+      uint32_t expected = ops2[i].ref(a, b), result = ops2[i].op(a, b);
+      if (expected != result)
+      {
+        printf("%s: mismatch (a: 0x%8.8x, b: 0x%8.8x, expected: 0x%8.8x, got: 0x%8.8x)\n", ops2[i].name, a, b, expected, result);
+        errors++;
+        break;
+      }
+    }
+  }
+
+  for (unsigned int i=0; i<sizeof(ops3)/sizeof(ops3[0]); i++)
+  {
+    uint32_t seed = i;
+    for (int j=0; j<CHECK_ITER; j++)
+    {
+      uint32_t a = rand_value(&seed), b = rand_value(&seed), c = rand_value(&seed);
+      uint32_t expected = ops3[i].ref(c, a, b), result = ops3[i].op(c, a, b);
+      if (expected != result)
+      {
+        printf("%s: mismatch (c: 0x%8.8x, a: 0x%8.8x, b: 0x%8.8x, expected: 0x%8.8x, got: 0x%8.8x)\n", ops3[i].name, c, a, b, expected, result);
+        errors++;
+        break;
+      }
+    }
+  }
+
+  printf("Checked %d operations, %d errors\n", (int)(sizeof(ops2)/sizeof(ops2[0]) + sizeof(ops3)/sizeof(ops3[0])), errors);
+
+  return errors;
+}
+
+
+
+// Each instruction reads its operands from the register file and writes its
+// result back, so operations are independent, and inlined, like in the
+// instruction handlers. Operands go through an empty asm statement so that
+// the compiler does not vectorize the loop itself.
+#define BENCH(name, expr)                                                         \
+static double bench_##name(uint32_t *values)                                      \
+{                                                                                 \
+  uint32_t result = 0;                                                            \
+  clock_t start = clock();                                                        \
+  for (int i=0; i<BENCH_ITER; i++)                                                \
+  {                                                                               \
+    uint32_t a = values[i & (BENCH_SIZE-1)];                                      \
+    uint32_t b = values[(i + 1) & (BENCH_SIZE-1)];                                \
+    __asm__ volatile("" : "+r"(a), "+r"(b));                                      \
+    result ^= expr;                                                               \
+  }                                                                               \
+  double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;                    \
+  values[0] ^= result & 1;                                                        \
+  return BENCH_ITER / elapsed / 1000000;                                          \
+}
+
+BENCH(ref_add_8, lib_VEC_ADD_int8_t_to_int32_t(s, a, b))
+BENCH(new_add_8, vec_add_8(a, b))
+BENCH(ref_max_8, lib_VEC_MAX_int8_t_to_int32_t(s, a, b))
+BENCH(new_max_8, vec_max_8(a, b))
+BENCH(ref_minu_16, lib_VEC_MINU_uint16_t_to_uint32_t(s, a, b))
+BENCH(new_minu_16, vec_minu_16(a, b))
+BENCH(ref_shuffle_8, lib_VEC_SHUFFLE_8(s, a, b))
+BENCH(new_shuffle_8, vec_shuffle_8(a, b))
+BENCH(ref_sdotsp_8, lib_VEC_SDOTSP_8(s, i, a, b))
+BENCH(new_sdotsp_8, vec_sdotsp_8(i, a, b))
+BENCH(ref_sdotsp_16, lib_VEC_SDOTSP_16(s, i, a, b))
+BENCH(new_sdotsp_16, vec_sdotsp_16(i, a, b))
+
+static void bench()
+{
+  static uint32_t values[BENCH_SIZE];
+  uint32_t seed = 0;
+  for (int i=0; i<BENCH_SIZE; i++)
+    values[i] = rand_value(&seed);
+
+  printf("Mega-instructions per second (scalar / host SIMD)\n");
+  printf("pv.add.b      %10.2f %10.2f\n", bench_ref_add_8(values), bench_new_add_8(values));
+  printf("pv.max.b      %10.2f %10.2f\n", bench_ref_max_8(values), bench_new_max_8(values));
+  printf("pv.minu.h     %10.2f %10.2f\n", bench_ref_minu_16(values), bench_new_minu_16(values));
+  printf("pv.shuffle.b  %10.2f %10.2f\n", bench_ref_shuffle_8(values), bench_new_shuffle_8(values));
+  printf("pv.sdotsp.b   %10.2f %10.2f\n", bench_ref_sdotsp_8(values), bench_new_sdotsp_8(values));
+  printf("pv.sdotsp.h   %10.2f %10.2f\n", bench_ref_sdotsp_16(values), bench_new_sdotsp_16(values));
+}
+
+
+
+int main(int argc, char **argv)
+{
+  memset(&state, 0, sizeof(state));
+
+  if (argc > 1 && strcmp(argv[1], "bench") == 0)
+  {
+    bench();
+    return 0;
+  }
+
+  return check() != 0;
+}